@@ -13,8 +13,17 @@ void addToXORList(const char* value);
 void removeFromXORList(const char* value);
 void saveUser(User* newUser);
 void saveUserData(User user);
+bool registerUser(const User* user);
+bool findUser(const char* phone, User* out);
+void clearUserTable();
+bool setPasswordHashCost(unsigned cost);
 void displayXORList();
 void printHashTable();
+bool printUsersByName(const char* field, const char* prefix, unsigned page);
+bool exportUserPage(const char* format, unsigned long long cursor, unsigned limit);
+void printUserMetrics();
+bool startUserMetricsDump(const char* path, unsigned seconds);
+void stopUserMetricsDump();
 bool authentication();
 bool Register();
 bool logIn();
@@ -34,6 +43,9 @@ void compressData();
 void decompressData();
 void saveHashTableToFile();
 void loadHashTableFromFile();
+bool importUserFile(const char* path);
+bool compactUserFile();
+bool convertUserFile();
 void clear_screen();
 void loadHashTableFromFile(void);
 void quadraticProbing();
@@ -4,10 +4,28 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <vector>
+#include <chrono>
+#include <random>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
 #include <stdbool.h>
 #include <limits.h>
 #include <stdint.h>
 #include <ctype.h>
+#include <stddef.h>
+#if defined(_WIN32) || defined(_WIN64)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <pthread.h>
+#endif
 
 /**
  * @brief Clears the console screen for better user interface experience.
@@ -43,11 +61,33 @@ void clear_screen() {
 
 
 /**
- * @brief Defines the size of a hash table.
+ * @brief Defines the initial number of slots in the user hash table.
+ *
+ * The user table grows by doubling, so this value must be a power of two.
+ */
+#define USER_TABLE_INITIAL_CAPACITY 128
+
+/**
+ * @brief Defines the maximum load factor of the user hash table, in percent.
+ *
+ * When an insertion would push the table above this load factor, the table
+ * doubles its capacity and starts an incremental rehash.
+ */
+#define USER_TABLE_MAX_LOAD_PERCENT 75
+
+/**
+ * @brief Defines how many old slots are migrated per insertion during a rehash.
  *
- * This macro specifies the number of elements that the hash table can hold.
+ * Spreading the migration over many calls keeps any single `saveUser` call from
+ * paying for a full rehash of the table. Lookups do not migrate, so they can run
+ * concurrently under a shared lock.
+ */
+#define USER_TABLE_REHASH_STEP 64
+
+/**
+ * @brief Most records with the same phone number considered by one lookup.
  */
-#define TABLE_SIZE 100
+#define USER_LOOKUP_MAX_RECORDS 8
 
  /**
   * @brief Defines the maximum number of nodes in a tree.
@@ -101,13 +141,16 @@ typedef struct MinHeap {
  * MinHeapNode pointers based on the specified capacity.
  *
  * @param capacity The maximum capacity of the Min Heap.
- * @return A pointer to the newly created MinHeap structure.
+ * @return A pointer to the newly created MinHeap structure, or NULL if memory ran out.
  *
  * @note If the specified capacity is 0 or less, the array pointer is set to nullptr.
  *       Ensure to free the allocated memory after usage.
  */
 MinHeap* createMinHeap(unsigned capacity) {
     MinHeap* minHeap = (MinHeap*)malloc(sizeof(MinHeap));
+    if (minHeap == NULL) {
+        return NULL;
+    }
     minHeap->size = 0;
     minHeap->capacity = capacity;
 
@@ -131,12 +174,15 @@ MinHeap* createMinHeap(unsigned capacity) {
  *
  * @param data The character to be stored in the node.
  * @param freq The frequency associated with the character.
- * @return A pointer to the newly created MinHeapNode.
+ * @return A pointer to the newly created MinHeapNode, or NULL if memory ran out.
  *
  * @note Ensure to free the allocated memory for the node after usage.
  */
 MinHeapNode* createMinHeapNode(char data, unsigned freq) {
     MinHeapNode* newNode = (MinHeapNode*)malloc(sizeof(MinHeapNode));
+    if (newNode == NULL) {
+        return NULL;
+    }
     newNode->data = data;
     newNode->freq = freq;
     newNode->left = newNode->right = NULL;
@@ -164,17 +210,24 @@ void insertMinHeap(MinHeap* minHeap, MinHeapNode* minHeapNode) {
  * @brief Extracts the minimum node from the Min Heap.
  *
  * This function removes the node with the smallest frequency from the Min Heap.
- * The last node in the heap is moved to the root position, and the size of the Min Heap is decremented.
+ * Since `insertMinHeap` appends without reordering, the array is scanned for
+ * the first node of smallest frequency; the last node takes its position, and
+ * the size of the Min Heap is decremented.
  *
  * @param minHeap Pointer to the MinHeap from which the minimum node will be extracted.
  * @return A pointer to the extracted MinHeapNode containing the smallest frequency.
  *
- * @note This function assumes that the Min Heap is not empty. It does not perform
- *       heapify operations, so maintaining heap properties is the caller's responsibility.
+ * @note This function assumes that the Min Heap is not empty.
  */
 MinHeapNode* extractMin(MinHeap* minHeap) {
-    MinHeapNode* temp = minHeap->array[0];
-    minHeap->array[0] = minHeap->array[minHeap->size - 1];
+    unsigned smallest = 0;
+    for (unsigned i = 1; i < minHeap->size; i++) {
+        if (minHeap->array[i]->freq < minHeap->array[smallest]->freq) {
+            smallest = i;
+        }
+    }
+    MinHeapNode* temp = minHeap->array[smallest];
+    minHeap->array[smallest] = minHeap->array[minHeap->size - 1];
     minHeap->size--;
     return temp;
 }
@@ -284,24 +337,117 @@ void progressiveOverflowAlgorithm();
  * @brief Structure to represent a user.
  *
  * This structure contains the user's details, including their name, surname,
- * phone number, password, and a pointer to the next user for resolving collisions
- * in the hash table using a linked list.
+ * phone number and password. Stored records never keep the plaintext password:
+ * when a user is added to the table, `password` is replaced by a PBKDF2-HMAC-SHA256
+ * hash with a random salt and the work factor of the time (see `hashUserPassword`).
+ * The `next` pointer is not used by the open-addressing user table.
  */
 typedef struct User {
     char name[50];               /**< User's first name. */
     char surname[50];            /**< User's last name. */
     char phone[20];              /**< User's phone number. */
-    char password[20];           /**< User's password. */
-    struct User* next;           /**< Pointer to the next user in case of collisions. */
+    char password[20];           /**< Plaintext password as entered; empty in stored records. */
+    struct User* next;           /**< Unused; kept for the users.bin record layout. */
+    uint8_t salt[16];            /**< Random salt of the password hash. */
+    uint8_t passwordHash[32];    /**< PBKDF2-HMAC-SHA256 of the password. */
+    uint32_t passwordCost;       /**< Work factor of the hash; PBKDF2 ran 2^cost iterations. */
 } User;
 
+/**
+ * @brief Record layout of users files written before passwords were hashed.
+ *
+ * Records in this layout hold plaintext passwords; they are hashed when loaded.
+ */
+typedef struct LegacyUser {
+    char name[50];               /**< User's first name. */
+    char surname[50];            /**< User's last name. */
+    char phone[20];              /**< User's phone number. */
+    char password[20];           /**< User's plaintext password. */
+    struct User* next;           /**< Unused. */
+} LegacyUser;
+
+/**
+ * @brief Fixed-width record of the user slab and of indexed users.bin files.
+ *
+ * A User spends most of its 208 bytes on unused string space and an unused
+ * pointer. A packed record keeps what a login compares and verifies in one
+ * 64-byte cache line: the phone number as its canonical integer key (see
+ * `userPhoneKey`) and the password hash with its parameters. The name, the
+ * surname and the phone number as entered, if it is not the display form of
+ * the key, are stored as varint-length strings in the name arena of the table,
+ * at offset `names`.
+ */
+typedef struct PackedUser {
+    uint64_t phone;              /**< Canonical phone number key, or USER_PHONE_SPILLED. */
+    uint32_t names;              /**< Offset of the strings of the record in the name arena. */
+    uint32_t passwordCost;       /**< Work factor of the hash; PBKDF2 ran 2^cost iterations. */
+    uint8_t salt[16];            /**< Random salt of the password hash. */
+    uint8_t passwordHash[32];    /**< PBKDF2-HMAC-SHA256 of the password. */
+} PackedUser;
+
+/**
+ * @brief Structure for one slot of the user hash table.
+ *
+ * Slots do not point at users; they hold the index of the record in the user
+ * slab together with the hash of its phone number, so a probe compares the
+ * stored hash before it touches the record and a rehash never rereads records.
+ */
+typedef struct UserSlot {
+    uint32_t hash;               /**< Hash of the phone number stored in the record. */
+    uint32_t record;             /**< Index of the record in the slab plus one; 0 marks an empty slot. */
+} UserSlot;
+
+/**
+ * @brief One block of a blocked Bloom filter over phone numbers.
+ *
+ * A block is one 64-byte cache line. A phone number sets one bit in each of
+ * the eight words of a single block, so testing it reads one cache line.
+ */
+typedef struct UserFilterBlock {
+    uint64_t words[8];           /**< Filter bits, one bit per phone number and word. */
+} UserFilterBlock;
+
+/**
+ * @brief Structure for the resizable open-addressing user hash table.
+ *
+ * User records are stored packed in one contiguous slab (`records`) in
+ * insertion order, so loading a million users is a single allocation and a
+ * lookup touches one slot cache line plus the record it finds. The strings of
+ * the records live in a separate name arena (`names`) that lookups only read
+ * to copy out a record they found. Collisions are
+ * resolved with the selected UserProbePolicy (quadratic probing by default).
+ * When the load factor threshold is reached the slot array doubles its
+ * capacity; the previous array is kept in `oldSlots` and migrated a few slots
+ * at a time by subsequent insertions until it is empty.
+ *
+ * Each slot array has a blocked Bloom filter over the hashes it holds, so a
+ * lookup of an unregistered phone number usually stops after one cache line.
+ * The filter of a new array is filled as slots migrate into it.
+ */
+typedef struct UserTable {
+    PackedUser* records;         /**< Contiguous slab of packed user records. */
+    unsigned recordCapacity;     /**< Number of records the slab can hold without growing. */
+    uint8_t* names;              /**< Name arena: the varint-length strings of the records. */
+    size_t namesSize;            /**< Bytes of the name arena in use. */
+    size_t namesCapacity;        /**< Bytes the name arena can hold without growing. */
+    UserSlot* slots;             /**< Current slot array. */
+    unsigned capacity;           /**< Number of slots in the current array (power of two). */
+    unsigned count;              /**< Number of users stored in the table. */
+    UserSlot* oldSlots;          /**< Slot array being migrated, NULL when no rehash is running. */
+    unsigned oldCapacity;        /**< Number of slots in the array being migrated. */
+    unsigned migrateIndex;       /**< Next slot of `oldSlots` to migrate. */
+    UserFilterBlock* filter;     /**< Filter over the hashes in `slots`, NULL if it could not be allocated. */
+    unsigned filterBlocks;       /**< Number of blocks in `filter`. */
+    UserFilterBlock* oldFilter;  /**< Filter over the hashes in `oldSlots`. */
+    unsigned oldFilterBlocks;    /**< Number of blocks in `oldFilter`. */
+} UserTable;
+
 /**
  * @brief Hash table for storing user records.
  *
- * This array of pointers is used to implement a hash table with a size defined by TABLE_SIZE.
- * Each index in the array points to a linked list of User structures to handle collisions.
+ * The table starts empty and allocates its slab and slot array on the first insertion.
  */
-User* hashTable[TABLE_SIZE];
+UserTable userTable = { NULL, 0, NULL, 0, 0, NULL, 0, 0, NULL, 0, 0, NULL, 0, NULL, 0 };
 
 /**
  * @brief Structure to represent an event.
@@ -336,315 +482,6789 @@ Event* head = NULL;
 Event* tail = NULL;
 
 /**
- * @brief Computes a hash value for a given phone number.
+ * @brief Signature of a string hash function usable by the user table.
+ *
+ * A hash function receives the key and its length and returns a 64-bit hash.
+ * The value is computed once per key and reduced to the table size by the caller.
+ */
+typedef uint64_t (*UserHashFunction)(const char* key, size_t length);
+
+/**
+ * @brief Computes the polynomial (base 31) hash of a string.
  *
- * This function calculates a hash value for the input phone number
- * using a simple hash function based on the polynomial accumulation method.
- * The result is then constrained to fit within the defined hash table size.
+ * This is the hash the user table originally used. It is kept as a selectable
+ * hash function and as the baseline of the hash distribution report.
  *
- * @param phone The phone number to be hashed.
- * @return An unsigned integer representing the hash value of the phone number,
- *         which is in the range of [0, TABLE_SIZE - 1].
+ * @param key The string to hash.
+ * @param length Number of characters in `key`.
+ * @return The 64-bit polynomial hash of the string.
  */
-unsigned int hash(const char* phone) {
-    unsigned int hash = 0;
-    for (int i = 0; i < strlen(phone); i++) {
-        hash = (hash * 31 + phone[i]) % TABLE_SIZE;
+uint64_t polynomialHash(const char* key, size_t length) {
+    uint64_t hash = 0;
+    for (size_t i = 0; i < length; i++) {
+        hash = hash * 31 + (unsigned char)key[i];
     }
     return hash;
 }
 
 /**
- * @brief Saves a new user to the hash table.
- *
- * This function inserts a new user into the hash table by calculating the
- * appropriate index based on the user's phone number. It uses a linked list
- * to handle collisions by chaining users at the same index.
+ * @brief Multiplies two 64-bit values and folds the 128-bit product.
  *
- * @param newUser Pointer to the User structure that needs to be saved in the hash table.
+ * @param a First factor.
+ * @param b Second factor.
+ * @return The xor of the low and high halves of `a * b`.
  */
-void saveUser(User* newUser) {
-    unsigned int index = hash(newUser->phone);
-    newUser->next = hashTable[index];
-    hashTable[index] = newUser;
+uint64_t hashMix(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+    __uint128_t product = (__uint128_t)a * b;
+    return (uint64_t)product ^ (uint64_t)(product >> 64);
+#else
+    uint64_t aLow = a & 0xffffffffu, aHigh = a >> 32;
+    uint64_t bLow = b & 0xffffffffu, bHigh = b >> 32;
+    uint64_t lowLow = aLow * bLow, lowHigh = aLow * bHigh;
+    uint64_t highLow = aHigh * bLow, highHigh = aHigh * bHigh;
+    uint64_t cross = (lowLow >> 32) + (lowHigh & 0xffffffffu) + highLow;
+    uint64_t low = (cross << 32) | (lowLow & 0xffffffffu);
+    uint64_t high = highHigh + (lowHigh >> 32) + (cross >> 32);
+    return low ^ high;
+#endif
 }
 
 /**
- * @brief Saves the hash table containing user data to a binary file for persistent storage.
+ * @brief Reads 8 bytes from a possibly unaligned address as a little-endian value.
+ */
+uint64_t hashRead64(const char* p) {
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+/**
+ * @brief Reads 4 bytes from a possibly unaligned address as a little-endian value.
+ */
+uint64_t hashRead32(const char* p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+/**
+ * @brief Computes a wyhash-style hash of a string.
  *
- * This function serializes the hash table structure by iterating through each index
- * and writing the user records stored in it to a binary file named `"users.bin"`.
- * If a collision has occurred at a particular index, the function traverses the linked list
- * at that index to ensure all user records are saved.
+ * The key is consumed a word at a time and mixed with 64x64->128 bit multiplications,
+ * which gives a well-distributed hash even for keys that share long prefixes, such
+ * as phone numbers. Keys of up to 16 bytes (every phone number) are hashed without
+ * a loop.
  *
- * ## Implementation Details:
- * - A binary file is used to store the data for compactness and efficiency.
- * - Each user record is written sequentially using the `fwrite()` function.
- * - Collisions in the hash table are resolved by iterating through the linked list
- *   at each index, ensuring no data is missed.
+ * @param key The string to hash.
+ * @param length Number of characters in `key`.
+ * @return The 64-bit hash of the string.
+ */
+uint64_t wyHash(const char* key, size_t length) {
+    const uint64_t secret0 = 0xa0761d6478bd642full;
+    const uint64_t secret1 = 0xe7037ed1a0b428dbull;
+    const uint64_t secret2 = 0x8ebc6af09c88c6e3ull;
+    uint64_t seed = hashMix(secret0, secret1);
+    uint64_t a;
+    uint64_t b;
+
+    if (length <= 16) {
+        if (length >= 4) {
+            size_t shift = (length >> 3) << 2;
+            a = (hashRead32(key) << 32) | hashRead32(key + shift);
+            b = (hashRead32(key + length - 4) << 32) | hashRead32(key + length - 4 - shift);
+        }
+        else if (length > 0) {
+            a = ((uint64_t)(unsigned char)key[0] << 16) |
+                ((uint64_t)(unsigned char)key[length >> 1] << 8) |
+                (uint64_t)(unsigned char)key[length - 1];
+            b = 0;
+        }
+        else {
+            a = 0;
+            b = 0;
+        }
+    }
+    else {
+        const char* p = key;
+        size_t remaining = length;
+        while (remaining > 16) {
+            seed = hashMix(hashRead64(p) ^ secret1, hashRead64(p + 8) ^ seed);
+            p += 16;
+            remaining -= 16;
+        }
+        a = hashRead64(p + remaining - 16);
+        b = hashRead64(p + remaining - 8);
+    }
+
+    return hashMix(secret2 ^ length, hashMix(a ^ secret1, b ^ seed));
+}
+
+/**
+ * @brief Hash function used by the user table.
  *
- * ## Usage Notes:
- * - The function currently does not include active error checking for file operations.
- *   Uncomment the provided error handling block for production-grade reliability.
- *   This will ensure issues such as failure to open the file are properly reported.
- * - The structure of the `User` object must remain consistent between the program
- *   execution and when the data is loaded back from the file.
+ * Change it with `setUserHashFunction`, which also rehashes the stored users.
+ */
+UserHashFunction userHashFunction = wyHash;
+
+/**
+ * @brief Country calling code of phone numbers written in national format.
  *
- * ## Security Warning:
- * - Ensure the binary file is stored securely to prevent unauthorized access to user data.
- * - The function uses raw binary operations, so care should be taken when modifying
- *   the structure of the `User` object.
+ * "0555 123 45 67", "555 123 45 67", "+90 555 123 45 67" and
+ * "0090 555 123 45 67" all normalize to 905551234567.
+ */
+#define USER_PHONE_COUNTRY_CODE "90"
+
+/**
+ * @brief Maximum number of digits of an international phone number (E.164).
+ */
+#define USER_PHONE_MAX_DIGITS 15
+
+/**
+ * @brief Key of a phone number that does not normalize.
+ *
+ * Such numbers are hashed and compared as text. Normalized phone numbers are
+ * below 10^15, so no key of one equals this value.
+ */
+#define USER_PHONE_SPILLED 0xE000000000000000ull
+
+/**
+ * @brief Converts a phone number to its canonical 64-bit integer.
  *
- * @note This function is part of a larger system that handles hash table-based user
- *       management, enabling features such as persistent data storage and recovery.
+ * Spaces, dashes, dots and parentheses are ignored. A number starting with '+'
+ * or with the international prefix "00" is international: country code and
+ * subscriber number. Any other number is national: a leading trunk prefix '0'
+ * is dropped and USER_PHONE_COUNTRY_CODE is put in front. The digits of the
+ * resulting international number, at most USER_PHONE_MAX_DIGITS of them, are
+ * the value of the key.
  *
- * @see fopen(), fwrite(), fclose()
+ * @param phone The phone number as entered.
+ * @return The canonical key, or 0 if `phone` is not a phone number.
  */
-void saveHashTableToFile() {
-    FILE* file = fopen("users.bin", "wb");
-    /*
-    if (file == NULL) {
-        perror("An error occurred while opening the file");
-        return;
+uint64_t normalizeUserPhone(const char* phone) {
+    uint64_t key = 0;
+    unsigned length = 0;
+    unsigned zeros = 0; // Leading zeros: trunk or international prefix
+    bool international = false;
+    for (const char* p = phone; *p != '\0'; p++) {
+        if (*p == ' ' || *p == '-' || *p == '.' || *p == '(' || *p == ')') {
+            continue;
+        }
+        if (*p == '+' && length == 0 && zeros == 0 && !international) {
+            international = true;
+            continue;
+        }
+        if (*p < '0' || *p > '9') {
+            return 0;
+        }
+        if (length == 0 && *p == '0') {
+            zeros++;
+            continue;
+        }
+        if (++length > USER_PHONE_MAX_DIGITS) {
+            return 0;
+        }
+        key = key * 10 + (uint64_t)(*p - '0');
+    }
+    if (length == 0 || (international && zeros > 0) || zeros > 2) {
+        return 0;
+    }
+    if (international || zeros == 2) {
+        return key;
     }
-    */
 
-    for (int i = 0; i < TABLE_SIZE; i++) {
-        User* current = hashTable[i];
-        while (current != NULL) {
-            fwrite(current, sizeof(User), 1, file);
-            current = current->next;
-        }
+    uint64_t code = 0;
+    unsigned codeLength = 0;
+    for (const char* c = USER_PHONE_COUNTRY_CODE; *c != '\0'; c++, codeLength++) {
+        code = code * 10 + (uint64_t)(*c - '0');
     }
-    fclose(file);
+    if (length + codeLength > USER_PHONE_MAX_DIGITS) {
+        return 0;
+    }
+    for (unsigned i = 0; i < length; i++) {
+        code *= 10;
+    }
+    return code + key;
 }
 
+/**
+ * @brief Returns the key the user index stores for a phone number.
+ *
+ * @param phone The phone number as entered.
+ * @return The canonical key of `normalizeUserPhone`, or USER_PHONE_SPILLED if it does not normalize.
+ */
+uint64_t userPhoneKey(const char* phone) {
+    uint64_t key = normalizeUserPhone(phone);
+    return key != 0 ? key : USER_PHONE_SPILLED;
+}
 
 /**
- * @brief Loads user records from a binary file into the hash table.
+ * @brief Writes the display form of a canonical phone number.
  *
- * This function reads user records from a binary file named "users.bin"
- * and inserts each user into the hash table. It allocates memory for a new
- * User structure for each record read. If less than one record is read,
- * it indicates the end of the file or a read error, and the function will
- * clean up the allocated memory before exiting the loop.
+ * Numbers of USER_PHONE_COUNTRY_CODE are written in national format with the
+ * trunk prefix ("05551234567"), others in international format ("+4915112345678").
+ * A national number that itself starts with 0 is written in international
+ * format, since a second leading 0 would read as an international prefix.
  *
- * Note: Error checking for file opening is commented out. Uncomment the error
- * handling code if needed.
+ * @param key A canonical key, not USER_PHONE_SPILLED.
+ * @param phone Receives the phone number; sizeof(User::phone) bytes.
  */
-void loadHashTableFromFile() {
-    FILE* file = fopen("users.bin", "rb");
-    /*
-    if (file == NULL) {
-        perror("An error occurred while opening the file");
-        return;
+void formatUserPhone(uint64_t key, char* phone) {
+    char digits[24];
+    size_t start = sizeof(digits) - 1;
+    digits[start] = '\0';
+    do {
+        digits[--start] = (char)('0' + key % 10);
+        key /= 10;
+    } while (key != 0);
+    const char* number = digits + start;
+    size_t codeLength = strlen(USER_PHONE_COUNTRY_CODE);
+    if (strncmp(number, USER_PHONE_COUNTRY_CODE, codeLength) == 0 && number[codeLength] != '\0' &&
+        number[codeLength] != '0') {
+        phone[0] = '0';
+        number += codeLength;
+    }
+    else {
+        phone[0] = '+';
     }
-    */
+    size_t length = strlen(number);
+    length = length < 18 ? length : 18; // A corrupt key must not overrun sizeof(User::phone)
+    memcpy(phone + 1, number, length);
+    phone[length + 1] = '\0';
+}
 
-    while (1) {
-        User* newUser = (User*)malloc(sizeof(User));
-        // If fread reads less than one, the file may be empty or an error occurred
-        if (fread(newUser, sizeof(User), 1, file) != 1) {
-            free(newUser); // Clean up memory if end of file or read error occurs
-            break; // Exit the loop when the end of the file is reached
-        }
-        newUser->next = NULL;
-        saveUser(newUser);  // Add the user to the hash table
+/**
+ * @brief Hashes the canonical key of a phone number with a user hash function.
+ *
+ * The key is hashed as one 8-byte word.
+ */
+uint64_t userKeyHash(UserHashFunction function, uint64_t key) {
+    return function((const char*)&key, sizeof(key));
+}
+
+/**
+ * @brief Hashes a phone number with a user hash function.
+ *
+ * Numbers that normalize are hashed through their key, so every way of writing
+ * a number hashes alike; others are hashed as text.
+ */
+uint64_t userPhoneHash(UserHashFunction function, const char* phone) {
+    uint64_t key = userPhoneKey(phone);
+    return key != USER_PHONE_SPILLED ? userKeyHash(function, key) : function(phone, strlen(phone));
+}
+
+/**
+ * @brief Computes the index hash of a canonical phone number key.
+ *
+ * @param key A canonical key, not USER_PHONE_SPILLED.
+ * @return The hash folded to 32 bits, as `hash` returns it.
+ */
+unsigned hashUserKey(uint64_t key) {
+    uint64_t h = userKeyHash(userHashFunction, key);
+    return (unsigned)(h ^ (h >> 32));
+}
+
+/**
+ * @brief Computes a hash value for a given phone number.
+ *
+ * The phone number is normalized and its key hashed once with the selected
+ * user hash function (see `userPhoneHash`); the 64-bit result is folded to 32
+ * bits and callers reduce it to their table size.
+ *
+ * @param phone The phone number to be hashed.
+ * @return An unsigned integer representing the hash value of the phone number.
+ */
+unsigned int hash(const char* phone) {
+    uint64_t h = userPhoneHash(userHashFunction, phone);
+    return (unsigned int)(h ^ (h >> 32));
+}
+
+/**
+ * @brief Number of random salt bytes stored with every password hash.
+ */
+#define PASSWORD_SALT_LENGTH 16
+
+/**
+ * @brief Number of bytes of a derived password hash (one SHA-256 block).
+ */
+#define PASSWORD_HASH_LENGTH 32
+
+/**
+ * @brief Default password work factor; PBKDF2 runs 2^cost iterations.
+ */
+#define PASSWORD_HASH_DEFAULT_COST 14
+
+/**
+ * @brief Largest accepted password work factor.
+ */
+#define PASSWORD_HASH_MAX_COST 24
+
+/**
+ * @brief Number of recently verified logins remembered by the login cache.
+ */
+#define LOGIN_CACHE_CAPACITY 1024
+
+/**
+ * @brief Running state of a SHA-256 computation.
+ */
+typedef struct Sha256Context {
+    uint32_t state[8];           /**< Intermediate hash value. */
+    uint64_t length;             /**< Number of bytes hashed so far. */
+    uint8_t block[64];           /**< Bytes waiting for a full block. */
+    size_t used;                 /**< Number of bytes in `block`. */
+} Sha256Context;
+
+/**
+ * @brief SHA-256 round constants (FIPS 180-4).
+ */
+const uint32_t sha256RoundConstants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+/**
+ * @brief Rotates a 32-bit value right.
+ */
+uint32_t rotateRight32(uint32_t value, unsigned bits) {
+    return (value >> bits) | (value << (32 - bits));
+}
+
+/**
+ * @brief Applies the SHA-256 compression function to one 64-byte block.
+ *
+ * @param state The intermediate hash value, updated in place.
+ * @param block The block to compress.
+ */
+void sha256Transform(uint32_t state[8], const uint8_t block[64]) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) {
+        w[i] = (uint32_t)block[i * 4] << 24 | (uint32_t)block[i * 4 + 1] << 16 |
+            (uint32_t)block[i * 4 + 2] << 8 | (uint32_t)block[i * 4 + 3];
     }
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = rotateRight32(w[i - 15], 7) ^ rotateRight32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = rotateRight32(w[i - 2], 17) ^ rotateRight32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int i = 0; i < 64; i++) {
+        uint32_t s1 = rotateRight32(e, 6) ^ rotateRight32(e, 11) ^ rotateRight32(e, 25);
+        uint32_t t1 = h + s1 + ((e & f) ^ (~e & g)) + sha256RoundConstants[i] + w[i];
+        uint32_t s0 = rotateRight32(a, 2) ^ rotateRight32(a, 13) ^ rotateRight32(a, 22);
+        uint32_t t2 = s0 + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
 
-    fclose(file); // Close the file
+/**
+ * @brief Starts a SHA-256 computation.
+ */
+void sha256Init(Sha256Context* context) {
+    const uint32_t initial[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+    memcpy(context->state, initial, sizeof(initial));
+    context->length = 0;
+    context->used = 0;
+}
+
+/**
+ * @brief Adds bytes to a SHA-256 computation.
+ */
+void sha256Update(Sha256Context* context, const void* data, size_t length) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    context->length += length;
+    while (length > 0) {
+        size_t take = 64 - context->used < length ? 64 - context->used : length;
+        memcpy(context->block + context->used, bytes, take);
+        context->used += take;
+        bytes += take;
+        length -= take;
+        if (context->used == 64) {
+            sha256Transform(context->state, context->block);
+            context->used = 0;
+        }
+    }
 }
 
 /**
- * @brief Inserts a new user into the hash table using quadratic probing.
+ * @brief Finishes a SHA-256 computation.
  *
- * This function attempts to insert a new user into the hash table at the
- * index calculated from the user's phone number. If the calculated index
- * is occupied, it uses quadratic probing to find the next available slot.
- * If the table is full, it notifies the user and returns false.
+ * @param context The computation; it must be restarted before it is used again.
+ * @param digest Receives the 32-byte digest.
+ */
+void sha256Final(Sha256Context* context, uint8_t digest[32]) {
+    uint64_t bits = context->length * 8;
+    size_t used = context->used;
+    context->block[used++] = 0x80;
+    if (used > 56) {
+        memset(context->block + used, 0, 64 - used);
+        sha256Transform(context->state, context->block);
+        used = 0;
+    }
+    memset(context->block + used, 0, 56 - used);
+    for (int i = 0; i < 8; i++) {
+        context->block[56 + i] = (uint8_t)(bits >> (56 - i * 8));
+    }
+    sha256Transform(context->state, context->block);
+    for (int i = 0; i < 8; i++) {
+        digest[i * 4] = (uint8_t)(context->state[i] >> 24);
+        digest[i * 4 + 1] = (uint8_t)(context->state[i] >> 16);
+        digest[i * 4 + 2] = (uint8_t)(context->state[i] >> 8);
+        digest[i * 4 + 3] = (uint8_t)context->state[i];
+    }
+}
+
+/**
+ * @brief HMAC-SHA256 keyed with a fixed key.
  *
- * @param newUser Pointer to the User structure to be inserted into the hash table.
- * @return True if the user was successfully added, false if the hash table is full.
+ * The inner and outer contexts already contain the padded key, so every message
+ * costs only the compressions of the message itself, which matters for PBKDF2.
  */
-bool quadraticProbingInsert(User* newUser) {
-    unsigned int index = hash(newUser->phone);
-    unsigned int i = 0;
-    unsigned int originalIndex = index;
-    unsigned int startIndex = index;
+typedef struct HmacSha256Context {
+    Sha256Context inner;         /**< SHA-256 state after the inner key pad. */
+    Sha256Context outer;         /**< SHA-256 state after the outer key pad. */
+} HmacSha256Context;
 
-    while (hashTable[index] != NULL && i < TABLE_SIZE) {
-        i++;
-        index = (originalIndex + i * i) % TABLE_SIZE;
+/**
+ * @brief Prepares HMAC-SHA256 for a key.
+ */
+void hmacSha256Init(HmacSha256Context* context, const void* key, size_t keyLength) {
+    uint8_t block[64];
+    memset(block, 0, sizeof(block));
+    if (keyLength > 64) {
+        Sha256Context keyHash;
+        sha256Init(&keyHash);
+        sha256Update(&keyHash, key, keyLength);
+        sha256Final(&keyHash, block);
+    }
+    else {
+        memcpy(block, key, keyLength);
+    }
 
-        if (index == startIndex) {
-            printf("Hash table full. User not added.\n");
-            return false;
+    uint8_t pad[64];
+    for (int i = 0; i < 64; i++) {
+        pad[i] = block[i] ^ 0x36;
+    }
+    sha256Init(&context->inner);
+    sha256Update(&context->inner, pad, 64);
+    for (int i = 0; i < 64; i++) {
+        pad[i] = block[i] ^ 0x5c;
+    }
+    sha256Init(&context->outer);
+    sha256Update(&context->outer, pad, 64);
+}
+
+/**
+ * @brief Computes the HMAC-SHA256 of a message.
+ *
+ * @param context The keyed context; it is not modified.
+ * @param data The message.
+ * @param length Length of the message in bytes.
+ * @param mac Receives the 32-byte MAC.
+ */
+void hmacSha256(const HmacSha256Context* context, const void* data, size_t length, uint8_t mac[32]) {
+    Sha256Context inner = context->inner;
+    sha256Update(&inner, data, length);
+    uint8_t innerDigest[32];
+    sha256Final(&inner, innerDigest);
+    Sha256Context outer = context->outer;
+    sha256Update(&outer, innerDigest, sizeof(innerDigest));
+    sha256Final(&outer, mac);
+}
+
+/**
+ * @brief Derives a 32-byte key with PBKDF2-HMAC-SHA256 (RFC 8018).
+ *
+ * @param password The password.
+ * @param passwordLength Length of the password in bytes.
+ * @param salt The salt.
+ * @param saltLength Length of the salt in bytes (at most 60).
+ * @param iterations Number of iterations, at least 1.
+ * @param key Receives the derived key.
+ */
+void pbkdf2HmacSha256(const char* password, size_t passwordLength, const uint8_t* salt, size_t saltLength,
+    uint32_t iterations, uint8_t key[32]) {
+    HmacSha256Context context;
+    hmacSha256Init(&context, password, passwordLength);
+
+    uint8_t message[64];
+    memcpy(message, salt, saltLength);
+    message[saltLength] = 0;
+    message[saltLength + 1] = 0;
+    message[saltLength + 2] = 0;
+    message[saltLength + 3] = 1; // First (and only) block
+    uint8_t u[32];
+    hmacSha256(&context, message, saltLength + 4, u);
+    memcpy(key, u, 32);
+    for (uint32_t i = 1; i < iterations; i++) {
+        hmacSha256(&context, u, sizeof(u), u);
+        for (int j = 0; j < 32; j++) {
+            key[j] ^= u[j];
         }
     }
+}
 
-    if (i < TABLE_SIZE) {
-        hashTable[index] = newUser;
-        return true;
+/**
+ * @brief Work factor used for passwords hashed from now on.
+ *
+ * Each record stores the cost it was hashed with, so changing this value does
+ * not invalidate existing users. Set it with `setPasswordHashCost`.
+ */
+unsigned passwordHashCost = PASSWORD_HASH_DEFAULT_COST;
+
+/**
+ * @brief Sets the password work factor.
+ *
+ * @param cost Base-2 logarithm of the PBKDF2 iteration count, at most PASSWORD_HASH_MAX_COST.
+ * @return true if the cost was accepted; false otherwise.
+ */
+bool setPasswordHashCost(unsigned cost) {
+    if (cost > PASSWORD_HASH_MAX_COST) {
+        return false;
     }
-    //else {
-    //    printf("Hash table full. User not added.\n");
-    //    return false;
-    //}
+    passwordHashCost = cost;
+    return true;
 }
 
+/**
+ * @brief Source of salts and of the login cache key.
+ */
+std::random_device randomDevice;
 
 /**
- * @brief Saves user data to the hash table and a file.
+ * @brief Serializes access to `randomDevice`, which is not thread-safe.
+ */
+std::mutex randomMutex;
+
+/**
+ * @brief Fills a buffer with bytes from the system random source.
+ */
+void randomBytes(uint8_t* out, size_t length) {
+    std::lock_guard<std::mutex> guard(randomMutex);
+    for (size_t i = 0; i < length; i += 4) {
+        uint32_t value = randomDevice();
+        memcpy(out + i, &value, length - i < 4 ? length - i : 4);
+    }
+}
+
+/**
+ * @brief Replaces the plaintext password of a record with a salted hash.
  *
- * This function takes a User structure as input, allocates memory for a new
- * User, copies the provided user data into it, and then inserts the new user
- * into the hash table. After adding the user to the hash table, it saves the
- * entire hash table to a binary file. The screen is cleared after the operation.
+ * Records whose password field is empty already hold a hash and are left as
+ * they are; `registerUser` and `saveUser` turn away records that hold neither
+ * (see `userPasswordSet`). The plaintext is wiped from the record.
  *
- * @param user The User structure containing the data to be saved.
+ * @param user Pointer to the record to hash.
  */
-void saveUserData(User user) {
-    User* newUser = (User*)malloc(sizeof(User));
-    *newUser = user;
-    saveUser(newUser); // Add to hash table
-    saveHashTableToFile(); // Save to file
-    clear_screen();
+void hashUserPassword(User* user) {
+    if (user->password[0] == '\0') {
+        return;
+    }
+    user->passwordCost = passwordHashCost;
+    randomBytes(user->salt, sizeof(user->salt));
+    pbkdf2HmacSha256(user->password, strnlen(user->password, sizeof(user->password)), user->salt,
+        sizeof(user->salt), 1u << user->passwordCost, user->passwordHash);
+    memset(user->password, 0, sizeof(user->password));
 }
+
 /**
- * @brief Prints the contents of the hash table.
+ * @brief Tells whether a record holds a password: a plaintext one, or a hash with a usable cost.
+ *
+ * @param user Pointer to the record.
+ * @return true if the password field is set or the record carries a password hash.
+ */
+bool userPasswordSet(const User* user) {
+    if (user->password[0] != '\0') {
+        return true;
+    }
+    bool hashed = false;
+    for (size_t i = 0; i < sizeof(user->passwordHash); i++) {
+        hashed = hashed || user->passwordHash[i] != 0;
+    }
+    return hashed && user->passwordCost <= PASSWORD_HASH_MAX_COST;
+}
+
+/**
+ * @brief Entry of the login cache.
+ */
+typedef struct LoginCacheEntry {
+    uint8_t token[32];           /**< Token of a verified login, see `loginCacheToken`. */
+    int newer;                   /**< More recently used entry, -1 for the most recent. */
+    int older;                   /**< Less recently used entry, -1 for the least recent. */
+    int chain;                   /**< Next entry in the same bucket, -1 at the end. */
+} LoginCacheEntry;
+
+/**
+ * @brief Bounded LRU cache of recently verified logins.
+ *
+ * A successful login stores a token: an HMAC, under a key generated at startup,
+ * of the phone number, the password and the stored salt and hash. A repeated
+ * login with the same credentials is accepted after one HMAC instead of a full
+ * PBKDF2 run. Tokens include the stored hash, so they stop matching as soon as
+ * the password changes, and the cache itself never holds a password.
+ * All access goes through `loginCacheMutex`; tokens are computed outside it.
+ */
+typedef struct LoginCache {
+    LoginCacheEntry entries[LOGIN_CACHE_CAPACITY]; /**< Entry storage. */
+    int buckets[LOGIN_CACHE_CAPACITY];             /**< First entry of each bucket, -1 if empty. */
+    int newest;                                    /**< Most recently used entry, -1 if empty. */
+    int oldest;                                    /**< Least recently used entry, -1 if empty. */
+    int count;                                     /**< Number of entries in use. */
+    HmacSha256Context key;                         /**< Key of the login tokens, set once by `loginCacheKeyOnce`. */
+    unsigned long hits;                            /**< Logins accepted from the cache. */
+    unsigned long misses;                          /**< Logins that ran PBKDF2. */
+} LoginCache;
+
+/**
+ * @brief The login cache.
+ */
+LoginCache loginCache;
+
+/**
+ * @brief Guards `loginCache`.
+ */
+std::mutex loginCacheMutex;
+
+/**
+ * @brief Makes sure the login cache key is generated exactly once.
+ */
+std::once_flag loginCacheKeyOnce;
+
+/**
+ * @brief Forgets every cached login. The key and the counters are kept.
+ */
+void clearLoginCache() {
+    std::lock_guard<std::mutex> guard(loginCacheMutex);
+    for (int i = 0; i < LOGIN_CACHE_CAPACITY; i++) {
+        loginCache.buckets[i] = -1;
+    }
+    loginCache.newest = -1;
+    loginCache.oldest = -1;
+    loginCache.count = 0;
+}
+
+/**
+ * @brief Computes the login token of a password for a stored user.
+ *
+ * The password enters the token through its SHA-256 digest, so every byte of
+ * it counts, however long the input is.
+ */
+void loginCacheToken(const User* user, const char* password, uint8_t token[32]) {
+    std::call_once(loginCacheKeyOnce, []() {
+        uint8_t key[32];
+        randomBytes(key, sizeof(key));
+        hmacSha256Init(&loginCache.key, key, sizeof(key));
+        clearLoginCache();
+    });
+
+    char message[sizeof(user->phone) + 32 + PASSWORD_SALT_LENGTH + PASSWORD_HASH_LENGTH];
+    size_t length = 0;
+    size_t phoneLength = strnlen(user->phone, sizeof(user->phone) - 1) + 1;
+    memcpy(message, user->phone, phoneLength);
+    length += phoneLength;
+    Sha256Context passwordDigest;
+    sha256Init(&passwordDigest);
+    sha256Update(&passwordDigest, password, strlen(password));
+    sha256Final(&passwordDigest, (uint8_t*)message + length);
+    length += 32;
+    memcpy(message + length, user->salt, sizeof(user->salt));
+    length += sizeof(user->salt);
+    memcpy(message + length, user->passwordHash, sizeof(user->passwordHash));
+    length += sizeof(user->passwordHash);
+    hmacSha256(&loginCache.key, message, length, token);
+}
+
+/**
+ * @brief Detaches an entry from the recency list.
+ */
+void loginCacheUnlink(int index) {
+    LoginCacheEntry* entry = &loginCache.entries[index];
+    if (entry->newer >= 0) {
+        loginCache.entries[entry->newer].older = entry->older;
+    }
+    else {
+        loginCache.newest = entry->older;
+    }
+    if (entry->older >= 0) {
+        loginCache.entries[entry->older].newer = entry->newer;
+    }
+    else {
+        loginCache.oldest = entry->newer;
+    }
+}
+
+/**
+ * @brief Makes an entry the most recently used one.
+ */
+void loginCachePushNewest(int index) {
+    LoginCacheEntry* entry = &loginCache.entries[index];
+    entry->newer = -1;
+    entry->older = loginCache.newest;
+    if (loginCache.newest >= 0) {
+        loginCache.entries[loginCache.newest].newer = index;
+    }
+    loginCache.newest = index;
+    if (loginCache.oldest < 0) {
+        loginCache.oldest = index;
+    }
+}
+
+/**
+ * @brief Returns the bucket of a token.
+ */
+unsigned loginCacheBucket(const uint8_t token[32]) {
+    uint32_t value;
+    memcpy(&value, token, sizeof(value));
+    return value & (LOGIN_CACHE_CAPACITY - 1);
+}
+
+/**
+ * @brief Looks up a token and marks it as recently used.
+ *
+ * The caller holds `loginCacheMutex` when other threads may use the cache.
+ *
+ * @return true if the token is cached; false otherwise.
+ */
+bool loginCacheLookup(const uint8_t token[32]) {
+    for (int i = loginCache.buckets[loginCacheBucket(token)]; i >= 0; i = loginCache.entries[i].chain) {
+        if (memcmp(loginCache.entries[i].token, token, 32) == 0) {
+            loginCacheUnlink(i);
+            loginCachePushNewest(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Adds a token, evicting the least recently used one when the cache is full.
+ *
+ * The caller holds `loginCacheMutex` when other threads may use the cache.
+ */
+void loginCacheInsert(const uint8_t token[32]) {
+    int index;
+    if (loginCache.count < LOGIN_CACHE_CAPACITY) {
+        index = loginCache.count++;
+    }
+    else {
+        index = loginCache.oldest;
+        loginCacheUnlink(index);
+        int* link = &loginCache.buckets[loginCacheBucket(loginCache.entries[index].token)];
+        while (*link != index) {
+            link = &loginCache.entries[*link].chain;
+        }
+        *link = loginCache.entries[index].chain;
+    }
+
+    LoginCacheEntry* entry = &loginCache.entries[index];
+    memcpy(entry->token, token, 32);
+    unsigned bucket = loginCacheBucket(token);
+    entry->chain = loginCache.buckets[bucket];
+    loginCache.buckets[bucket] = index;
+    loginCachePushNewest(index);
+}
+
+/**
+ * @brief Checks a password against the salted hash of a stored user.
+ *
+ * A login verified recently is accepted from the login cache; otherwise PBKDF2
+ * runs with the salt and cost of the record and the result is compared in
+ * constant time. Safe to call from several threads at once; no lock is held
+ * while PBKDF2 runs.
+ *
+ * @param user Pointer to a copy of the stored record.
+ * @param password The password to check.
+ * @return true if the password is correct; false otherwise.
+ */
+bool userPasswordMatches(const User* user, const char* password) {
+    if (user->passwordCost > PASSWORD_HASH_MAX_COST) {
+        return false;
+    }
+    uint8_t token[32];
+    loginCacheToken(user, password, token);
+    {
+        std::lock_guard<std::mutex> guard(loginCacheMutex);
+        if (loginCacheLookup(token)) {
+            loginCache.hits++;
+            return true;
+        }
+        loginCache.misses++;
+    }
+
+    uint8_t derived[PASSWORD_HASH_LENGTH];
+    pbkdf2HmacSha256(password, strlen(password), user->salt, sizeof(user->salt), 1u << user->passwordCost, derived);
+    uint8_t difference = 0;
+    for (int i = 0; i < PASSWORD_HASH_LENGTH; i++) {
+        difference |= derived[i] ^ user->passwordHash[i];
+    }
+    if (difference != 0) {
+        return false;
+    }
+    std::lock_guard<std::mutex> guard(loginCacheMutex);
+    if (!loginCacheLookup(token)) { // Another thread may have verified the same login meanwhile
+        loginCacheInsert(token);
+    }
+    return true;
+}
+
+/**
+ * @brief Structure describing a read-only memory mapping of a whole file.
+ */
+typedef struct FileMapping {
+    const char* data;            /**< First byte of the mapping, NULL when nothing is mapped. */
+    size_t size;                 /**< Size of the mapped file in bytes. */
+#if defined(_WIN32) || defined(_WIN64)
+    HANDLE file;                 /**< Handle of the mapped file. */
+    HANDLE mapping;              /**< Handle of the file mapping object. */
+#endif
+} FileMapping;
+
+/**
+ * @brief Mapping of users.bin that the user table currently reads from.
+ *
+ * While `data` is not NULL the record slab and slot array of `userTable` point
+ * into this mapping and must be copied to the heap before they are modified.
+ */
+FileMapping userFile;
+
+/**
+ * @brief Maps a whole file into memory for reading.
+ *
+ * @param path Path of the file to map.
+ * @param mapping Pointer to a FileMapping that receives the mapping.
+ * @return true if the file was mapped; false if it is missing, empty or cannot be mapped.
+ */
+bool mapFile(const char* path, FileMapping* mapping) {
+    memset(mapping, 0, sizeof(*mapping));
+#if defined(_WIN32) || defined(_WIN64)
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE view = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (view == NULL) {
+        CloseHandle(file);
+        return false;
+    }
+    mapping->data = (const char*)MapViewOfFile(view, FILE_MAP_READ, 0, 0, 0);
+    if (mapping->data == NULL) {
+        CloseHandle(view);
+        CloseHandle(file);
+        return false;
+    }
+    mapping->size = (size_t)size.QuadPart;
+    mapping->file = file;
+    mapping->mapping = view;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        return false;
+    }
+    void* data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping stays valid after the descriptor is closed
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    mapping->data = (const char*)data;
+    mapping->size = (size_t)info.st_size;
+#endif
+    return true;
+}
+
+/**
+ * @brief Releases a mapping created by `mapFile`.
+ *
+ * @param mapping Pointer to the FileMapping to release; it is reset to empty.
+ */
+void unmapFile(FileMapping* mapping) {
+    if (mapping->data == NULL) {
+        return;
+    }
+#if defined(_WIN32) || defined(_WIN64)
+    UnmapViewOfFile(mapping->data);
+    CloseHandle(mapping->mapping);
+    CloseHandle(mapping->file);
+#else
+    munmap((void*)mapping->data, mapping->size);
+#endif
+    memset(mapping, 0, sizeof(*mapping));
+}
+
+/**
+ * @brief Reader-writer lock guarding the user table, users.bin and users.log.
+ *
+ * Lookups take it shared, so any number of threads authenticate in parallel;
+ * inserts, loads, saves and clears take it exclusively. Password hashing and
+ * verification run outside the lock. C++11 has no shared mutex, so the native
+ * SRW lock or pthread rwlock is used. Functions documented as requiring the
+ * caller to hold the lock never take it themselves.
+ */
+#if defined(_WIN32) || defined(_WIN64)
+SRWLOCK userStoreLock = SRWLOCK_INIT;
+#else
+pthread_rwlock_t userStoreLock = PTHREAD_RWLOCK_INITIALIZER;
+#endif
+
+/**
+ * @brief Acquires the user store lock.
+ *
+ * @param exclusive true to modify the store; false to read it.
+ */
+void lockUserStore(bool exclusive) {
+#if defined(_WIN32) || defined(_WIN64)
+    if (exclusive) {
+        AcquireSRWLockExclusive(&userStoreLock);
+    }
+    else {
+        AcquireSRWLockShared(&userStoreLock);
+    }
+#else
+    if (exclusive) {
+        pthread_rwlock_wrlock(&userStoreLock);
+    }
+    else {
+        pthread_rwlock_rdlock(&userStoreLock);
+    }
+#endif
+}
+
+/**
+ * @brief Releases the user store lock.
+ *
+ * @param exclusive The mode the lock was acquired in.
+ */
+void unlockUserStore(bool exclusive) {
+#if defined(_WIN32) || defined(_WIN64)
+    if (exclusive) {
+        ReleaseSRWLockExclusive(&userStoreLock);
+    }
+    else {
+        ReleaseSRWLockShared(&userStoreLock);
+    }
+#else
+    (void)exclusive;
+    pthread_rwlock_unlock(&userStoreLock);
+#endif
+}
+
+/**
+ * @brief Number of slots of a user table slot array per filter block.
+ *
+ * Sixteen filter bits per slot leave at least 21 bits per user below the
+ * maximum load factor, for a false positive rate well below 0.1%.
+ */
+#define USER_FILTER_SLOTS_PER_BLOCK 32
+
+/**
+ * @brief Odd multipliers that pick the bit of a phone number in each word of a filter block.
+ */
+const uint32_t userFilterSalts[8] = { 0x47b6137bu, 0x44974d91u, 0x8824ad5bu, 0xa2b7289du,
+    0x705495c7u, 0x2df1424bu, 0x9efc4947u, 0x5c6bfb31u };
+
+/**
+ * @brief Allocates a zeroed phone number filter aligned to a cache line.
+ *
+ * @param blocks Number of blocks of the filter.
+ * @return The filter, or NULL if it could not be allocated. Release it with `freeUserFilter`.
+ */
+UserFilterBlock* allocUserFilter(size_t blocks) {
+    void* filter = NULL;
+#if defined(_WIN32) || defined(_WIN64)
+    filter = _aligned_malloc(blocks * sizeof(UserFilterBlock), sizeof(UserFilterBlock));
+#else
+    if (posix_memalign(&filter, sizeof(UserFilterBlock), blocks * sizeof(UserFilterBlock)) != 0) {
+        filter = NULL;
+    }
+#endif
+    if (filter != NULL) {
+        memset(filter, 0, blocks * sizeof(UserFilterBlock));
+    }
+    return (UserFilterBlock*)filter;
+}
+
+/**
+ * @brief Releases a filter allocated by `allocUserFilter`.
+ */
+void freeUserFilter(UserFilterBlock* filter) {
+#if defined(_WIN32) || defined(_WIN64)
+    _aligned_free(filter);
+#else
+    free(filter);
+#endif
+}
+
+/**
+ * @brief Mixes the hash of a phone number into the value its filter bits are taken from.
+ *
+ * The low 32 bits pick the bit in each word of a block; the high 32 bits pick
+ * the block of a user table filter. Mixing keeps the filter independent of the
+ * low hash bits that place the phone number in the table or the page directory.
+ */
+uint64_t userFilterMix(uint64_t h) {
+    return hashMix(h, 0x9e3779b97f4a7c15ull);
+}
+
+/**
+ * @brief Sets the bits of a phone number in a filter block.
+ *
+ * @param block The block.
+ * @param mixed The phone number's hash passed through `userFilterMix`.
+ */
+void userFilterBlockAdd(UserFilterBlock* block, uint64_t mixed) {
+    uint32_t key = (uint32_t)mixed;
+    for (int i = 0; i < 8; i++) {
+        block->words[i] |= (uint64_t)1 << ((key * userFilterSalts[i]) >> 26);
+    }
+}
+
+/**
+ * @brief Tests the bits of a phone number in a filter block.
+ *
+ * @param block The block.
+ * @param mixed The phone number's hash passed through `userFilterMix`.
+ * @return false if the phone number was never added to the block; true if it may have been.
+ */
+bool userFilterBlockContains(const UserFilterBlock* block, uint64_t mixed) {
+    uint32_t key = (uint32_t)mixed;
+    uint64_t missing = 0;
+    for (int i = 0; i < 8; i++) {
+        missing |= ~block->words[i] & ((uint64_t)1 << ((key * userFilterSalts[i]) >> 26));
+    }
+    return missing == 0;
+}
+
+/**
+ * @brief Probability that a phone number never added to a block passes it.
+ */
+double userFilterBlockFalsePositiveRate(const UserFilterBlock* block) {
+    double rate = 1.0;
+    for (int i = 0; i < 8; i++) {
+        unsigned bits = 0;
+        for (uint64_t word = block->words[i]; word != 0; word &= word - 1) {
+            bits++;
+        }
+        rate *= bits / 64.0;
+    }
+    return rate;
+}
+
+/**
+ * @brief Returns the number of filter blocks of a slot array.
+ *
+ * @param capacity Number of slots in the array.
+ */
+unsigned userTableFilterSize(unsigned capacity) {
+    return capacity / USER_FILTER_SLOTS_PER_BLOCK > 0 ? capacity / USER_FILTER_SLOTS_PER_BLOCK : 1;
+}
+
+/**
+ * @brief Adds a slot hash to the filter of a slot array.
+ *
+ * @param filter The filter; nothing is done if it is NULL.
+ * @param blocks Number of blocks of the filter.
+ * @param h The hash stored in the slot.
+ */
+void userTableFilterAdd(UserFilterBlock* filter, unsigned blocks, unsigned h) {
+    if (filter != NULL) {
+        uint64_t mixed = userFilterMix(h);
+        userFilterBlockAdd(&filter[((mixed >> 32) * blocks) >> 32], mixed);
+    }
+}
+
+/**
+ * @brief Tests whether a slot array may hold a hash.
+ *
+ * @param filter The filter of the slot array, or NULL if it has none.
+ * @param blocks Number of blocks of the filter.
+ * @param h The hash of the phone number looked up.
+ * @return false if no slot of the array holds `h`; true if one may.
+ */
+bool userTableFilterContains(const UserFilterBlock* filter, unsigned blocks, unsigned h) {
+    if (filter == NULL) {
+        return true;
+    }
+    uint64_t mixed = userFilterMix(h);
+    return userFilterBlockContains(&filter[((mixed >> 32) * blocks) >> 32], mixed);
+}
+
+/**
+ * @brief Allocates the filter of a slot array and adds every hash the array holds.
+ *
+ * Only the slots are read, never the records, so building the filter of a
+ * memory-mapped table does not page its records in.
+ *
+ * @param slots The slot array.
+ * @param capacity Number of slots in the array.
+ * @return The filter, or NULL if it could not be allocated.
+ */
+UserFilterBlock* buildUserTableFilter(const UserSlot* slots, unsigned capacity) {
+    unsigned blocks = userTableFilterSize(capacity);
+    UserFilterBlock* filter = allocUserFilter(blocks);
+    for (unsigned i = 0; filter != NULL && i < capacity; i++) {
+        if (slots[i].record != 0) {
+            userTableFilterAdd(filter, blocks, slots[i].hash);
+        }
+    }
+    return filter;
+}
+
+/**
+ * @brief Number of characters of a phone number packed by users.bin version 5.
+ */
+#define USER_PHONE_PACKED_DIGITS 16
+
+/**
+ * @brief Writes out a phone number packed as BCD by users.bin version 5.
+ *
+ * Version 5 stored each character in one nibble, the first character in the
+ * most significant one: digits as BCD, a leading '+' as 0xA and 0xF after the
+ * last character. Numbers that did not pack were stored in the name arena
+ * under USER_PHONE_SPILLED.
+ *
+ * @param packed The packed phone number, not USER_PHONE_SPILLED.
+ * @param phone Receives the phone number; at least USER_PHONE_PACKED_DIGITS + 1 bytes.
+ */
+void unpackBcdUserPhone(uint64_t packed, char* phone) {
+    unsigned i = 0;
+    for (; i < USER_PHONE_PACKED_DIGITS; i++) {
+        unsigned nibble = (unsigned)(packed >> (60 - 4 * i)) & 0xF;
+        if (nibble == 0xF) {
+            break;
+        }
+        phone[i] = nibble == 0xA ? '+' : (char)('0' + nibble);
+    }
+    phone[i] = '\0';
+}
+
+/**
+ * @brief Writes an unsigned integer as a varint: 7 bits per byte, low bits first.
+ *
+ * @param out Receives the encoding; at least 5 bytes.
+ * @param value The value to encode.
+ * @return The number of bytes written.
+ */
+size_t writeVarint(uint8_t* out, uint32_t value) {
+    size_t length = 0;
+    while (value >= 0x80) {
+        out[length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[length++] = (uint8_t)value;
+    return length;
+}
+
+/**
+ * @brief Reads a varint written by `writeVarint`.
+ *
+ * @param in The encoding.
+ * @param value Receives the value.
+ * @return The number of bytes read.
+ */
+size_t readVarint(const uint8_t* in, uint32_t* value) {
+    uint32_t result = 0;
+    size_t length = 0;
+    for (unsigned shift = 0; shift < 35; shift += 7) {
+        uint8_t byte = in[length++];
+        result |= (uint32_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            break;
+        }
+    }
+    *value = result;
+    return length;
+}
+
+/**
+ * @brief Copies a varint-length string of the name arena into a fixed-size field.
+ *
+ * @param entry The string in the arena.
+ * @param out Receives the string, truncated and null-terminated.
+ * @param size Size of `out` in bytes.
+ * @return The number of arena bytes the string takes.
+ */
+size_t readUserString(const uint8_t* entry, char* out, size_t size) {
+    uint32_t length;
+    size_t header = readVarint(entry, &length);
+    size_t copied = length < size - 1 ? length : size - 1;
+    memcpy(out, entry + header, copied);
+    out[copied] = '\0';
+    return header + length;
+}
+
+/**
+ * @brief Appends the strings of a user to the name arena of a table.
+ *
+ * The arena doubles when it is full. The entry holds the name, the surname and
+ * the phone number as it was entered, which is left empty when it is the
+ * display form of the record's key (see `formatUserPhone`).
+ *
+ * @param table Pointer to the UserTable, which must own its memory.
+ * @param user The user whose strings are stored.
+ * @param phone The phone number text to store, possibly empty.
+ * @return The offset of the entry, or UINT32_MAX if the arena could not grow.
+ */
+uint32_t userNamesAppend(UserTable* table, const User* user, const char* phone) {
+    const char* strings[3] = { user->name, user->surname, phone };
+    size_t lengths[3] = { strnlen(user->name, sizeof(user->name)), strnlen(user->surname, sizeof(user->surname)),
+        strnlen(phone, sizeof(user->phone)) };
+    const unsigned count = 3;
+    size_t needed = 0;
+    for (unsigned i = 0; i < count; i++) {
+        needed += 5 + lengths[i];
+    }
+    if (table->namesSize + needed > UINT32_MAX) {
+        return UINT32_MAX;
+    }
+    if (table->namesSize + needed > table->namesCapacity) {
+        size_t capacity = table->namesCapacity ? table->namesCapacity : 4096;
+        while (table->namesSize + needed > capacity) {
+            capacity *= 2;
+        }
+        uint8_t* names = (uint8_t*)realloc(table->names, capacity);
+        if (names == NULL) {
+            return UINT32_MAX;
+        }
+        table->names = names;
+        table->namesCapacity = capacity;
+    }
+
+    uint32_t offset = (uint32_t)table->namesSize;
+    for (unsigned i = 0; i < count; i++) {
+        table->namesSize += writeVarint(table->names + table->namesSize, (uint32_t)lengths[i]);
+        memcpy(table->names + table->namesSize, strings[i], lengths[i]);
+        table->namesSize += lengths[i];
+    }
+    return offset;
+}
+
+/**
+ * @brief Computes the number of name arena bytes of the strings of a record.
+ *
+ * @param table Pointer to the UserTable that holds the record.
+ * @param record The packed record.
+ * @return The size of the entry at `record->names`.
+ */
+size_t userNamesEntrySize(const UserTable* table, const PackedUser* record) {
+    const uint8_t* entry = table->names + record->names;
+    size_t size = 0;
+    for (unsigned i = 0; i < 3; i++) {
+        uint32_t length;
+        size += readVarint(entry + size, &length);
+        size += length;
+    }
+    return size;
+}
+
+/**
+ * @brief Packs a user into a record of a table, storing its strings in the name arena.
+ *
+ * The record is keyed on the normalized phone number; the number as entered
+ * is only stored when it differs from the display form of that key.
+ *
+ * @param table Pointer to the UserTable, which must own its memory.
+ * @param user The user to pack; its password must already be hashed.
+ * @param out Receives the packed record.
+ * @return true if the record was packed; false if the name arena could not grow.
+ */
+bool userTablePack(UserTable* table, const User* user, PackedUser* out) {
+    char phone[sizeof(user->phone) + 1];
+    memcpy(phone, user->phone, sizeof(user->phone));
+    phone[sizeof(user->phone)] = '\0';
+    out->phone = userPhoneKey(phone);
+    char display[sizeof(user->phone)] = "";
+    if (out->phone != USER_PHONE_SPILLED) {
+        formatUserPhone(out->phone, display);
+    }
+    out->names = userNamesAppend(table, user, strcmp(display, phone) == 0 ? "" : phone);
+    out->passwordCost = user->passwordCost;
+    memcpy(out->salt, user->salt, sizeof(out->salt));
+    memcpy(out->passwordHash, user->passwordHash, sizeof(out->passwordHash));
+    return out->names != UINT32_MAX;
+}
+
+/**
+ * @brief Copies a packed record of a table out as a User.
+ *
+ * @param table Pointer to the UserTable that holds the record.
+ * @param record The packed record.
+ * @param out Receives the user, with an empty plaintext password.
+ */
+void userTableUnpack(const UserTable* table, const PackedUser* record, User* out) {
+    memset(out, 0, sizeof(*out));
+    const uint8_t* entry = table->names + record->names;
+    entry += readUserString(entry, out->name, sizeof(out->name));
+    entry += readUserString(entry, out->surname, sizeof(out->surname));
+    readUserString(entry, out->phone, sizeof(out->phone));
+    if (out->phone[0] == '\0' && record->phone != USER_PHONE_SPILLED) {
+        formatUserPhone(record->phone, out->phone);
+    }
+    out->passwordCost = record->passwordCost;
+    memcpy(out->salt, record->salt, sizeof(out->salt));
+    memcpy(out->passwordHash, record->passwordHash, sizeof(out->passwordHash));
+}
+
+/**
+ * @brief Writes out the phone number of a packed record.
+ *
+ * @param table Pointer to the UserTable that holds the record.
+ * @param record The packed record.
+ * @param phone Receives the phone number; sizeof(User::phone) bytes.
+ */
+void userTableRecordPhone(const UserTable* table, const PackedUser* record, char* phone) {
+    User user;
+    userTableUnpack(table, record, &user);
+    strcpy(phone, user.phone);
+}
+
+/**
+ * @brief Tells whether a packed record holds a phone number.
+ *
+ * @param table Pointer to the UserTable that holds the record.
+ * @param record The packed record.
+ * @param key The key of the phone number, see `userPhoneKey`.
+ * @param phone The phone number, compared as text when it does not normalize.
+ * @return true if the record holds the phone number.
+ */
+bool userTableRecordHasPhone(const UserTable* table, const PackedUser* record, uint64_t key, const char* phone) {
+    if (record->phone != key) {
+        return false;
+    }
+    if (key != USER_PHONE_SPILLED) {
+        return true;
+    }
+    char stored[sizeof(((User*)0)->phone)];
+    userTableRecordPhone(table, record, stored);
+    return strcmp(stored, phone) == 0;
+}
+
+/**
+ * @brief Computes the index hash of a record of a table.
+ *
+ * @param table Pointer to the UserTable.
+ * @param index Index of the record in the slab.
+ * @return The hash of the phone number of the record.
+ */
+unsigned userTableRecordHash(const UserTable* table, unsigned index) {
+    if (table->records[index].phone != USER_PHONE_SPILLED) {
+        return hashUserKey(table->records[index].phone);
+    }
+    char phone[sizeof(((User*)0)->phone)];
+    userTableRecordPhone(table, &table->records[index], phone);
+    return hash(phone);
+}
+
+/**
+ * @brief Tells whether a pointer points into the memory-mapped users.bin.
+ */
+bool userFileHolds(const void* pointer) {
+    const char* p = (const char*)pointer;
+    return userFile.data != NULL && p >= userFile.data && p < userFile.data + userFile.size;
+}
+
+/**
+ * @brief Copies a memory-mapped user table to the heap.
+ *
+ * Called before every modification of the table. After the first registration
+ * following a zero-copy load, the table owns its slab, name arena, slot array and filter
+ * again and users.bin is unmapped. A filter that cannot be copied is dropped.
+ *
+ * @param table Pointer to the UserTable to detach from `userFile`.
+ * @return true if the table owns its memory; false if an allocation failed.
+ */
+bool userTableDetach(UserTable* table) {
+    if (userFile.data == NULL) {
+        return true;
+    }
+
+    unsigned recordCapacity = table->count > USER_TABLE_INITIAL_CAPACITY ? table->count : USER_TABLE_INITIAL_CAPACITY;
+    size_t namesCapacity = table->namesSize > 4096 ? table->namesSize : 4096;
+    PackedUser* records = (PackedUser*)malloc((size_t)recordCapacity * sizeof(PackedUser));
+    uint8_t* names = (uint8_t*)malloc(namesCapacity);
+    UserSlot* slots = (UserSlot*)malloc((size_t)table->capacity * sizeof(UserSlot));
+    if (records == NULL || names == NULL || slots == NULL) {
+        free(records);
+        free(names);
+        free(slots);
+        return false;
+    }
+
+    memcpy(records, table->records, (size_t)table->count * sizeof(PackedUser));
+    memcpy(names, table->names, table->namesSize);
+    memcpy(slots, table->slots, (size_t)table->capacity * sizeof(UserSlot));
+    table->records = records;
+    table->recordCapacity = recordCapacity;
+    table->names = names;
+    table->namesCapacity = namesCapacity;
+    table->slots = slots;
+    if (userFileHolds(table->filter)) {
+        UserFilterBlock* filter = allocUserFilter(table->filterBlocks);
+        if (filter != NULL) {
+            memcpy(filter, table->filter, (size_t)table->filterBlocks * sizeof(UserFilterBlock));
+        }
+        table->filter = filter;
+    }
+    unmapFile(&userFile);
+    return true;
+}
+
+/**
+ * @brief Number of slots in one bucket of the bucketed probe policy (one 64-byte cache line).
+ */
+#define USER_PROBE_BUCKET_SLOTS 8
+
+/**
+ * @brief Collision resolution policies of the user index.
+ *
+ * Every policy visits all slots of a power-of-two table, so an insertion into a
+ * table below its load factor always finds an empty slot. USER_PROBE_QUADRATIC
+ * is 0 so that users.bin files written before the policy was recorded keep
+ * their meaning.
+ */
+typedef enum UserProbePolicy {
+    USER_PROBE_QUADRATIC,        /**< Steps of 1, 2, 3, ... (triangular numbers). */
+    USER_PROBE_LINEAR,           /**< Steps of 1. */
+    USER_PROBE_DOUBLE_HASH,      /**< Steps of an odd stride derived from the high hash bits. */
+    USER_PROBE_BRENT,            /**< Double hashing; insertions move a resident key when that shortens the chain. */
+    USER_PROBE_BUCKETED,         /**< Scans a cache-line bucket, then moves to other buckets quadratically. */
+    USER_PROBE_POLICY_COUNT      /**< Number of policies. */
+} UserProbePolicy;
+
+/**
+ * @brief Names of the probe policies, indexed by UserProbePolicy.
+ */
+const char* userProbePolicyNames[USER_PROBE_POLICY_COUNT] = {
+    "quadratic", "linear", "double_hash", "brent", "bucketed"
+};
+
+/**
+ * @brief Probe policy used by the user table.
+ *
+ * Change it with `setUserProbePolicy`, which also rebuilds the index.
+ */
+UserProbePolicy userProbePolicy = USER_PROBE_QUADRATIC;
+
+/**
+ * @brief Position in the probe sequence of a hash value.
+ */
+typedef struct UserProbe {
+    unsigned index;              /**< Slot to examine. */
+    unsigned count;              /**< Number of slots examined before `index`. */
+    unsigned step;               /**< Stride of the double hashing policies. */
+    unsigned mask;               /**< Capacity of the slot array minus one. */
+} UserProbe;
+
+/**
+ * @brief Returns the double hashing stride of a hash value.
+ *
+ * The hash is remixed so the stride draws on the high bits that the home slot
+ * ignores; keys sharing a home slot then diverge even in large arrays. The
+ * stride is odd, so it is coprime with the power-of-two capacity and the
+ * sequence visits every slot.
+ */
+unsigned userProbeStride(unsigned h, unsigned mask) {
+    unsigned mixed = h * 0x9E3779B1u;
+    return (((mixed >> 16) | (mixed << 16)) & mask) | 1u;
+}
+
+/**
+ * @brief Starts the probe sequence of a hash value under the current policy.
+ *
+ * @param h Hash value of the key.
+ * @param capacity Number of slots in the array (power of two).
+ * @return The first position of the sequence.
+ */
+UserProbe userProbeStart(unsigned h, unsigned capacity) {
+    UserProbe probe;
+    probe.mask = capacity - 1;
+    probe.count = 0;
+    probe.step = userProbeStride(h, probe.mask);
+    probe.index = h & probe.mask;
+    if (userProbePolicy == USER_PROBE_BUCKETED && capacity >= USER_PROBE_BUCKET_SLOTS) {
+        probe.index &= ~(unsigned)(USER_PROBE_BUCKET_SLOTS - 1);
+    }
+    return probe;
+}
+
+/**
+ * @brief Advances a probe sequence to its next slot.
+ */
+void userProbeNext(UserProbe* probe) {
+    probe->count++;
+    switch (userProbePolicy) {
+    case USER_PROBE_LINEAR:
+        probe->index = (probe->index + 1) & probe->mask;
+        break;
+    case USER_PROBE_DOUBLE_HASH:
+    case USER_PROBE_BRENT:
+        probe->index = (probe->index + probe->step) & probe->mask;
+        break;
+    case USER_PROBE_BUCKETED:
+        if (probe->mask + 1 >= USER_PROBE_BUCKET_SLOTS) {
+            if (probe->count % USER_PROBE_BUCKET_SLOTS != 0) {
+                probe->index++; // Next slot of the same bucket
+            }
+            else {
+                unsigned base = probe->index & ~(unsigned)(USER_PROBE_BUCKET_SLOTS - 1);
+                probe->index = (base + (probe->count / USER_PROBE_BUCKET_SLOTS) * USER_PROBE_BUCKET_SLOTS) & probe->mask;
+            }
+            break;
+        }
+        probe->index = (probe->index + probe->count) & probe->mask;
+        break;
+    default:
+        probe->index = (probe->index + probe->count) & probe->mask;
+        break;
+    }
+}
+
+/**
+ * @brief Places a slot with Brent's variation of double hashing.
+ *
+ * If the new key would need `s` probes, every resident key met on the way is
+ * considered for a move further along its own double hashing sequence. When
+ * moving the key at probe `j` by `k` steps costs fewer probes than `s`
+ * (`j + k < s`), it is moved and the new key takes its slot, which keeps the
+ * average successful search close to 2.5 probes even at high load factors.
+ *
+ * @param slots The slot array to insert into.
+ * @param capacity Number of slots in the array (power of two).
+ * @param slot The slot to place.
+ * @return The number of slots a lookup of the new slot examines.
+ */
+unsigned userTablePlaceBrent(UserSlot* slots, unsigned capacity, UserSlot slot) {
+    UserProbe probe = userProbeStart(slot.hash, capacity);
+    while (slots[probe.index].record != 0) {
+        userProbeNext(&probe);
+    }
+    unsigned best = probe.count;
+    unsigned bestFrom = probe.index;
+    unsigned bestTo = probe.index;
+    unsigned position = probe.count;
+
+    UserProbe chain = userProbeStart(slot.hash, capacity);
+    for (unsigned j = 0; j + 1 < best; j++, userProbeNext(&chain)) {
+        unsigned mask = capacity - 1;
+        unsigned step = userProbeStride(slots[chain.index].hash, mask);
+        unsigned index = chain.index;
+        for (unsigned k = 1; j + k < best; k++) {
+            index = (index + step) & mask;
+            if (slots[index].record == 0) {
+                best = j + k;
+                bestFrom = chain.index;
+                bestTo = index;
+                position = j;
+                break;
+            }
+        }
+    }
+
+    if (bestFrom != bestTo) {
+        slots[bestTo] = slots[bestFrom];
+    }
+    slots[bestFrom] = slot;
+    return position + 1;
+}
+
+/**
+ * @brief Places a slot into a slot array using the current probe policy.
+ *
+ * The caller must make sure the array has at least one empty slot.
+ *
+ * @param slots The slot array to insert into.
+ * @param capacity Number of slots in the array (power of two).
+ * @param slot The slot to place.
+ * @return The number of slots a lookup of the new slot examines.
+ */
+unsigned userTablePlace(UserSlot* slots, unsigned capacity, UserSlot slot) {
+    if (userProbePolicy == USER_PROBE_BRENT) {
+        return userTablePlaceBrent(slots, capacity, slot);
+    }
+    UserProbe probe = userProbeStart(slot.hash, capacity);
+    while (slots[probe.index].record != 0) {
+        userProbeNext(&probe);
+    }
+    slots[probe.index] = slot;
+    return probe.count + 1;
+}
+
+/**
+ * @brief Migrates a bounded number of slots from the old slot array during a rehash.
+ *
+ * Migrated slots are copied into the current slot array but left in place in the
+ * old one, so probe sequences in the old array stay intact for lookups until the
+ * whole array has been migrated and released.
+ *
+ * @param table Pointer to the UserTable being rehashed.
+ * @param steps Maximum number of old slots to migrate.
+ */
+void userTableMigrate(UserTable* table, unsigned steps) {
+    if (table->oldSlots == NULL) {
+        return;
+    }
+
+    while (steps > 0 && table->migrateIndex < table->oldCapacity) {
+        UserSlot slot = table->oldSlots[table->migrateIndex++];
+        if (slot.record != 0) {
+            userTablePlace(table->slots, table->capacity, slot);
+            userTableFilterAdd(table->filter, table->filterBlocks, slot.hash);
+        }
+        steps--;
+    }
+
+    if (table->migrateIndex == table->oldCapacity) {
+        free(table->oldSlots);
+        freeUserFilter(table->oldFilter);
+        table->oldSlots = NULL;
+        table->oldCapacity = 0;
+        table->migrateIndex = 0;
+        table->oldFilter = NULL;
+        table->oldFilterBlocks = 0;
+    }
+}
+
+/**
+ * @brief Rebuilds the slot array of the user table from the record slab.
+ *
+ * Any running rehash is dropped; every record is hashed again with the current
+ * hash function and placed into a fresh slot array of `capacity` slots.
+ *
+ * @param table Pointer to the UserTable to rebuild.
+ * @param capacity Number of slots of the new array (power of two).
+ * @return true if the new slot array was allocated; false otherwise.
+ */
+bool userTableRebuild(UserTable* table, unsigned capacity) {
+    UserSlot* newSlots = (UserSlot*)calloc(capacity, sizeof(UserSlot));
+    if (newSlots == NULL) {
+        return false;
+    }
+
+    for (unsigned i = 0; i < table->count; i++) {
+        UserSlot slot = { userTableRecordHash(table, i), i + 1 };
+        userTablePlace(newSlots, capacity, slot);
+    }
+
+    free(table->slots);
+    free(table->oldSlots);
+    freeUserFilter(table->filter);
+    freeUserFilter(table->oldFilter);
+    table->slots = newSlots;
+    table->capacity = capacity;
+    table->oldSlots = NULL;
+    table->oldCapacity = 0;
+    table->migrateIndex = 0;
+    table->filter = buildUserTableFilter(newSlots, capacity);
+    table->filterBlocks = userTableFilterSize(capacity);
+    table->oldFilter = NULL;
+    table->oldFilterBlocks = 0;
+    return true;
+}
+
+/**
+ * @brief Doubles the capacity of the user table and starts an incremental rehash.
+ *
+ * Any rehash that is still running is completed first, so at most two slot
+ * arrays exist at a time. The first call allocates the initial slot array.
+ *
+ * @param table Pointer to the UserTable to grow.
+ * @return true if the new slot array was allocated; false otherwise.
+ */
+bool userTableGrow(UserTable* table) {
+    userTableMigrate(table, table->oldCapacity);
+
+    unsigned newCapacity = table->capacity ? table->capacity * 2 : USER_TABLE_INITIAL_CAPACITY;
+    UserSlot* newSlots = (UserSlot*)calloc(newCapacity, sizeof(UserSlot));
+    if (newSlots == NULL) {
+        return false;
+    }
+
+    if (table->slots != NULL) {
+        table->oldSlots = table->slots;
+        table->oldCapacity = table->capacity;
+        table->migrateIndex = 0;
+        table->oldFilter = table->filter;
+        table->oldFilterBlocks = table->filterBlocks;
+    }
+    table->slots = newSlots;
+    table->capacity = newCapacity;
+    table->filterBlocks = userTableFilterSize(newCapacity);
+    table->filter = allocUserFilter(table->filterBlocks);
+    return true;
+}
+
+/**
+ * @brief Makes room for a number of users without further allocations.
+ *
+ * The record slab is resized to hold `users` records and, if needed, the slot
+ * array is rebuilt at a capacity that keeps `users` below the load factor
+ * threshold. Bulk loads call this once so they neither reallocate the slab nor
+ * rehash while inserting.
+ *
+ * @param table Pointer to the UserTable to reserve space in.
+ * @param users Total number of users the table must hold.
+ * @return true if the space was reserved; false if an allocation failed.
+ */
+bool userTableReserve(UserTable* table, unsigned users) {
+    if (!userTableDetach(table)) {
+        return false;
+    }
+    if (users > table->recordCapacity) {
+        PackedUser* records = (PackedUser*)realloc(table->records, (size_t)users * sizeof(PackedUser));
+        if (records == NULL) {
+            return false;
+        }
+        table->records = records;
+        table->recordCapacity = users;
+    }
+
+    unsigned capacity = table->capacity ? table->capacity : USER_TABLE_INITIAL_CAPACITY;
+    while ((unsigned long long)users * 100 > (unsigned long long)capacity * USER_TABLE_MAX_LOAD_PERCENT) {
+        capacity *= 2;
+    }
+    if (capacity != table->capacity || table->slots == NULL) {
+        return userTableRebuild(table, capacity);
+    }
+    return true;
+}
+
+/**
+ * @brief Size of one page of a paged users.bin file in bytes.
+ */
+#define USER_PAGE_SIZE 4096
+
+/**
+ * @brief Number of user records in one bucket page.
+ */
+#define USER_PAGE_RECORDS ((USER_PAGE_SIZE - 4 * sizeof(uint32_t)) / sizeof(User))
+
+/**
+ * @brief Signature that identifies a users.bin file in the paged layout.
+ */
+#define USER_PAGE_MAGIC "EVUP"
+
+/**
+ * @brief Version of the paged users.bin layout written by this build.
+ *
+ * Version 3 hashes and compares phone numbers by their canonical key (see
+ * `userPhoneKey`). Version 2 placed pages by extendible hashing of the phone
+ * number as entered. Version 1 placed records by progressive overflow into the
+ * following pages and had 8-byte page headers. Older files are still read and
+ * are rewritten in the current version at the next checkpoint.
+ */
+#define USER_PAGE_VERSION 3
+
+/**
+ * @brief Largest global depth of the page directory (2^24 directory entries).
+ */
+#define USER_PAGE_MAX_DEPTH 24
+
+/**
+ * @brief One bucket page of a paged users.bin file.
+ *
+ * Records fill the page from the front. Every record of the page has the same
+ * `depth` low bits of its hash, `prefix`; when the page is full it is split on
+ * the next bit into itself and a new page appended to the file.
+ */
+typedef struct UserPage {
+    uint32_t count;              /**< Number of records in the page. */
+    uint32_t depth;              /**< Local depth: number of low hash bits the records share. */
+    uint32_t prefix;             /**< The shared low hash bits. */
+    uint32_t reserved;           /**< Always 0. */
+    User records[USER_PAGE_RECORDS]; /**< The records, valid up to `count`. */
+} UserPage;
+
+/**
+ * @brief Header page at the start of a paged users.bin file.
+ *
+ * The header occupies the first USER_PAGE_SIZE bytes and is followed by
+ * `pageCount` bucket pages of the same size. The directory of extendible
+ * hashing maps the low `depth` bits of a phone number's hash to the page that
+ * holds it; it is kept in memory and saved next to the file (see
+ * `saveUserPageDirectory`). The file grows one page per split, so it is never
+ * reorganised as a whole.
+ */
+typedef struct UserPageFileHeader {
+    char magic[4];               /**< USER_PAGE_MAGIC, not null-terminated. */
+    uint32_t version;            /**< Format version, USER_PAGE_VERSION. */
+    uint32_t pageSize;           /**< USER_PAGE_SIZE of the writer. */
+    uint32_t recordSize;         /**< sizeof(User) of the writer. */
+    uint32_t hashFunction;       /**< Index of the hash function in `userHashFunctions`. */
+    uint32_t pageCount;          /**< Number of bucket pages after the header page. */
+    uint64_t count;              /**< Number of user records in the bucket pages. */
+    uint32_t logGeneration;      /**< Generation of the registration log this file supersedes. */
+    uint32_t depth;              /**< Global depth: the directory has 2^depth entries (0 in version 1). */
+} UserPageFileHeader;
+
+/**
+ * @brief Structure describing an open users.bin file in the paged layout.
+ */
+typedef struct UserPagedFile {
+    FILE* file;                  /**< The file opened for reading and writing, NULL when none is open. */
+    char path[260];              /**< Path of the file; the directory is saved as `path` + ".dir". */
+    UserPageFileHeader header;   /**< Copy of the header page. */
+    UserHashFunction hashFunction; /**< Hash function the pages were filled with. */
+    uint32_t* directory;         /**< Page index of each of the 2^depth directory entries (version 2). */
+    UserFilterBlock* filter;     /**< Filter block of each bucket page over the records it holds (version 2). */
+    uint32_t filterCapacity;     /**< Number of blocks allocated in `filter`. */
+    unsigned long long lookups;  /**< Lookups that searched the file. */
+    unsigned long long pageReads; /**< Pages read by those lookups. */
+    unsigned long long pageWrites; /**< Bucket pages written by inserts and splits. */
+} UserPagedFile;
+
+/**
+ * @brief Hashes a phone number the way a paged users file places it.
+ *
+ * @param paged The paged file.
+ * @param phone The phone number.
+ * @return The hash of the canonical key, or of the text before version 3.
+ */
+uint64_t userPagedPhoneHash(const UserPagedFile* paged, const char* phone) {
+    return paged->header.version >= 3 ? userPhoneHash(paged->hashFunction, phone) :
+        paged->hashFunction(phone, strlen(phone));
+}
+
+/**
+ * @brief Tells whether two phone numbers name the same record of a paged users file.
+ *
+ * @param paged The paged file.
+ * @param a A phone number.
+ * @param b Another phone number.
+ * @return true if both have the same canonical key, or the same text when they do not normalize or before version 3.
+ */
+bool userPagedPhonesMatch(const UserPagedFile* paged, const char* a, const char* b) {
+    uint64_t key = paged->header.version >= 3 ? userPhoneKey(a) : USER_PHONE_SPILLED;
+    return key != USER_PHONE_SPILLED ? userPhoneKey(b) == key : strcmp(a, b) == 0;
+}
+
+/**
+ * @brief Paged users.bin that lookups search after the user table.
+ *
+ * While `file` is not NULL the user table only holds the registrations made
+ * since the file was last written; every other user is read from disk one page
+ * at a time.
+ */
+UserPagedFile userPagedFile = { NULL, "", {}, NULL, NULL, NULL, 0, 0, 0, 0 };
+
+/**
+ * @brief Serializes page reads of lookups, which share the file position.
+ *
+ * Writes happen under the exclusive user store lock and need no further locking.
+ */
+std::mutex userPagedFileMutex;
+
+/**
+ * @brief Moves a file position to a 64-bit byte offset.
+ *
+ * @param file The file to seek in.
+ * @param offset Byte offset from the start of the file.
+ * @return true if the position was moved; false otherwise.
+ */
+bool seekUserFile(FILE* file, uint64_t offset) {
+#if defined(_WIN32) || defined(_WIN64)
+    return _fseeki64(file, (long long)offset, SEEK_SET) == 0;
+#else
+    return fseeko(file, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+/**
+ * @brief Reads one bucket page of a paged users file.
+ *
+ * Pages of version 1 files are converted to the current page header.
+ *
+ * @param paged The open paged file.
+ * @param index Index of the bucket page, starting at 0 after the header page.
+ * @param page Receives the page.
+ * @return true if the page was read; false otherwise.
+ */
+bool readUserPage(UserPagedFile* paged, uint32_t index, UserPage* page) {
+    if (!seekUserFile(paged->file, ((uint64_t)index + 1) * USER_PAGE_SIZE)) {
+        return false;
+    }
+    if (paged->header.version >= 2) {
+        return fread(page, sizeof(UserPage), 1, paged->file) == 1 && page->count <= USER_PAGE_RECORDS;
+    }
+    uint32_t legacy[2]; // Record count and a reserved word
+    if (fread(legacy, sizeof(legacy), 1, paged->file) != 1 || legacy[0] > USER_PAGE_RECORDS) {
+        return false;
+    }
+    memset(page, 0, offsetof(UserPage, records));
+    page->count = legacy[0];
+    return fread(page->records, sizeof(User), page->count, paged->file) == page->count;
+}
+
+/**
+ * @brief Writes one bucket page of a paged users file.
+ *
+ * @param paged The open paged file.
+ * @param index Index of the bucket page, starting at 0 after the header page.
+ * @param page The page to write.
+ * @return true if the page was written; false otherwise.
+ */
+bool writeUserPage(UserPagedFile* paged, uint32_t index, const UserPage* page) {
+    paged->pageWrites++;
+    return seekUserFile(paged->file, ((uint64_t)index + 1) * USER_PAGE_SIZE) &&
+        fwrite(page, sizeof(UserPage), 1, paged->file) == 1;
+}
+
+/**
+ * @brief Returns a mask of the low `depth` bits of a hash value.
+ */
+uint64_t userPageMask(uint32_t depth) {
+    return ((uint64_t)1 << depth) - 1;
+}
+
+/**
+ * @brief Copies the records of a phone number from a paged users file.
+ *
+ * In version 2 files the directory names the single page that can hold the
+ * phone number, so a lookup reads exactly one page, and none at all when the
+ * filter block of that page rejects the phone number. Version 1 files are
+ * searched from the home page on while the pages read are full.
+ *
+ * The caller must hold the user store lock, shared or exclusive.
+ *
+ * @param paged The paged file to search.
+ * @param key The key of the phone number, see `userPhoneKey`.
+ * @param phone The phone number to look for, used as text when `key` is USER_PHONE_SPILLED or before version 3.
+ * @param out Receives copies of the matching records.
+ * @param found Number of records already in `out`.
+ * @param max Capacity of `out`.
+ * @param searched Set to true if pages were read, i.e. the filter did not reject the phone number; may be NULL.
+ * @return The number of records in `out`.
+ */
+unsigned userPagedFileCollect(UserPagedFile* paged, uint64_t key, const char* phone, User* out, unsigned found,
+    unsigned max, bool* searched) {
+    if (paged->file == NULL || found >= max) {
+        return found;
+    }
+
+    UserPage page;
+    key = paged->header.version >= 3 ? key : USER_PHONE_SPILLED;
+    uint64_t h = key != USER_PHONE_SPILLED ? userKeyHash(paged->hashFunction, key) :
+        paged->hashFunction(phone, strlen(phone));
+    bool directory = paged->header.version >= 2;
+    uint32_t index = directory ? paged->directory[h & userPageMask(paged->header.depth)] :
+        (uint32_t)(h % paged->header.pageCount);
+    if (directory && paged->filter != NULL && !userFilterBlockContains(&paged->filter[index], userFilterMix(h))) {
+        return found;
+    }
+    if (searched != NULL) {
+        *searched = true;
+    }
+    std::lock_guard<std::mutex> guard(userPagedFileMutex);
+    paged->lookups++;
+    for (uint32_t i = 0; i < paged->header.pageCount && found < max; i++) {
+        if (!readUserPage(paged, index, &page)) {
+            break;
+        }
+        paged->pageReads++;
+        for (uint32_t j = 0; j < page.count && found < max; j++) {
+            const char* stored = page.records[j].phone;
+            if (key != USER_PHONE_SPILLED ? userPhoneKey(stored) == key : strcmp(stored, phone) == 0) {
+                out[found++] = page.records[j];
+            }
+        }
+        if (directory || page.count < USER_PAGE_RECORDS) {
+            break; // Progressive overflow never passes a page with free room
+        }
+        index = index + 1 == paged->header.pageCount ? 0 : index + 1;
+    }
+    return found;
+}
+
+/**
+ * @brief Calls a function for every user stored in a paged users file.
+ *
+ * The pages are read in file order. The caller must hold the user store lock,
+ * shared or exclusive.
+ *
+ * @param paged The paged file to read.
+ * @param visit Function called with each user and the context pointer.
+ * @param context Pointer passed through to `visit`.
+ */
+void userPagedFileForEach(UserPagedFile* paged, void (*visit)(User* user, void* context), void* context) {
+    UserPage page;
+    for (uint32_t i = 0; paged->file != NULL && i < paged->header.pageCount; i++) {
+        bool read;
+        {
+            std::lock_guard<std::mutex> guard(userPagedFileMutex);
+            read = readUserPage(paged, i, &page);
+        }
+        if (!read) {
+            break;
+        }
+        for (uint32_t j = 0; j < page.count; j++) {
+            visit(&page.records[j], context);
+        }
+    }
+}
+
+/**
+ * @brief Closes a paged users file and releases its directory and filter.
+ *
+ * @param paged The paged file to close; it is reset to empty.
+ */
+void closeUserPagedFile(UserPagedFile* paged) {
+    if (paged->file != NULL) {
+        fclose(paged->file);
+    }
+    free(paged->directory);
+    freeUserFilter(paged->filter);
+    memset(paged, 0, sizeof(*paged));
+}
+
+/**
+ * @brief Makes room in the filter of a paged users file for a number of pages.
+ *
+ * The filter doubles when it grows; blocks of pages not written yet are zero.
+ *
+ * @param paged The open paged file.
+ * @param pages Number of bucket pages the filter must cover.
+ * @return true if the filter covers `pages` pages; false if it could not grow.
+ */
+bool userPageFilterReserve(UserPagedFile* paged, uint32_t pages) {
+    if (pages <= paged->filterCapacity) {
+        return true;
+    }
+    uint32_t capacity = paged->filterCapacity > pages / 2 ? paged->filterCapacity * 2 : pages;
+    UserFilterBlock* filter = allocUserFilter(capacity);
+    if (filter == NULL) {
+        return false;
+    }
+    if (paged->filter != NULL) {
+        memcpy(filter, paged->filter, (size_t)paged->filterCapacity * sizeof(UserFilterBlock));
+    }
+    freeUserFilter(paged->filter);
+    paged->filter = filter;
+    paged->filterCapacity = capacity;
+    return true;
+}
+
+/**
+ * @brief Refills the filter block of a bucket page from the records of the page.
+ *
+ * @param paged The open paged file; its filter must cover `index`.
+ * @param index Index of the bucket page.
+ * @param page The contents of the page.
+ */
+void userPageFilterRebuild(UserPagedFile* paged, uint32_t index, const UserPage* page) {
+    UserFilterBlock* block = &paged->filter[index];
+    memset(block, 0, sizeof(*block));
+    for (uint32_t j = 0; j < page->count; j++) {
+        const char* phone = page->records[j].phone;
+        userFilterBlockAdd(block, userFilterMix(userPagedPhoneHash(paged, phone)));
+    }
+}
+
+/**
+ * @brief Collects the records stored under a phone number from one slot array.
+ *
+ * Records already in `out` are skipped; during a rehash a migrated slot is
+ * present in both slot arrays.
+ *
+ * @param slots The slot array to search.
+ * @param capacity Number of slots in the array (power of two).
+ * @param h Hash value of the phone number.
+ * @param key The key of the phone number, see `userPhoneKey`.
+ * @param phone The phone number to look for.
+ * @param out Receives copies of the matching records.
+ * @param indexes Record indexes of the records in `out`.
+ * @param found Number of records already in `out`.
+ * @param max Capacity of `out`.
+ * @param probes Incremented by the number of slots examined.
+ * @return The number of records in `out`.
+ */
+unsigned userTableCollectSlots(const UserSlot* slots, unsigned capacity, unsigned h, uint64_t key, const char* phone,
+    User* out, unsigned* indexes, unsigned found, unsigned max, unsigned* probes) {
+    UserProbe probe = userProbeStart(h, capacity);
+    for (; slots[probe.index].record != 0 && found < max; userProbeNext(&probe)) {
+        const UserSlot* slot = &slots[probe.index];
+        if (slot->hash == h) {
+            unsigned record = slot->record - 1;
+            bool seen = false;
+            for (unsigned j = 0; j < found; j++) {
+                seen = seen || indexes[j] == record;
+            }
+            if (!seen && userTableRecordHasPhone(&userTable, &userTable.records[record], key, phone)) {
+                userTableUnpack(&userTable, &userTable.records[record], &out[found]);
+                indexes[found++] = record;
+            }
+        }
+    }
+    *probes += probe.count + (slots[probe.index].record == 0);
+    return found;
+}
+
+/**
+ * @brief Overwrites the records stored under a phone number in one slot array.
+ *
+ * The caller must hold the user store lock exclusively, and the table must own its memory.
+ *
+ * @param slots The slot array to search.
+ * @param capacity Number of slots in the array (power of two).
+ * @param h Hash value of the phone number.
+ * @param phone The phone number whose records are overwritten.
+ * @param user The new packed record of the phone number.
+ * @return The number of slots whose record was overwritten.
+ */
+unsigned userTableReplaceSlots(const UserSlot* slots, unsigned capacity, unsigned h, const char* phone,
+    const PackedUser* user) {
+    unsigned replaced = 0;
+    for (UserProbe probe = userProbeStart(h, capacity); slots[probe.index].record != 0; userProbeNext(&probe)) {
+        PackedUser* record = &userTable.records[slots[probe.index].record - 1];
+        if (slots[probe.index].hash == h && userTableRecordHasPhone(&userTable, record, user->phone, phone)) {
+            *record = *user;
+            replaced++;
+        }
+    }
+    return replaced;
+}
+
+/**
+ * @brief Overwrites every record of the user table stored under a phone number.
+ *
+ * Files written before registrations were upserted can hold several records
+ * of one phone number; all of them receive the new record, so none of the
+ * old passwords is accepted any more. The strings of the replaced records
+ * stay in the name arena until the table is compacted.
+ *
+ * The caller must hold the user store lock exclusively, and the table must own its memory.
+ *
+ * @param user The new record, with its password hashed.
+ * @param h Hash value of its phone number.
+ * @return true if a record was overwritten; false if the phone number is not in
+ *         the table or the name arena could not grow.
+ */
+bool userTableReplace(const User* user, unsigned h) {
+    bool current = userTable.slots != NULL && userTableFilterContains(userTable.filter, userTable.filterBlocks, h);
+    bool old = userTable.oldSlots != NULL &&
+        userTableFilterContains(userTable.oldFilter, userTable.oldFilterBlocks, h);
+    if (!current && !old) {
+        return false;
+    }
+    size_t namesSize = userTable.namesSize;
+    PackedUser packed;
+    if (!userTablePack(&userTable, user, &packed)) {
+        return false;
+    }
+    unsigned replaced = 0;
+    if (current) {
+        replaced += userTableReplaceSlots(userTable.slots, userTable.capacity, h, user->phone, &packed);
+    }
+    if (old) {
+        replaced += userTableReplaceSlots(userTable.oldSlots, userTable.oldCapacity, h, user->phone, &packed);
+    }
+    if (replaced == 0) {
+        userTable.namesSize = namesSize; // A filter false positive; drop the unused strings
+    }
+    return replaced > 0;
+}
+
+/**
+ * @brief Tells whether the user table holds a record of a phone number.
+ *
+ * The caller must hold the user store lock, shared or exclusive.
+ */
+bool userTableHolds(const char* phone) {
+    User record;
+    unsigned index;
+    unsigned probes = 0;
+    uint64_t key = userPhoneKey(phone);
+    unsigned h = key != USER_PHONE_SPILLED ? hashUserKey(key) : hash(phone);
+    return (userTable.slots != NULL && userTableFilterContains(userTable.filter, userTable.filterBlocks, h) &&
+        userTableCollectSlots(userTable.slots, userTable.capacity, h, key, phone, &record, &index, 0, 1, &probes) > 0) ||
+        (userTable.oldSlots != NULL && userTableFilterContains(userTable.oldFilter, userTable.oldFilterBlocks, h) &&
+        userTableCollectSlots(userTable.oldSlots, userTable.oldCapacity, h, key, phone, &record, &index, 0, 1,
+        &probes) > 0);
+}
+
+/**
+ * @brief Defines the number of buckets of the probe count histograms; the last one counts longer probes.
+ */
+#define USER_METRICS_PROBE_BUCKETS 16
+
+/**
+ * @brief Defines the number of buckets of the lookup latency histogram.
+ *
+ * Bucket `b` counts lookups that took from 2^b to 2^(b+1) nanoseconds; the
+ * last one counts every lookup above 8 ms.
+ */
+#define USER_METRICS_LATENCY_BUCKETS 24
+
+/**
+ * @brief Defines how many logins of a thread share one timed lookup.
+ *
+ * Reading the clock twice costs about as much as a filter rejection, so only
+ * every eighth lookup is timed.
+ */
+#define USER_METRICS_LATENCY_SAMPLE 8
+
+/**
+ * @brief Counters of the user table kept by one thread.
+ *
+ * Only the owning thread writes a block, with relaxed loads and stores and no
+ * read-modify-write, so counting costs the same as a plain increment and
+ * threads never share a written cache line. Readers sum all blocks, see
+ * `userTableMetrics`. A block outlives its thread and is handed to the next
+ * thread that starts counting, so no count is ever lost.
+ */
+typedef struct UserMetrics {
+    std::atomic<unsigned long long> inserts;        /**< Phone numbers added to the table. */
+    std::atomic<unsigned long long> replacements;   /**< Records overwritten by re-registrations. */
+    std::atomic<unsigned long long> lookups;        /**< Lookups through `userTableCollect`. */
+    std::atomic<unsigned long long> logins;         /**< Calls of `validateLogin`. */
+    std::atomic<unsigned long long> failedLogins;   /**< Calls of `validateLogin` that returned false. */
+    std::atomic<unsigned long long> filterRejections;     /**< Lookups of unregistered numbers the filters rejected. */
+    std::atomic<unsigned long long> filterFalsePositives; /**< Lookups of unregistered numbers the filters let through. */
+    std::atomic<unsigned long long> insertProbes[USER_METRICS_PROBE_BUCKETS]; /**< Inserts by chain length reached. */
+    std::atomic<unsigned long long> lookupProbes[USER_METRICS_PROBE_BUCKETS]; /**< Lookups by slots examined. */
+    std::atomic<unsigned long long> lookupLatency[USER_METRICS_LATENCY_BUCKETS]; /**< Timed lookups by duration. */
+    unsigned untimed;                               /**< Lookups since the last timed one; owner only. */
+    std::atomic<bool> owned;                        /**< Whether a running thread writes the block. */
+    struct UserMetrics* next;                       /**< Next block of `userMetricsBlocks`. */
+} UserMetrics;
+
+/**
+ * @brief Every counter block ever handed out, guarded by `userMetricsMutex`.
+ *
+ * Blocks are only ever prepended, never freed.
+ */
+UserMetrics* userMetricsBlocks = NULL;
+
+/**
+ * @brief Mutex guarding `userMetricsBlocks`.
+ */
+std::mutex userMetricsMutex;
+
+/**
+ * @brief Counter block of the calling thread, NULL until it first counts.
+ */
+thread_local UserMetrics* userMetricsLocal = NULL;
+
+/**
+ * @brief Releases the counter block of a thread when the thread exits.
+ */
+typedef struct UserMetricsOwner {
+    UserMetrics* metrics;        /**< The block of the thread. */
+
+    ~UserMetricsOwner() {
+        if (metrics != NULL) {
+            metrics->owned.store(false, std::memory_order_release);
+        }
+    }
+} UserMetricsOwner;
+
+/**
+ * @brief Owner of the counter block of the calling thread.
+ */
+thread_local UserMetricsOwner userMetricsOwner = { NULL };
+
+/**
+ * @brief Hands a counter block to the calling thread, reusing one of an exited thread if possible.
+ *
+ * @return The block; NULL if no block is free and none could be allocated.
+ */
+UserMetrics* userMetricsAttach() {
+    std::lock_guard<std::mutex> guard(userMetricsMutex);
+    UserMetrics* metrics = userMetricsBlocks;
+    while (metrics != NULL && metrics->owned.load(std::memory_order_acquire)) {
+        metrics = metrics->next;
+    }
+    if (metrics == NULL) {
+        metrics = (UserMetrics*)calloc(1, sizeof(UserMetrics));
+        if (metrics == NULL) {
+            return NULL;
+        }
+        metrics->next = userMetricsBlocks;
+        userMetricsBlocks = metrics;
+    }
+    metrics->owned.store(true, std::memory_order_relaxed);
+    userMetricsOwner.metrics = metrics;
+    userMetricsLocal = metrics;
+    return metrics;
+}
+
+/**
+ * @brief Returns the counter block of the calling thread.
+ *
+ * @return The block; NULL if none could be allocated, in which case nothing is counted.
+ */
+UserMetrics* userMetricsThread() {
+    UserMetrics* metrics = userMetricsLocal;
+    return metrics != NULL ? metrics : userMetricsAttach();
+}
+
+/**
+ * @brief Adds to a counter of the calling thread's block.
+ */
+void userMetricsAdd(std::atomic<unsigned long long>* counter, unsigned long long value) {
+    counter->store(counter->load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Counts an event in a probe count histogram.
+ */
+void userMetricsCountProbes(std::atomic<unsigned long long>* histogram, unsigned probes) {
+    userMetricsAdd(&histogram[probes < USER_METRICS_PROBE_BUCKETS ? probes : USER_METRICS_PROBE_BUCKETS - 1], 1);
+}
+
+/**
+ * @brief Copies the records stored under a phone number.
+ *
+ * The current slot array is searched first; while a rehash is running, users that
+ * have not been migrated yet are found in the old slot array. When users.bin is
+ * in the paged layout and the table holds no record of the phone number, the
+ * users registered before its last checkpoint are then read from its pages; a
+ * record in the table replaces the one on a page until the next checkpoint
+ * writes it there. Lookups never advance the rehash, so they only need the
+ * store lock in shared mode.
+ *
+ * Each slot array and each page is searched only if its filter may hold the
+ * phone number, so most lookups of unregistered numbers touch one or two
+ * filter cache lines and nothing else.
+ *
+ * The caller must hold the user store lock, shared or exclusive.
+ *
+ * @param key The key of the phone number, see `userPhoneKey`.
+ * @param phone The phone number to look for, compared as text when `key` is USER_PHONE_SPILLED.
+ * @param out Receives copies of the matching records, in probe order.
+ * @param max Capacity of `out`, at most USER_LOOKUP_MAX_RECORDS.
+ * @param searched Set to true if a filter let the lookup through to slots or a page.
+ * @param probes Incremented by the number of slots examined in the slot arrays.
+ * @return The number of records copied.
+ */
+unsigned userTableSearchKey(uint64_t key, const char* phone, User* out, unsigned max, bool* searched,
+    unsigned* probes) {
+    unsigned indexes[USER_LOOKUP_MAX_RECORDS];
+    max = max < USER_LOOKUP_MAX_RECORDS ? max : USER_LOOKUP_MAX_RECORDS;
+    unsigned found = 0;
+    if (userTable.slots != NULL) {
+        unsigned h = key != USER_PHONE_SPILLED ? hashUserKey(key) : hash(phone);
+        if (userTableFilterContains(userTable.filter, userTable.filterBlocks, h)) {
+            *searched = true;
+            found = userTableCollectSlots(userTable.slots, userTable.capacity, h, key, phone, out, indexes, 0, max,
+                probes);
+        }
+        if (userTable.oldSlots != NULL && userTableFilterContains(userTable.oldFilter, userTable.oldFilterBlocks, h)) {
+            *searched = true;
+            found = userTableCollectSlots(userTable.oldSlots, userTable.oldCapacity, h, key, phone, out, indexes, found,
+                max, probes);
+        }
+    }
+    if (found == 0) {
+        found = userPagedFileCollect(&userPagedFile, key, phone, out, found, max, searched);
+    }
+    return found;
+}
+
+/**
+ * @brief Copies the records stored under a phone number, see `userTableSearchKey`.
+ *
+ * The caller must hold the user store lock, shared or exclusive.
+ */
+unsigned userTableSearch(const char* phone, User* out, unsigned max, bool* searched, unsigned* probes) {
+    return userTableSearchKey(userPhoneKey(phone), phone, out, max, searched, probes);
+}
+
+/**
+ * @brief Copies the records stored under a phone number and counts the lookup.
+ *
+ * The lookup and the slots it examined are counted in the metrics of the
+ * calling thread; lookups that find nothing are also counted as rejected or as
+ * false positives of the filters. The caller must hold the user store lock,
+ * shared or exclusive.
+ *
+ * @see userTableSearch()
+ */
+unsigned userTableCollect(const char* phone, User* out, unsigned max) {
+    bool searched = false;
+    unsigned probes = 0;
+    unsigned found = userTableSearch(phone, out, max, &searched, &probes);
+    UserMetrics* metrics = userMetricsThread();
+    if (metrics != NULL) {
+        userMetricsAdd(&metrics->lookups, 1);
+        userMetricsCountProbes(metrics->lookupProbes, probes);
+        if (found == 0 && (userTable.slots != NULL || userPagedFile.file != NULL)) {
+            userMetricsAdd(searched ? &metrics->filterFalsePositives : &metrics->filterRejections, 1);
+        }
+    }
+    return found;
+}
+
+/**
+ * @brief Copies the record of a registered user.
+ *
+ * @param phone The phone number of the user.
+ * @param out Pointer to a User structure that receives the record.
+ * @return true if the user is registered; false otherwise.
+ */
+bool findUser(const char* phone, User* out) {
+    lockUserStore(false);
+    bool found = userTableCollect(phone, out, 1) == 1;
+    unlockUserStore(false);
+    return found;
+}
+
+/**
+ * @brief A visit function and its context, passed through `visitPagedUser`.
+ */
+typedef struct UserVisitor {
+    void (*visit)(User* user, void* context); /**< Function called with each user. */
+    void* context;                            /**< Pointer passed through to `visit`. */
+} UserVisitor;
+
+/**
+ * @brief Visits a user read from a page unless the table holds a newer record of its phone number.
+ *
+ * @param user The user read from the page.
+ * @param context Pointer to the UserVisitor.
+ */
+void visitPagedUser(User* user, void* context) {
+    UserVisitor* visitor = (UserVisitor*)context;
+    if (!userTableHolds(user->phone)) {
+        visitor->visit(user, visitor->context);
+    }
+}
+
+/**
+ * @brief Calls a function for every user stored in the hash table.
+ *
+ * Users are visited in registration order from the record slab, each unpacked
+ * into a temporary User, after the pages of a paged users.bin; page records
+ * replaced by a record in the table are skipped. The store lock is held in
+ * shared mode, so `visit` must not modify the store.
+ *
+ * @param visit Function called with each user and the context pointer.
+ * @param context Pointer passed through to `visit`.
+ */
+void forEachUser(void (*visit)(User* user, void* context), void* context) {
+    lockUserStore(false);
+    UserVisitor visitor = { visit, context };
+    userPagedFileForEach(&userPagedFile, userTable.count > 0 ? visitPagedUser : visit,
+        userTable.count > 0 ? (void*)&visitor : context);
+    User user;
+    for (unsigned i = 0; i < userTable.count; i++) {
+        userTableUnpack(&userTable, &userTable.records[i], &user);
+        visit(&user, context);
+    }
+    unlockUserStore(false);
+}
+
+/**
+ * @brief Fields of a user that the name index answers prefix queries on.
+ */
+typedef enum UserNameField {
+    USER_NAME_FIELD_NAME = 1,    /**< User::name; also the root node of its trie. */
+    USER_NAME_FIELD_SURNAME = 2  /**< User::surname; also the root node of its trie. */
+} UserNameField;
+
+/**
+ * @brief One node of the name index, a byte trie.
+ *
+ * Nodes 1 and 2 are the roots of the name and the surname trie; node 0 is
+ * unused, so that 0 can stand for no node. The children of a node form a
+ * sibling list sorted by byte, so a depth-first walk lists names in byte
+ * order, and each node counts the users of its subtree so a walk can step
+ * over a whole subtree to reach a page of results.
+ */
+typedef struct UserNameNode {
+    uint32_t child;              /**< Index of the first child, or 0. */
+    uint32_t sibling;            /**< Index of the next sibling, or 0. */
+    uint32_t list;               /**< Index + 1 of the list of users whose name ends at the node, or 0. */
+    uint32_t count;              /**< Number of users listed in the subtree of the node. */
+    uint8_t byte;                /**< Lowercased byte on the edge into the node. */
+} UserNameNode;
+
+/**
+ * @brief The users listed under one name in the name index.
+ *
+ * Users are referred to by the key of their phone number, so the list stays
+ * valid while their records move between the table and the pages of users.bin.
+ * The keys are kept in an array so a page can start anywhere in the list.
+ */
+typedef struct UserNameList {
+    uint64_t* keys;              /**< Phone number keys, or USER_PHONE_SPILLED | offset of the phone number in `phones`. */
+    uint32_t count;              /**< Number of keys. */
+    uint32_t capacity;           /**< Number of keys allocated. */
+} UserNameList;
+
+/**
+ * @brief Secondary index of the users by name and by surname.
+ *
+ * The index is built from every user by the first prefix query and kept in
+ * sync by `userTableUpsert` from then on. Loads and bulk appends, which
+ * replace users wholesale, drop it to be rebuilt by the next query, so
+ * startup does not pay for it.
+ */
+typedef struct UserNameIndex {
+    UserNameNode* nodes;         /**< Trie nodes; 1 and 2 are the roots. */
+    uint32_t nodeCount;          /**< Number of nodes in use. */
+    uint32_t nodeCapacity;       /**< Number of nodes allocated. */
+    UserNameList* lists;         /**< Lists of the nodes that end a name. */
+    uint32_t listCount;          /**< Number of lists in use. */
+    uint32_t listCapacity;       /**< Number of lists allocated. */
+    char* phones;                /**< Phone numbers that do not normalize, null-terminated. */
+    size_t phonesSize;           /**< Bytes of `phones` in use. */
+    size_t phonesCapacity;       /**< Bytes of `phones` allocated. */
+    bool built;                  /**< Whether the index lists every user. */
+} UserNameIndex;
+
+/**
+ * @brief The name index of the user store.
+ */
+UserNameIndex userNameIndex = { NULL, 0, 0, NULL, 0, 0, NULL, 0, 0, false };
+
+/**
+ * @brief Releases the name index; the next prefix query rebuilds it.
+ *
+ * The caller must hold the user store lock exclusively.
+ */
+void userNameIndexReset() {
+    for (uint32_t i = 0; i < userNameIndex.listCount; i++) {
+        free(userNameIndex.lists[i].keys);
+    }
+    free(userNameIndex.nodes);
+    free(userNameIndex.lists);
+    free(userNameIndex.phones);
+    memset(&userNameIndex, 0, sizeof(userNameIndex));
+}
+
+/**
+ * @brief Lowercases an ASCII letter of a name; other bytes, such as UTF-8 sequences, are kept.
+ */
+uint8_t userNameByte(char c) {
+    return (uint8_t)(c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c);
+}
+
+/**
+ * @brief Grows the arrays of the name index so that an insert cannot fail halfway.
+ *
+ * @param index The name index.
+ * @param nodes Number of nodes the insert may add.
+ * @param phone Bytes the insert may add to `phones`.
+ * @return true if the room is available; false if an allocation failed.
+ */
+bool userNameIndexReserve(UserNameIndex* index, uint32_t nodes, size_t phone) {
+    if (index->nodeCount + nodes > index->nodeCapacity) {
+        uint32_t capacity = index->nodeCapacity ? index->nodeCapacity : 1024;
+        while (capacity < index->nodeCount + nodes) {
+            capacity *= 2;
+        }
+        UserNameNode* grown = (UserNameNode*)realloc(index->nodes, (size_t)capacity * sizeof(UserNameNode));
+        if (grown == NULL) {
+            return false;
+        }
+        index->nodes = grown;
+        index->nodeCapacity = capacity;
+    }
+    if (index->listCount == index->listCapacity) {
+        uint32_t capacity = index->listCapacity ? index->listCapacity * 2 : 256;
+        UserNameList* grown = (UserNameList*)realloc(index->lists, (size_t)capacity * sizeof(UserNameList));
+        if (grown == NULL) {
+            return false;
+        }
+        index->lists = grown;
+        index->listCapacity = capacity;
+    }
+    if (index->phonesSize + phone > index->phonesCapacity) {
+        size_t capacity = index->phonesCapacity ? index->phonesCapacity : 256;
+        while (capacity < index->phonesSize + phone) {
+            capacity *= 2;
+        }
+        char* grown = (char*)realloc(index->phones, capacity);
+        if (grown == NULL) {
+            return false;
+        }
+        index->phones = grown;
+        index->phonesCapacity = capacity;
+    }
+    return true;
+}
+
+/**
+ * @brief Finds the child of a node of the name index on a byte.
+ *
+ * @param index The name index.
+ * @param node The parent node.
+ * @param byte The lowercased byte.
+ * @return The index of the child, or 0 if there is none.
+ */
+uint32_t userNameIndexChild(const UserNameIndex* index, uint32_t node, uint8_t byte) {
+    uint32_t child = index->nodes[node].child;
+    while (child != 0 && index->nodes[child].byte < byte) {
+        child = index->nodes[child].sibling;
+    }
+    return child != 0 && index->nodes[child].byte == byte ? child : 0;
+}
+
+/**
+ * @brief Finds the node of a name or prefix in the name index.
+ *
+ * @param index The name index.
+ * @param field The trie to search.
+ * @param text The name or prefix; compared without regard to ASCII case.
+ * @param length Number of bytes of `text`.
+ * @return The index of the node, or 0 if no indexed name starts with `text`.
+ */
+uint32_t userNameIndexFind(const UserNameIndex* index, UserNameField field, const char* text, size_t length) {
+    uint32_t node = (uint32_t)field;
+    for (size_t i = 0; i < length && node != 0; i++) {
+        node = userNameIndexChild(index, node, userNameByte(text[i]));
+    }
+    return node;
+}
+
+/**
+ * @brief Lists a user under a name in the name index.
+ *
+ * Nodes are created for the name first; the counts only change once the user
+ * is in the list of the name, so a failed insert leaves at most unused nodes.
+ *
+ * @param index The name index; its roots must exist.
+ * @param field The trie to insert into.
+ * @param text The name or surname.
+ * @param key The key of the user's phone number, see `userPhoneKey`.
+ * @param phone The user's phone number, stored when it does not normalize.
+ * @return true if the user is listed; false if the index could not grow.
+ */
+bool userNameIndexAdd(UserNameIndex* index, UserNameField field, const char* text, uint64_t key, const char* phone) {
+    size_t length = strnlen(text, sizeof(((User*)0)->name));
+    size_t phoneLength = key == USER_PHONE_SPILLED ? strnlen(phone, sizeof(((User*)0)->phone) - 1) + 1 : 0;
+    if (!userNameIndexReserve(index, (uint32_t)length, phoneLength)) {
+        return false;
+    }
+    uint32_t path[sizeof(((User*)0)->name) + 1];
+    uint32_t node = (uint32_t)field;
+    path[0] = node;
+    for (size_t i = 0; i < length; i++) {
+        uint8_t byte = userNameByte(text[i]);
+        uint32_t* link = &index->nodes[node].child;
+        while (*link != 0 && index->nodes[*link].byte < byte) {
+            link = &index->nodes[*link].sibling;
+        }
+        if (*link == 0 || index->nodes[*link].byte != byte) {
+            uint32_t added = index->nodeCount++;
+            memset(&index->nodes[added], 0, sizeof(UserNameNode));
+            index->nodes[added].byte = byte;
+            index->nodes[added].sibling = *link;
+            *link = added;
+        }
+        node = *link;
+        path[i + 1] = node;
+    }
+
+    if (index->nodes[node].list == 0) {
+        memset(&index->lists[index->listCount], 0, sizeof(UserNameList));
+        index->nodes[node].list = ++index->listCount;
+    }
+    UserNameList* list = &index->lists[index->nodes[node].list - 1];
+    if (list->count == list->capacity) {
+        uint32_t capacity = list->capacity ? list->capacity * 2 : 2;
+        uint64_t* grown = (uint64_t*)realloc(list->keys, (size_t)capacity * sizeof(uint64_t));
+        if (grown == NULL) {
+            return false;
+        }
+        list->keys = grown;
+        list->capacity = capacity;
+    }
+    if (key == USER_PHONE_SPILLED) {
+        key |= index->phonesSize;
+        memcpy(index->phones + index->phonesSize, phone, phoneLength - 1);
+        index->phones[index->phonesSize + phoneLength - 1] = '\0';
+        index->phonesSize += phoneLength;
+    }
+    list->keys[list->count++] = key;
+    for (size_t i = 0; i <= length; i++) {
+        index->nodes[path[i]].count++;
+    }
+    return true;
+}
+
+/**
+ * @brief Tells whether a key of the name index refers to a phone number.
+ */
+bool userNameKeyHasPhone(const UserNameIndex* index, uint64_t listed, uint64_t key, const char* phone) {
+    if (key != USER_PHONE_SPILLED) {
+        return listed == key;
+    }
+    return (listed & USER_PHONE_SPILLED) == USER_PHONE_SPILLED &&
+        strcmp(index->phones + (listed & ~USER_PHONE_SPILLED), phone) == 0;
+}
+
+/**
+ * @brief Removes a user from under a name in the name index.
+ *
+ * The last user of the list takes its place. Nodes are never freed; a node
+ * whose subtree lists nobody is stepped over by queries.
+ *
+ * @param index The name index.
+ * @param field The trie to remove from.
+ * @param text The name or surname the user was listed under.
+ * @param key The key of the user's phone number, see `userPhoneKey`.
+ * @param phone The user's phone number.
+ * @return true if the user was listed and is removed; false if it was not listed.
+ */
+bool userNameIndexRemove(UserNameIndex* index, UserNameField field, const char* text, uint64_t key,
+    const char* phone) {
+    size_t length = strnlen(text, sizeof(((User*)0)->name));
+    uint32_t node = userNameIndexFind(index, field, text, length);
+    if (node == 0 || index->nodes[node].list == 0) {
+        return false;
+    }
+    UserNameList* list = &index->lists[index->nodes[node].list - 1];
+    uint32_t i = 0;
+    while (i < list->count && !userNameKeyHasPhone(index, list->keys[i], key, phone)) {
+        i++;
+    }
+    if (i == list->count) {
+        return false;
+    }
+    list->keys[i] = list->keys[--list->count];
+    node = (uint32_t)field;
+    index->nodes[node].count--;
+    for (size_t j = 0; j < length; j++) {
+        node = userNameIndexChild(index, node, userNameByte(text[j]));
+        index->nodes[node].count--;
+    }
+    return true;
+}
+
+/**
+ * @brief Moves a user of the name index from its old names to its new ones.
+ *
+ * If the index cannot grow it is dropped and rebuilt by the next query.
+ * The caller must hold the user store lock exclusively.
+ *
+ * @param old The record the user replaces, or NULL for a new user.
+ * @param user The stored record.
+ */
+void userNameIndexUpdate(const User* old, const User* user) {
+    uint64_t key = userPhoneKey(user->phone);
+    const UserNameField fields[2] = { USER_NAME_FIELD_NAME, USER_NAME_FIELD_SURNAME };
+    const char* olds[2] = { old != NULL ? old->name : NULL, old != NULL ? old->surname : NULL };
+    const char* news[2] = { user->name, user->surname };
+    for (int i = 0; i < 2; i++) {
+        if (olds[i] != NULL && strcmp(olds[i], news[i]) == 0) {
+            continue;
+        }
+        if (olds[i] != NULL) {
+            userNameIndexRemove(&userNameIndex, fields[i], olds[i], key, old->phone);
+        }
+        if (!userNameIndexAdd(&userNameIndex, fields[i], news[i], key, user->phone)) {
+            userNameIndexReset();
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Tells whether a later record of the table holds the same phone number as a record.
+ *
+ * users.bin files of older builds, which inserted without replacing, can
+ * hold several records of a phone number until a compaction; the last one is
+ * current.
+ *
+ * @param index Index of the record in the slab.
+ * @return true if a later record shadows it.
+ */
+bool userTableShadowed(unsigned index) {
+    const PackedUser* record = &userTable.records[index];
+    char phone[sizeof(((User*)0)->phone)] = "";
+    if (record->phone == USER_PHONE_SPILLED) {
+        userTableRecordPhone(&userTable, record, phone);
+    }
+    unsigned h = userTableRecordHash(&userTable, index);
+    const UserSlot* arrays[2] = { userTable.slots, userTable.oldSlots };
+    unsigned capacities[2] = { userTable.capacity, userTable.oldCapacity };
+    for (int a = 0; a < 2; a++) {
+        const UserSlot* slots = arrays[a];
+        if (slots == NULL) {
+            continue;
+        }
+        for (UserProbe probe = userProbeStart(h, capacities[a]); slots[probe.index].record != 0;
+            userProbeNext(&probe)) {
+            unsigned other = slots[probe.index].record - 1;
+            if (slots[probe.index].hash == h && other > index &&
+                userTableRecordHasPhone(&userTable, &userTable.records[other], record->phone, phone)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Lists a user read from a page in the name index, see `userNameIndexBuild`.
+ *
+ * @param user The user.
+ * @param context Pointer to a bool that is cleared if the index could not grow.
+ */
+void userNameIndexVisit(User* user, void* context) {
+    bool* ok = (bool*)context;
+    uint64_t key = userPhoneKey(user->phone);
+    *ok = *ok && userNameIndexAdd(&userNameIndex, USER_NAME_FIELD_NAME, user->name, key, user->phone) &&
+        userNameIndexAdd(&userNameIndex, USER_NAME_FIELD_SURNAME, user->surname, key, user->phone);
+}
+
+/**
+ * @brief Builds the name index from every user of the store.
+ *
+ * Users are listed as `forEachUser` visits them, except records shadowed by a
+ * later record of the same phone number. The caller must hold the user store
+ * lock exclusively.
+ *
+ * @return true if the index lists every user; false if it could not grow, in which case it is dropped.
+ */
+bool userNameIndexBuild() {
+    userNameIndexReset();
+    bool ok = userNameIndexReserve(&userNameIndex, 3, 0);
+    if (ok) {
+        memset(userNameIndex.nodes, 0, 3 * sizeof(UserNameNode));
+        userNameIndex.nodeCount = 3;
+    }
+    UserVisitor visitor = { userNameIndexVisit, &ok };
+    if (ok) {
+        userPagedFileForEach(&userPagedFile, userTable.count > 0 ? visitPagedUser : userNameIndexVisit,
+            userTable.count > 0 ? (void*)&visitor : (void*)&ok);
+    }
+    User user;
+    for (unsigned i = 0; ok && i < userTable.count; i++) {
+        if (!userTableShadowed(i)) {
+            userTableUnpack(&userTable, &userTable.records[i], &user);
+            userNameIndexVisit(&user, &ok);
+        }
+    }
+    if (!ok) {
+        userNameIndexReset();
+        return false;
+    }
+    userNameIndex.built = true;
+    return true;
+}
+
+/**
+ * @brief Collects one page of the users of a subtree of the name index, in byte order of the names.
+ *
+ * Subtrees and lists that lie wholly before the page are stepped over by their counts.
+ *
+ * @param node The subtree to walk.
+ * @param skip Users still to pass over before the page starts.
+ * @param keys Receives the keys of the users.
+ * @param found Number of keys already collected.
+ * @param max Capacity of `keys`.
+ * @return The number of keys collected.
+ */
+unsigned userNameIndexList(uint32_t node, unsigned* skip, uint64_t* keys, unsigned found, unsigned max) {
+    const UserNameNode* n = &userNameIndex.nodes[node];
+    if (*skip >= n->count) {
+        *skip -= n->count;
+        return found;
+    }
+    if (n->list != 0) {
+        const UserNameList* list = &userNameIndex.lists[n->list - 1];
+        if (*skip >= list->count) {
+            *skip -= list->count;
+        }
+        else {
+            for (uint32_t i = *skip; i < list->count && found < max; i++) {
+                keys[found++] = list->keys[i];
+            }
+            *skip = 0;
+        }
+    }
+    for (uint32_t child = n->child; child != 0 && found < max; child = userNameIndex.nodes[child].sibling) {
+        found = userNameIndexList(child, skip, keys, found, max);
+    }
+    return found;
+}
+
+/**
+ * @brief Copies one page of the users whose name or surname starts with a prefix.
+ *
+ * Matching is by byte, without regard to ASCII case. Users are ordered by the
+ * matched field; users of equal names come in no particular order. A query
+ * walks the prefix and then only the part of the trie that holds the page, so
+ * it takes O(prefix + results) steps for an alphabet of fixed size.
+ * The first query builds the index under the exclusive store lock; later ones
+ * only need it shared.
+ *
+ * @param field The field to match.
+ * @param prefix The prefix; an empty prefix lists every user.
+ * @param offset Number of matching users to skip.
+ * @param out Receives the users of the page.
+ * @param max Capacity of `out`.
+ * @param total Receives the number of matching users; may be NULL.
+ * @return The number of users copied to `out`.
+ */
+unsigned findUsersByNamePrefix(UserNameField field, const char* prefix, unsigned offset, User* out, unsigned max,
+    unsigned* total) {
+    lockUserStore(false);
+    bool exclusive = !userNameIndex.built;
+    if (exclusive) {
+        unlockUserStore(false);
+        lockUserStore(true);
+        if (!userNameIndex.built) {
+            userNameIndexBuild();
+        }
+    }
+    uint32_t node = userNameIndex.built ? userNameIndexFind(&userNameIndex, field, prefix, strlen(prefix)) : 0;
+    if (total != NULL) {
+        *total = node != 0 ? userNameIndex.nodes[node].count : 0;
+    }
+    unsigned copied = 0;
+    unsigned position = offset;
+    uint64_t keys[64];
+    while (node != 0 && copied < max) {
+        unsigned skip = position;
+        unsigned batch = max - copied < 64 ? max - copied : 64;
+        unsigned listed = userNameIndexList(node, &skip, keys, 0, batch);
+        position += listed;
+        for (unsigned i = 0; i < listed; i++) {
+            // Looked up by key: the display form of a key need not normalize back to it
+            uint64_t key = keys[i];
+            char phone[sizeof(((User*)0)->phone)];
+            if ((key & USER_PHONE_SPILLED) == USER_PHONE_SPILLED) {
+                snprintf(phone, sizeof(phone), "%s", userNameIndex.phones + (key & ~USER_PHONE_SPILLED));
+                key = USER_PHONE_SPILLED;
+            }
+            else {
+                formatUserPhone(key, phone);
+            }
+            bool searched = false;
+            unsigned probes = 0;
+            copied += userTableSearchKey(key, phone, &out[copied], 1, &searched, &probes);
+        }
+        if (listed < batch) {
+            break;
+        }
+    }
+    unlockUserStore(exclusive);
+    return copied;
+}
+
+/**
+ * @brief Releases the record slab, the name arena, the slot arrays and the filters of the hash table.
+ *
+ * They are unmapped instead when the table reads them from users.bin. The
+ * caller must hold the user store lock exclusively.
+ */
+void userTableRelease() {
+    if (!userFileHolds(userTable.filter)) {
+        freeUserFilter(userTable.filter);
+    }
+    if (userFile.data != NULL) {
+        unmapFile(&userFile);
+    }
+    else {
+        free(userTable.records);
+        free(userTable.names);
+        free(userTable.slots);
+    }
+    free(userTable.oldSlots);
+    freeUserFilter(userTable.oldFilter);
+    userTable.records = NULL;
+    userTable.recordCapacity = 0;
+    userTable.names = NULL;
+    userTable.namesSize = 0;
+    userTable.namesCapacity = 0;
+    userTable.slots = NULL;
+    userTable.capacity = 0;
+    userTable.count = 0;
+    userTable.oldSlots = NULL;
+    userTable.oldCapacity = 0;
+    userTable.migrateIndex = 0;
+    userTable.filter = NULL;
+    userTable.filterBlocks = 0;
+    userTable.oldFilter = NULL;
+    userTable.oldFilterBlocks = 0;
+}
+
+/**
+ * @brief Removes every user from the hash table.
+ *
+ * The table memory and the name index are released and a paged users.bin is
+ * closed. The caller must hold the user store lock exclusively.
+ */
+void userTableClear() {
+    closeUserPagedFile(&userPagedFile);
+    userTableRelease();
+    userNameIndexReset();
+    clearLoginCache();
+}
+
+/**
+ * @brief Removes every user from the hash table.
+ *
+ * @see userTableClear()
+ */
+void clearUserTable() {
+    lockUserStore(true);
+    userTableClear();
+    unlockUserStore(true);
+}
+
+/**
+ * @brief Selects the hash function of the user table.
+ *
+ * The slot array is rebuilt from the record slab with the new function, so
+ * existing users stay reachable.
+ *
+ * @param function The hash function to use from now on.
+ * @return true if the table was rehashed; false if the new slot array could not be allocated.
+ */
+bool setUserHashFunction(UserHashFunction function) {
+    lockUserStore(true);
+    bool rehashed = userTableDetach(&userTable);
+    UserHashFunction previous = userHashFunction;
+    if (rehashed) {
+        userHashFunction = function;
+        if (userTable.slots != NULL && !userTableRebuild(&userTable, userTable.capacity)) {
+            userHashFunction = previous;
+            rehashed = false;
+        }
+    }
+    unlockUserStore(true);
+    return rehashed;
+}
+
+/**
+ * @brief Selects the probe policy of the user table.
+ *
+ * The slot array is rebuilt from the record slab with the new policy, so
+ * existing users stay reachable.
+ *
+ * @param policy The probe policy to use from now on.
+ * @return true if the table was rebuilt; false if the policy is unknown or the
+ *         new slot array could not be allocated.
+ */
+bool setUserProbePolicy(UserProbePolicy policy) {
+    if (policy < 0 || policy >= USER_PROBE_POLICY_COUNT) {
+        return false;
+    }
+    lockUserStore(true);
+    bool rebuilt = userTableDetach(&userTable);
+    UserProbePolicy previous = userProbePolicy;
+    if (rebuilt) {
+        userProbePolicy = policy;
+        if (userTable.slots != NULL && !userTableRebuild(&userTable, userTable.capacity)) {
+            userProbePolicy = previous;
+            rebuilt = false;
+        }
+    }
+    unlockUserStore(true);
+    return rebuilt;
+}
+
+/**
+ * @brief Probe lengths of the records stored in the user index.
+ */
+typedef struct UserProbeStats {
+    unsigned users;              /**< Number of records measured. */
+    double averageProbes;        /**< Average slots examined by a successful lookup. */
+    unsigned maxProbes;          /**< Longest successful lookup in slots examined. */
+} UserProbeStats;
+
+/**
+ * @brief Measures how many slots successful lookups examine.
+ *
+ * Every record is looked up through the current slot array, counting the slot
+ * that holds it. Any running rehash is completed first.
+ *
+ * @return The probe length statistics of the user index.
+ */
+UserProbeStats userTableProbeStats() {
+    UserProbeStats stats = { 0, 0.0, 0 };
+    lockUserStore(true);
+    userTableMigrate(&userTable, userTable.oldCapacity);
+    unsigned long long total = 0;
+    for (unsigned i = 0; i < userTable.count && userTable.slots != NULL; i++) {
+        unsigned h = userTableRecordHash(&userTable, i);
+        UserProbe probe = userProbeStart(h, userTable.capacity);
+        while (userTable.slots[probe.index].record != i + 1 && probe.count < userTable.capacity) {
+            userProbeNext(&probe);
+        }
+        unsigned probes = probe.count + 1;
+        total += probes;
+        stats.maxProbes = probes > stats.maxProbes ? probes : stats.maxProbes;
+        stats.users++;
+    }
+    unlockUserStore(true);
+    stats.averageProbes = stats.users > 0 ? (double)total / stats.users : 0.0;
+    return stats;
+}
+
+/**
+ * @brief Effectiveness of the phone number filters in front of the user store.
+ */
+typedef struct UserFilterStats {
+    unsigned long long rejections;     /**< Lookups of unregistered phone numbers answered by the filters alone. */
+    unsigned long long falsePositives; /**< Lookups of unregistered phone numbers the filters let through. */
+    double falsePositiveRate;          /**< Share of lookups of unregistered phone numbers that got past the filters. */
+    double expectedFalsePositiveRate;  /**< Share expected from the bits currently set in the filters. */
+    size_t bytes;                      /**< Memory held by the filters. */
+} UserFilterStats;
+
+/**
+ * @brief Probability that an unregistered phone number passes the filter of a slot array.
+ *
+ * The filter works on the 32-bit slot hash, so besides the false positives of
+ * its blocks a number whose hash equals that of one of `users` users passes.
+ *
+ * @return The rate; 1 if the array has no filter.
+ */
+double userTableFilterFalsePositiveRate(const UserFilterBlock* filter, unsigned blocks, unsigned users) {
+    if (filter == NULL) {
+        return 1.0;
+    }
+    double rate = 0.0;
+    for (unsigned i = 0; i < blocks; i++) {
+        rate += userFilterBlockFalsePositiveRate(&filter[i]);
+    }
+    rate = rate / blocks + users / 4294967296.0;
+    return rate < 1.0 ? rate : 1.0;
+}
+
+/**
+ * @brief Reports how well the phone number filters reject unregistered numbers.
+ *
+ * The measured rate counts every lookup since startup that found no record;
+ * the expected rate is what an unregistered phone number would see now,
+ * combining the filters of both slot arrays and of the pages a lookup reaches
+ * through the directory of a paged users.bin.
+ *
+ * @return The filter statistics.
+ */
+UserFilterStats userFilterStats() {
+    UserFilterStats stats;
+    memset(&stats, 0, sizeof(stats));
+    {
+        std::lock_guard<std::mutex> guard(userMetricsMutex);
+        for (UserMetrics* block = userMetricsBlocks; block != NULL; block = block->next) {
+            stats.rejections += block->filterRejections.load(std::memory_order_relaxed);
+            stats.falsePositives += block->filterFalsePositives.load(std::memory_order_relaxed);
+        }
+    }
+    unsigned long long misses = stats.rejections + stats.falsePositives;
+    stats.falsePositiveRate = misses > 0 ? (double)stats.falsePositives / misses : 0.0;
+
+    lockUserStore(false);
+    double rejected = 1.0; // Probability that every filter rejects an unregistered number
+    if (userTable.slots != NULL) {
+        rejected *= 1.0 - userTableFilterFalsePositiveRate(userTable.filter, userTable.filterBlocks, userTable.count);
+        stats.bytes += userTable.filter != NULL ? (size_t)userTable.filterBlocks * sizeof(UserFilterBlock) : 0;
+    }
+    if (userTable.oldSlots != NULL) {
+        rejected *= 1.0 - userTableFilterFalsePositiveRate(userTable.oldFilter, userTable.oldFilterBlocks, userTable.count);
+        stats.bytes += userTable.oldFilter != NULL ? (size_t)userTable.oldFilterBlocks * sizeof(UserFilterBlock) : 0;
+    }
+    const UserPagedFile* paged = &userPagedFile;
+    if (paged->file != NULL) {
+        double rate = 1.0;
+        if (paged->filter != NULL) {
+            size_t entries = (size_t)1 << paged->header.depth;
+            rate = 0.0;
+            for (size_t i = 0; i < entries; i++) {
+                rate += userFilterBlockFalsePositiveRate(&paged->filter[paged->directory[i]]);
+            }
+            rate /= entries;
+            stats.bytes += (size_t)paged->filterCapacity * sizeof(UserFilterBlock);
+        }
+        rejected *= 1.0 - rate;
+    }
+    unlockUserStore(false);
+    stats.expectedFalsePositiveRate = 1.0 - rejected;
+    return stats;
+}
+
+/**
+ * @brief Health metrics of the user table: its shape now and its counters since startup.
+ */
+typedef struct UserTableMetrics {
+    unsigned users;              /**< Records in the table. */
+    unsigned capacity;           /**< Slots of the current slot array. */
+    double loadFactor;           /**< `users` over `capacity`. */
+    bool rehashing;              /**< Whether an old slot array is still being migrated. */
+    double meanChain;            /**< Average slots a successful lookup examines. */
+    unsigned maxChain;           /**< Most slots a successful lookup examines. */
+    unsigned long long inserts;        /**< Phone numbers added to the table. */
+    unsigned long long replacements;   /**< Records overwritten by re-registrations. */
+    unsigned long long lookups;        /**< Lookups of phone numbers. */
+    unsigned long long logins;         /**< Login attempts. */
+    unsigned long long failedLogins;   /**< Login attempts that failed. */
+    unsigned long long insertProbes[USER_METRICS_PROBE_BUCKETS];     /**< Inserts by slots a lookup of the new record examines. */
+    unsigned long long lookupProbes[USER_METRICS_PROBE_BUCKETS];     /**< Lookups by slots examined; 0 if the filters answered. */
+    unsigned long long lookupLatency[USER_METRICS_LATENCY_BUCKETS];  /**< Sampled lookups by duration, see USER_METRICS_LATENCY_BUCKETS. */
+} UserTableMetrics;
+
+/**
+ * @brief Adds the chain lengths of the occupied slots of a slot array.
+ *
+ * The chain length of a slot is the number of slots a lookup of its hash
+ * examines until it reaches it.
+ *
+ * @param slots The slot array.
+ * @param capacity Number of slots in the array (power of two).
+ * @param total Incremented by the sum of the chain lengths.
+ * @param longest Raised to the longest chain length.
+ * @return The number of occupied slots.
+ */
+unsigned userTableChainLengths(const UserSlot* slots, unsigned capacity, unsigned long long* total, unsigned* longest) {
+    unsigned occupied = 0;
+    for (unsigned i = 0; i < capacity; i++) {
+        if (slots[i].record == 0) {
+            continue;
+        }
+        UserProbe probe = userProbeStart(slots[i].hash, capacity);
+        while (probe.index != i && probe.count < capacity) {
+            userProbeNext(&probe);
+        }
+        unsigned length = probe.count + 1;
+        *total += length;
+        *longest = length > *longest ? length : *longest;
+        occupied++;
+    }
+    return occupied;
+}
+
+/**
+ * @brief Collects the health metrics of the user table.
+ *
+ * The counters of every thread are summed without stopping them, so a
+ * snapshot taken while threads are counting may be a few events behind. The
+ * chain lengths are measured by walking every occupied slot under the shared
+ * store lock, about 20 ms per million users; during a rehash both slot arrays
+ * are measured.
+ *
+ * @return The metrics.
+ */
+UserTableMetrics userTableMetrics() {
+    UserTableMetrics metrics;
+    memset(&metrics, 0, sizeof(metrics));
+    {
+        std::lock_guard<std::mutex> guard(userMetricsMutex);
+        for (UserMetrics* block = userMetricsBlocks; block != NULL; block = block->next) {
+            metrics.inserts += block->inserts.load(std::memory_order_relaxed);
+            metrics.replacements += block->replacements.load(std::memory_order_relaxed);
+            metrics.lookups += block->lookups.load(std::memory_order_relaxed);
+            metrics.logins += block->logins.load(std::memory_order_relaxed);
+            metrics.failedLogins += block->failedLogins.load(std::memory_order_relaxed);
+            for (int i = 0; i < USER_METRICS_PROBE_BUCKETS; i++) {
+                metrics.insertProbes[i] += block->insertProbes[i].load(std::memory_order_relaxed);
+                metrics.lookupProbes[i] += block->lookupProbes[i].load(std::memory_order_relaxed);
+            }
+            for (int i = 0; i < USER_METRICS_LATENCY_BUCKETS; i++) {
+                metrics.lookupLatency[i] += block->lookupLatency[i].load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    lockUserStore(false);
+    metrics.users = userTable.count;
+    metrics.capacity = userTable.slots != NULL ? userTable.capacity : 0;
+    metrics.loadFactor = metrics.capacity > 0 ? (double)metrics.users / metrics.capacity : 0.0;
+    metrics.rehashing = userTable.oldSlots != NULL;
+    unsigned long long total = 0;
+    unsigned measured = 0;
+    if (userTable.slots != NULL) {
+        measured += userTableChainLengths(userTable.slots, userTable.capacity, &total, &metrics.maxChain);
+    }
+    if (userTable.oldSlots != NULL) {
+        measured += userTableChainLengths(userTable.oldSlots, userTable.oldCapacity, &total, &metrics.maxChain);
+    }
+    unlockUserStore(false);
+    metrics.meanChain = measured > 0 ? (double)total / measured : 0.0;
+    return metrics;
+}
+
+/**
+ * @brief Writes a histogram of the user table metrics with cumulative `le` buckets.
+ *
+ * @param file The destination.
+ * @param name Name of the histogram.
+ * @param counts Count of each bucket.
+ * @param buckets Number of buckets; the last one is reported as `+Inf`.
+ * @param exponential Whether bucket `i` ends below 2^(i+1) rather than at `i`.
+ */
+void writeUserMetricsHistogram(FILE* file, const char* name, const unsigned long long* counts, int buckets,
+    bool exponential) {
+    unsigned long long cumulative = 0;
+    for (int i = 0; i < buckets; i++) {
+        cumulative += counts[i];
+        if (i + 1 < buckets) {
+            fprintf(file, "%s_bucket{le=\"%llu\"} %llu\n", name, exponential ? (2ull << i) - 1 : (unsigned long long)i,
+                cumulative);
+        }
+        else {
+            fprintf(file, "%s_bucket{le=\"+Inf\"} %llu\n", name, cumulative);
+        }
+    }
+    fprintf(file, "%s_count %llu\n", name, cumulative);
+}
+
+/**
+ * @brief Writes the health metrics of the user table in the Prometheus text format.
+ *
+ * The counters only cover the traffic of the running process, so a process
+ * that has just loaded users.bin writes the shape of the table alone.
+ *
+ * @param file The destination.
+ * @param counters Whether to write the counters and histograms since startup as well.
+ * @return true if the metrics were written; false on a write error.
+ */
+bool writeUserMetrics(FILE* file, bool counters) {
+    UserTableMetrics metrics = userTableMetrics();
+    fprintf(file, "user_table_users %u\n", metrics.users);
+    fprintf(file, "user_table_capacity %u\n", metrics.capacity);
+    fprintf(file, "user_table_load_factor %.4f\n", metrics.loadFactor);
+    fprintf(file, "user_table_rehashing %d\n", metrics.rehashing ? 1 : 0);
+    fprintf(file, "user_table_probe_policy{policy=\"%s\"} 1\n", userProbePolicyNames[userProbePolicy]);
+    fprintf(file, "user_table_chain_length_mean %.4f\n", metrics.meanChain);
+    fprintf(file, "user_table_chain_length_max %u\n", metrics.maxChain);
+    if (!counters) {
+        return fflush(file) == 0 && !ferror(file);
+    }
+    UserFilterStats filters = userFilterStats();
+    fprintf(file, "user_table_inserts_total %llu\n", metrics.inserts);
+    fprintf(file, "user_table_replacements_total %llu\n", metrics.replacements);
+    fprintf(file, "user_table_lookups_total %llu\n", metrics.lookups);
+    fprintf(file, "user_logins_total %llu\n", metrics.logins);
+    fprintf(file, "user_login_failures_total %llu\n", metrics.failedLogins);
+    fprintf(file, "user_filter_rejections_total %llu\n", filters.rejections);
+    fprintf(file, "user_filter_false_positives_total %llu\n", filters.falsePositives);
+    writeUserMetricsHistogram(file, "user_table_insert_probes", metrics.insertProbes, USER_METRICS_PROBE_BUCKETS, false);
+    writeUserMetricsHistogram(file, "user_table_lookup_probes", metrics.lookupProbes, USER_METRICS_PROBE_BUCKETS, false);
+    writeUserMetricsHistogram(file, "user_lookup_latency_ns", metrics.lookupLatency, USER_METRICS_LATENCY_BUCKETS, true);
+    return fflush(file) == 0 && !ferror(file);
+}
+
+/**
+ * @brief Prints the shape of the user table to the console.
+ *
+ * Only the size, load factor and chain lengths are printed; the traffic
+ * counters are written by `startUserMetricsDump` of a running menu.
+ */
+void printUserMetrics() {
+    writeUserMetrics(stdout, false);
+}
+
+/**
+ * @brief Writes the health metrics of the user table to a file.
+ *
+ * The metrics are written under a temporary name and renamed into place, so a
+ * reader never sees a partial dump.
+ *
+ * @param path Path of the file.
+ * @return true if the file was written; false otherwise.
+ */
+bool saveUserMetrics(const char* path) {
+    char tempPath[276];
+    snprintf(tempPath, sizeof(tempPath), "%s.tmp", path);
+    FILE* file = fopen(tempPath, "w");
+    if (file == NULL) {
+        return false;
+    }
+    bool written = writeUserMetrics(file, true);
+    written = fclose(file) == 0 && written;
+    if (!written) {
+        remove(tempPath);
+        return false;
+    }
+#if defined(_WIN32) || defined(_WIN64)
+    remove(path); // rename does not replace an existing file on Windows
+#endif
+    return rename(tempPath, path) == 0;
+}
+
+/**
+ * @brief State of the thread that periodically dumps the user table metrics.
+ */
+typedef struct UserMetricsDump {
+    std::thread thread;          /**< The dumping thread, if running. */
+    std::mutex mutex;            /**< Guards `running`. */
+    std::condition_variable wake; /**< Signalled to stop the thread. */
+    bool running;                /**< Whether the thread should keep dumping. */
+    char path[260];              /**< File the metrics are written to. */
+    unsigned seconds;            /**< Interval between two dumps. */
+} UserMetricsDump;
+
+/**
+ * @brief The periodic metrics dump.
+ */
+UserMetricsDump userMetricsDump;
+
+/**
+ * @brief Body of the dumping thread: writes the metrics file every interval until stopped.
+ */
+void userMetricsDumpLoop() {
+    std::unique_lock<std::mutex> lock(userMetricsDump.mutex);
+    bool stopping = false;
+    while (!stopping) {
+        if (userMetricsDump.running) {
+            userMetricsDump.wake.wait_for(lock, std::chrono::seconds(userMetricsDump.seconds));
+        }
+        stopping = !userMetricsDump.running;
+        lock.unlock();
+        saveUserMetrics(userMetricsDump.path);
+        lock.lock();
+    }
+}
+
+/**
+ * @brief Starts writing the health metrics of the user table to a file at a fixed interval.
+ *
+ * The file is written once right away, then every `seconds` seconds by a
+ * background thread, and a last time by `stopUserMetricsDump`. A running dump
+ * is stopped first.
+ *
+ * @param path Path of the metrics file.
+ * @param seconds Interval between two dumps, at least 1.
+ * @return true if the dump was started; false if the file could not be written.
+ */
+bool startUserMetricsDump(const char* path, unsigned seconds) {
+    stopUserMetricsDump();
+    if (strlen(path) >= sizeof(userMetricsDump.path) || !saveUserMetrics(path)) {
+        return false;
+    }
+    strcpy(userMetricsDump.path, path);
+    userMetricsDump.seconds = seconds > 0 ? seconds : 1;
+    userMetricsDump.running = true;
+    userMetricsDump.thread = std::thread(userMetricsDumpLoop);
+    return true;
+}
+
+/**
+ * @brief Stops the periodic metrics dump, if running, after writing the metrics file a last time.
+ */
+void stopUserMetricsDump() {
+    if (!userMetricsDump.thread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> guard(userMetricsDump.mutex);
+        userMetricsDump.running = false;
+    }
+    userMetricsDump.wake.notify_all();
+    userMetricsDump.thread.join();
+}
+
+/**
+ * @brief Defines the largest bucket occupancy reported individually by the distribution report.
+ */
+#define HASH_REPORT_MAX_OCCUPANCY 8
+
+/**
+ * @brief Writes a bucket occupancy report of a hash function over a phone number corpus.
+ *
+ * Every phone number is hashed once and reduced modulo `buckets`. One CSV line is
+ * written with the number of empty buckets, the fullest bucket, the chi-squared
+ * statistic of the bucket counts (close to `buckets` for a uniform hash) and the
+ * number of buckets holding 0, 1, ... HASH_REPORT_MAX_OCCUPANCY or more keys.
+ * Call `hashDistributionReportHeader` first to write the column names.
+ *
+ * @param out The stream to write the report line to.
+ * @param name Name of the hash function printed in the first column.
+ * @param function The hash function to evaluate.
+ * @param phones Array of phone numbers forming the corpus.
+ * @param count Number of phone numbers in the corpus.
+ * @param buckets Number of buckets to distribute the keys over.
+ */
+void hashDistributionReport(FILE* out, const char* name, UserHashFunction function,
+    const char* const* phones, size_t count, unsigned buckets) {
+    unsigned* occupancy = (unsigned*)calloc(buckets, sizeof(unsigned));
+    if (occupancy == NULL) {
+        return;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        occupancy[function(phones[i], strlen(phones[i])) % buckets]++;
+    }
+
+    unsigned histogram[HASH_REPORT_MAX_OCCUPANCY + 1] = { 0 };
+    unsigned maxOccupancy = 0;
+    double expected = (double)count / buckets;
+    double chiSquared = 0.0;
+    for (unsigned i = 0; i < buckets; i++) {
+        unsigned keys = occupancy[i];
+        histogram[keys < HASH_REPORT_MAX_OCCUPANCY ? keys : HASH_REPORT_MAX_OCCUPANCY]++;
+        if (keys > maxOccupancy) {
+            maxOccupancy = keys;
+        }
+        chiSquared += (keys - expected) * (keys - expected) / expected;
+    }
+
+    fprintf(out, "%s,%u,%zu,%u,%u,%.1f", name, buckets, count, histogram[0], maxOccupancy, chiSquared);
+    for (int i = 0; i <= HASH_REPORT_MAX_OCCUPANCY; i++) {
+        fprintf(out, ",%u", histogram[i]);
+    }
+    fprintf(out, "\n");
+    free(occupancy);
+}
+
+/**
+ * @brief Writes the CSV column names of the hash distribution report.
+ *
+ * @param out The stream to write the header to.
+ */
+void hashDistributionReportHeader(FILE* out) {
+    fprintf(out, "hash,buckets,keys,empty,max_occupancy,chi_squared");
+    for (int i = 0; i < HASH_REPORT_MAX_OCCUPANCY; i++) {
+        fprintf(out, ",occ_%d", i);
+    }
+    fprintf(out, ",occ_%d_plus\n", HASH_REPORT_MAX_OCCUPANCY);
+}
+
+/**
+ * @brief Inserts a new user into the hash table.
+ *
+ * This function packs the user into the record slab, migrates a bounded number
+ * of slots of any running rehash, grows the slot array when the insertion would
+ * exceed the load factor threshold, and then places the user with the current
+ * probe policy (quadratic probing unless `setUserProbePolicy` chose another).
+ * If the table cannot grow, it notifies the user and returns false.
+ *
+ * The caller must hold the user store lock exclusively.
+ *
+ * @param newUser Pointer to the User structure to be inserted into the hash table.
+ *                The record is copied, so the caller keeps ownership of it.
+ * @return True if the user was successfully added, false if the hash table could not grow.
+ */
+bool quadraticProbingInsert(User* newUser) {
+    if (!userTableDetach(&userTable)) {
+        printf("Hash table full. User not added.\n");
+        return false;
+    }
+    userTableMigrate(&userTable, USER_TABLE_REHASH_STEP);
+
+    if ((unsigned long long)(userTable.count + 1) * 100 >
+        (unsigned long long)userTable.capacity * USER_TABLE_MAX_LOAD_PERCENT) {
+        if (!userTableGrow(&userTable)) {
+            printf("Hash table full. User not added.\n");
+            return false;
+        }
+    }
+
+    if (userTable.count == userTable.recordCapacity) {
+        unsigned newCapacity = userTable.recordCapacity ? userTable.recordCapacity * 2 : USER_TABLE_INITIAL_CAPACITY;
+        PackedUser* records = (PackedUser*)realloc(userTable.records, (size_t)newCapacity * sizeof(PackedUser));
+        if (records == NULL) {
+            printf("Hash table full. User not added.\n");
+            return false;
+        }
+        userTable.records = records;
+        userTable.recordCapacity = newCapacity;
+    }
+
+    User user = *newUser;
+    hashUserPassword(&user);
+    if (!userTablePack(&userTable, &user, &userTable.records[userTable.count])) {
+        printf("Hash table full. User not added.\n");
+        return false;
+    }
+
+    UserSlot slot = { hash(user.phone), userTable.count + 1 };
+    unsigned probes = userTablePlace(userTable.slots, userTable.capacity, slot);
+    userTableFilterAdd(userTable.filter, userTable.filterBlocks, slot.hash);
+    userTable.count++;
+    UserMetrics* metrics = userMetricsThread();
+    if (metrics != NULL) {
+        userMetricsAdd(&metrics->inserts, 1);
+        userMetricsCountProbes(metrics->insertProbes, probes);
+    }
+    return true;
+}
+
+/**
+ * @brief Stores a user, replacing the record of an already registered phone number in place.
+ *
+ * The record keeps its slab index and slot, since the phone number and
+ * therefore its hash are unchanged, so re-registering a phone number never
+ * grows the table. New phone numbers are inserted with `quadraticProbingInsert`.
+ * Most new phone numbers are told apart from registered ones by the phone
+ * number filter alone. Once built, the name index is moved to the new names.
+ *
+ * The caller must hold the user store lock exclusively.
+ *
+ * @param user The record to store; a plaintext password is hashed first.
+ * @return true if the record was stored; false if the table could not grow.
+ */
+bool userTableUpsert(User* user) {
+    if (!userTableDetach(&userTable)) {
+        printf("Hash table full. User not added.\n");
+        return false;
+    }
+    hashUserPassword(user);
+    User old;
+    bool searched = false;
+    unsigned probes = 0;
+    bool registered = userNameIndex.built && userTableSearch(user->phone, &old, 1, &searched, &probes) == 1;
+    if (userTableReplace(user, hash(user->phone))) {
+        UserMetrics* metrics = userMetricsThread();
+        if (metrics != NULL) {
+            userMetricsAdd(&metrics->replacements, 1);
+        }
+    }
+    else if (!quadraticProbingInsert(user)) {
+        return false;
+    }
+    if (userNameIndex.built) {
+        userNameIndexUpdate(registered ? &old : NULL, user);
+    }
+    return true;
+}
+
+/**
+ * @brief Saves a user to the hash table.
+ *
+ * This function stores a copy of the user in the open-addressing hash table,
+ * replacing the record of a phone number that is already registered. The
+ * table grows automatically when its load factor threshold is reached, so
+ * lookups stay O(1) amortized as the number of users grows. The password is
+ * hashed before the store lock is taken, so concurrent logins are not blocked
+ * while PBKDF2 runs.
+ *
+ * @param newUser Pointer to the User structure that needs to be saved in the hash table.
+ *        Users without a password are not saved.
+ */
+void saveUser(User* newUser) {
+    if (!userPasswordSet(newUser)) {
+        printf("A password is required. User not added.\n");
+        return;
+    }
+    User copy = *newUser;
+    hashUserPassword(&copy);
+    lockUserStore(true);
+    userTableUpsert(&copy);
+    unlockUserStore(true);
+}
+
+/**
+ * @brief Signature that identifies a users.bin file in the indexed format.
+ */
+#define USER_FILE_MAGIC "EVUS"
+
+/**
+ * @brief Version of the indexed users.bin format written by this build.
+ *
+ * Version 2 added `logGeneration`; version 3 stores hashed passwords (User
+ * records); version 4 adds the phone number filter of the index; version 5
+ * stores PackedUser records and their name arena; version 6 keys them on the
+ * canonical phone number (see `userPhoneKey`) instead of its BCD digits.
+ * Versions 1 and 2 hold LegacyUser records, versions 3 and 4 User records;
+ * they and version 5 are still read and packed again while loading.
+ */
+#define USER_FILE_VERSION 6
+
+/**
+ * @brief Header at the start of an indexed users.bin file.
+ *
+ * The header is followed by `count` PackedUser records, by the `capacity`
+ * slots of the hash index, by the `filterBlocks` blocks of its phone number
+ * filter and by the `namesSize` bytes of the name arena, all in native byte
+ * order. Because the index, its filter and the arena are stored next to the
+ * records, the file can be memory-mapped and queried in place. Files that do
+ * not start with USER_FILE_MAGIC are read as the original format: a plain
+ * sequence of LegacyUser records.
+ *
+ * Version 1 headers end before `logGeneration`, versions 2 and 3 before
+ * `filterOffset`, version 4 before `namesOffset`.
+ */
+typedef struct UserFileHeader {
+    char magic[4];               /**< USER_FILE_MAGIC, not null-terminated. */
+    uint32_t version;            /**< Format version, USER_FILE_VERSION. */
+    uint32_t recordSize;         /**< sizeof(PackedUser) of the writer; sizeof(User) in versions 3 and 4. */
+    uint32_t hashFunction;       /**< Index of the hash function in `userHashFunctions`. */
+    uint32_t count;              /**< Number of user records. */
+    uint32_t capacity;           /**< Number of index slots (power of two). */
+    uint64_t recordsOffset;      /**< Byte offset of the first record. */
+    uint64_t slotsOffset;        /**< Byte offset of the first index slot. */
+    uint32_t logGeneration;      /**< Generation of the registration log this snapshot supersedes. */
+    uint32_t probePolicy;        /**< UserProbePolicy the index slots were placed with. */
+    uint64_t filterOffset;       /**< Byte offset of the first filter block, a multiple of its size. */
+    uint32_t filterBlocks;       /**< Number of filter blocks; 0 if the file has no filter. */
+    uint32_t reserved;           /**< Always 0. */
+    uint64_t namesOffset;        /**< Byte offset of the name arena. */
+    uint64_t namesSize;          /**< Size of the name arena in bytes. */
+} UserFileHeader;
+
+/**
+ * @brief Hash functions that can be recorded in a users.bin header, by index.
+ */
+UserHashFunction userHashFunctions[] = { wyHash, polynomialHash };
+
+/**
+ * @brief Generation of the registration log that belongs to the loaded users.bin snapshot.
+ *
+ * Every snapshot starts a new generation. A log whose generation is older than
+ * the snapshot was already folded into it and is not replayed.
+ */
+uint32_t userLogGeneration = 0;
+
+/**
+ * @brief Adds records to the hash table by packing them into the record slab.
+ *
+ * Plaintext passwords in the records are hashed on the way in. A record whose
+ * phone number is already in the table replaces the stored record in place, so
+ * of several records of one phone number the last one is kept.
+ *
+ * The name index is dropped rather than updated record by record.
+ *
+ * The caller must hold the user store lock exclusively.
+ *
+ * @param records Pointer to the first record to add.
+ * @param count Number of records to add.
+ * @return true if the records were added; false if the table could not grow.
+ */
+bool userTableAppend(const User* records, unsigned count) {
+    if (count == 0) {
+        return true;
+    }
+    userNameIndexReset(); // Rebuilt by the next prefix query
+    if (!userTableDetach(&userTable) || !userTableReserve(&userTable, userTable.count + count)) {
+        return false;
+    }
+
+    for (unsigned i = 0; i < count; i++) {
+        User user = records[i];
+        hashUserPassword(&user);
+        UserSlot slot = { hash(user.phone), userTable.count + 1 };
+        if (!userTableReplace(&user, slot.hash)) {
+            if (!userTablePack(&userTable, &user, &userTable.records[userTable.count])) {
+                return false;
+            }
+            userTablePlace(userTable.slots, userTable.capacity, slot);
+            userTableFilterAdd(userTable.filter, userTable.filterBlocks, slot.hash);
+            userTable.count++;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Adds records in the layout of older users files to the hash table.
+ *
+ * The records are converted in batches and their plaintext passwords hashed.
+ *
+ * The caller must hold the user store lock exclusively.
+ *
+ * @param records Pointer to the first record to add.
+ * @param count Number of records to add.
+ * @return true if the records were added; false if the table could not grow.
+ */
+bool userTableAppendLegacy(const LegacyUser* records, unsigned count) {
+    if (!userTableReserve(&userTable, userTable.count + count)) {
+        return false;
+    }
+    User batch[64];
+    for (unsigned i = 0; i < count; i += 64) {
+        unsigned n = count - i < 64 ? count - i : 64;
+        memset(batch, 0, n * sizeof(User));
+        for (unsigned j = 0; j < n; j++) {
+            memcpy(batch[j].name, records[i + j].name, sizeof(batch[j].name));
+            memcpy(batch[j].surname, records[i + j].surname, sizeof(batch[j].surname));
+            memcpy(batch[j].phone, records[i + j].phone, sizeof(batch[j].phone));
+            memcpy(batch[j].password, records[i + j].password, sizeof(batch[j].password));
+            batch[j].password[sizeof(batch[j].password) - 1] = '\0';
+        }
+        if (!userTableAppend(batch, n)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Adds packed records of another table, such as a mapped users.bin, to the hash table.
+ *
+ * The records are unpacked in batches and packed again into the slab and name
+ * arena of the table. Records of users.bin version 5 hold BCD phone numbers
+ * and arena entries without the phone number (see `unpackBcdUserPhone`);
+ * packing them again keys them on their canonical phone number.
+ *
+ * The caller must hold the user store lock exclusively.
+ *
+ * @param records Pointer to the first record to add.
+ * @param names The name arena the records refer to.
+ * @param count Number of records to add.
+ * @param version Format version of the records, 5 or USER_FILE_VERSION.
+ * @return true if the records were added; false if the table could not grow.
+ */
+bool userTableAppendPacked(const PackedUser* records, const uint8_t* names, unsigned count, uint32_t version) {
+    if (!userTableReserve(&userTable, userTable.count + count)) {
+        return false;
+    }
+    UserTable source;
+    memset(&source, 0, sizeof(source));
+    source.records = (PackedUser*)records;
+    source.names = (uint8_t*)names;
+    User batch[64];
+    for (unsigned i = 0; i < count; i += 64) {
+        unsigned n = count - i < 64 ? count - i : 64;
+        for (unsigned j = 0; j < n; j++) {
+            const PackedUser* record = &records[i + j];
+            if (version >= 6) {
+                userTableUnpack(&source, record, &batch[j]);
+                continue;
+            }
+            User* user = &batch[j];
+            memset(user, 0, sizeof(*user));
+            const uint8_t* entry = names + record->names;
+            entry += readUserString(entry, user->name, sizeof(user->name));
+            entry += readUserString(entry, user->surname, sizeof(user->surname));
+            if (record->phone == USER_PHONE_SPILLED) {
+                readUserString(entry, user->phone, sizeof(user->phone));
+            }
+            else {
+                unpackBcdUserPhone(record->phone, user->phone);
+            }
+            user->passwordCost = record->passwordCost;
+            memcpy(user->salt, record->salt, sizeof(user->salt));
+            memcpy(user->passwordHash, record->passwordHash, sizeof(user->passwordHash));
+        }
+        if (!userTableAppend(batch, n)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Checks that an indexed users.bin header describes a file of the mapped size.
+ *
+ * @param header Pointer to the header at the start of the mapping.
+ * @param size Size of the mapped file in bytes.
+ * @return true if the header is usable; false otherwise.
+ */
+bool userFileHeaderValid(const UserFileHeader* header, size_t size) {
+    size_t recordSize = header->version < 3 ? sizeof(LegacyUser) : header->version < 5 ? sizeof(User) :
+        sizeof(PackedUser);
+    if (header->version < 1 || header->version > USER_FILE_VERSION || header->recordSize != recordSize ||
+        header->hashFunction >= sizeof(userHashFunctions) / sizeof(userHashFunctions[0]) ||
+        (header->version >= 2 && header->probePolicy >= USER_PROBE_POLICY_COUNT)) {
+        return false;
+    }
+    if (header->capacity != 0 && (header->capacity & (header->capacity - 1)) != 0) {
+        return false;
+    }
+    if ((unsigned long long)header->count * 100 > (unsigned long long)header->capacity * USER_TABLE_MAX_LOAD_PERCENT) {
+        return false;
+    }
+    uint64_t recordsEnd = header->recordsOffset + (uint64_t)header->count * recordSize;
+    uint64_t slotsEnd = header->slotsOffset + (uint64_t)header->capacity * sizeof(UserSlot);
+    size_t headerSize = header->version == 1 ? offsetof(UserFileHeader, logGeneration) :
+        header->version < 4 ? offsetof(UserFileHeader, filterOffset) :
+        header->version < 5 ? offsetof(UserFileHeader, namesOffset) : sizeof(UserFileHeader);
+    if (header->version >= 5 && (header->namesOffset > size || header->namesSize > size - header->namesOffset ||
+        header->namesSize > UINT32_MAX)) {
+        return false;
+    }
+    if (header->version >= 4 && header->filterBlocks != 0 &&
+        (header->filterBlocks != userTableFilterSize(header->capacity) ||
+        header->filterOffset % sizeof(UserFilterBlock) != 0 ||
+        header->filterOffset + (uint64_t)header->filterBlocks * sizeof(UserFilterBlock) > size)) {
+        return false;
+    }
+    return header->recordsOffset >= headerSize && recordsEnd <= size && slotsEnd <= size &&
+        header->recordsOffset % sizeof(uint64_t) == 0 && header->slotsOffset % sizeof(uint64_t) == 0;
+}
+
+/**
+ * @brief Tells whether a mapped users file is in the indexed format.
+ *
+ * The magic alone does not decide it: a file of LegacyUser records whose first
+ * name starts with "EVUS" carries it too. The version and the sizes in the
+ * header must also fit the file.
+ *
+ * @param mapping The mapped file.
+ * @return true if the file starts with a usable UserFileHeader.
+ */
+bool userFileIndexed(const FileMapping* mapping) {
+    const UserFileHeader* header = (const UserFileHeader*)mapping->data;
+    return mapping->size >= sizeof(UserFileHeader) && memcmp(header->magic, USER_FILE_MAGIC, 4) == 0 &&
+        header->version >= 1 && header->version <= USER_FILE_VERSION && userFileHeaderValid(header, mapping->size);
+}
+
+/**
+ * @brief Checks that a name arena entry lies within the arena.
+ *
+ * @param names The name arena.
+ * @param namesSize Size of the arena in bytes.
+ * @param offset Offset of the entry.
+ * @param strings Number of varint-length strings in the entry.
+ * @return true if every length and string of the entry is inside the arena.
+ */
+bool userNamesEntryValid(const uint8_t* names, size_t namesSize, uint32_t offset, unsigned strings) {
+    size_t position = offset;
+    for (unsigned i = 0; i < strings; i++) {
+        uint32_t length = 0;
+        uint8_t byte;
+        unsigned shift = 0;
+        do {
+            if (position >= namesSize || shift >= 35) {
+                return false;
+            }
+            byte = names[position++];
+            length |= (uint32_t)(byte & 0x7F) << shift;
+            shift += 7;
+        } while ((byte & 0x80) != 0);
+        if (length > namesSize - position) {
+            return false;
+        }
+        position += length;
+    }
+    return true;
+}
+
+/**
+ * @brief Checks the packed records of an indexed users file against its name arena.
+ *
+ * @param header The header of a version 5 or later file, valid for its mapping.
+ * @param data The mapped file.
+ * @return true if the arena entry of every record is inside the arena.
+ */
+bool userFileRecordsValid(const UserFileHeader* header, const char* data) {
+    const PackedUser* records = (const PackedUser*)(data + header->recordsOffset);
+    const uint8_t* names = (const uint8_t*)(data + header->namesOffset);
+    for (uint32_t i = 0; i < header->count; i++) {
+        // Version 5 entries only hold the phone number when it did not fit the BCD key
+        unsigned strings = header->version >= 6 || records[i].phone == USER_PHONE_SPILLED ? 3 : 2;
+        if (!userNamesEntryValid(names, (size_t)header->namesSize, records[i].names, strings)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Checks that every index slot of an indexed users file refers to one of its records.
+ *
+ * @param header The header, valid for its mapping.
+ * @param data The mapped file.
+ * @return true if no slot holds a record index past `count`.
+ */
+bool userFileSlotsValid(const UserFileHeader* header, const char* data) {
+    const UserSlot* slots = (const UserSlot*)(data + header->slotsOffset);
+    for (uint32_t i = 0; i < header->capacity; i++) {
+        if (slots[i].record > header->count) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Layouts of users.bin.
+ */
+typedef enum UserFileLayout {
+    USER_FILE_INDEXED,           /**< Records and hash index, memory-mapped at startup (UserFileHeader). */
+    USER_FILE_PAGED              /**< Bucket pages read on demand (UserPageFileHeader). */
+} UserFileLayout;
+
+/**
+ * @brief Layout written by checkpoints.
+ *
+ * Loading a paged users.bin selects USER_FILE_PAGED; change it with `setUserFileLayout`.
+ */
+UserFileLayout userFileLayout = USER_FILE_INDEXED;
+
+/**
+ * @brief Returns the index of the current user hash function in `userHashFunctions`.
+ */
+uint32_t userHashFunctionIndex() {
+    for (uint32_t i = 0; i < sizeof(userHashFunctions) / sizeof(userHashFunctions[0]); i++) {
+        if (userHashFunctions[i] == userHashFunction) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Signature that identifies the directory file of a paged users file.
+ */
+#define USER_PAGE_DIRECTORY_MAGIC "EVUD"
+
+/**
+ * @brief Header of the directory file saved next to a paged users file.
+ *
+ * The header is followed by the 2^depth page indexes of the directory and by
+ * the filter blocks of the `pageCount` pages. A directory whose depth or page
+ * count differs from the users file, or whose checksums do not match, is
+ * stale and rebuilt from the pages.
+ */
+typedef struct UserPageDirectoryHeader {
+    char magic[4];               /**< USER_PAGE_DIRECTORY_MAGIC, not null-terminated. */
+    uint32_t depth;              /**< Global depth of the directory. */
+    uint32_t pageCount;          /**< Page count of the users file the directory belongs to. */
+    uint32_t checksum;           /**< Checksum of the page indexes. */
+    uint32_t filterChecksum;     /**< Checksum of the filter blocks. */
+} UserPageDirectoryHeader;
+
+/**
+ * @brief Computes the checksum of a page directory.
+ */
+uint32_t userPageDirectoryChecksum(const uint32_t* directory, uint32_t depth) {
+    uint64_t h = wyHash((const char*)directory, ((size_t)1 << depth) * sizeof(uint32_t));
+    return (uint32_t)(h ^ (h >> 32));
+}
+
+/**
+ * @brief Computes the checksum of the filter blocks of a paged users file.
+ */
+uint32_t userPageFilterChecksum(const UserFilterBlock* filter, uint32_t pages) {
+    uint64_t h = wyHash((const char*)filter, (size_t)pages * sizeof(UserFilterBlock));
+    return (uint32_t)(h ^ (h >> 32));
+}
+
+/**
+ * @brief Writes the directory of a paged users file to `path` + ".dir".
+ *
+ * The directory is written under a temporary name and renamed into place.
+ *
+ * @param paged The open paged file.
+ * @return true if the directory was written; false otherwise.
+ */
+bool saveUserPageDirectory(const UserPagedFile* paged) {
+    char path[272];
+    char tempPath[276];
+    snprintf(path, sizeof(path), "%s.dir", paged->path);
+    snprintf(tempPath, sizeof(tempPath), "%s.tmp", path);
+    FILE* file = fopen(tempPath, "wb");
+    if (file == NULL) {
+        return false;
+    }
+
+    UserPageDirectoryHeader header;
+    memcpy(header.magic, USER_PAGE_DIRECTORY_MAGIC, 4);
+    header.depth = paged->header.depth;
+    header.pageCount = paged->header.pageCount;
+    header.checksum = userPageDirectoryChecksum(paged->directory, header.depth);
+    header.filterChecksum = userPageFilterChecksum(paged->filter, header.pageCount);
+    size_t entries = (size_t)1 << header.depth;
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+        fwrite(paged->directory, sizeof(uint32_t), entries, file) == entries &&
+        fwrite(paged->filter, sizeof(UserFilterBlock), header.pageCount, file) == header.pageCount;
+    written = fclose(file) == 0 && written;
+    if (!written) {
+        remove(tempPath);
+        return false;
+    }
+
+#if defined(_WIN32) || defined(_WIN64)
+    remove(path); // rename does not replace an existing file on Windows
+#endif
+    return rename(tempPath, path) == 0;
+}
+
+/**
+ * @brief Reads the directory of a paged users file from `path` + ".dir".
+ *
+ * @param paged The open paged file; receives the directory and the filter.
+ * @return true if a directory matching the file was read; false if it is missing or stale.
+ */
+bool loadUserPageDirectory(UserPagedFile* paged) {
+    char path[272];
+    snprintf(path, sizeof(path), "%s.dir", paged->path);
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        return false;
+    }
+
+    UserPageDirectoryHeader header;
+    bool valid = fread(&header, sizeof(header), 1, file) == 1 &&
+        memcmp(header.magic, USER_PAGE_DIRECTORY_MAGIC, 4) == 0 && header.depth == paged->header.depth &&
+        header.depth <= USER_PAGE_MAX_DEPTH && header.pageCount == paged->header.pageCount;
+    size_t entries = valid ? (size_t)1 << header.depth : 0;
+    uint32_t* directory = valid ? (uint32_t*)malloc(entries * sizeof(uint32_t)) : NULL;
+    valid = directory != NULL && fread(directory, sizeof(uint32_t), entries, file) == entries &&
+        userPageDirectoryChecksum(directory, header.depth) == header.checksum;
+    for (size_t i = 0; valid && i < entries; i++) {
+        valid = directory[i] < paged->header.pageCount;
+    }
+    valid = valid && userPageFilterReserve(paged, header.pageCount) &&
+        fread(paged->filter, sizeof(UserFilterBlock), header.pageCount, file) == header.pageCount &&
+        userPageFilterChecksum(paged->filter, header.pageCount) == header.filterChecksum;
+    fclose(file);
+    if (!valid) {
+        free(directory);
+        return false;
+    }
+    paged->directory = directory;
+    return true;
+}
+
+/**
+ * @brief Writes the header page of an open paged users file and flushes the file.
+ *
+ * @param paged The open paged file.
+ * @return true if the header was written; false otherwise.
+ */
+bool writeUserPageHeader(UserPagedFile* paged) {
+    return seekUserFile(paged->file, 0) && fwrite(&paged->header, sizeof(paged->header), 1, paged->file) == 1 &&
+        fflush(paged->file) == 0;
+}
+
+/**
+ * @brief Writes the header and directory of a paged users file after its pages.
+ *
+ * The pages are flushed first and the header page last, so a directory or
+ * header that does not match the pages is detected and rebuilt on open.
+ *
+ * @param paged The open paged file.
+ * @return true if everything was written; false otherwise.
+ */
+bool commitUserPagedFile(UserPagedFile* paged) {
+    return fflush(paged->file) == 0 && saveUserPageDirectory(paged) && writeUserPageHeader(paged);
+}
+
+/**
+ * @brief Returns the number of complete bucket pages in a paged users file.
+ */
+uint32_t userPagedFilePages(FILE* file) {
+#if defined(_WIN32) || defined(_WIN64)
+    long long size = _fseeki64(file, 0, SEEK_END) == 0 ? _ftelli64(file) : -1;
+#else
+    long long size = fseeko(file, 0, SEEK_END) == 0 ? (long long)ftello(file) : -1;
+#endif
+    if (size < (long long)(USER_PAGE_SIZE + sizeof(UserPage))) {
+        return 0;
+    }
+    unsigned long long pages = ((unsigned long long)size - USER_PAGE_SIZE + USER_PAGE_SIZE - sizeof(UserPage)) / USER_PAGE_SIZE;
+    return pages > UINT32_MAX ? UINT32_MAX : (uint32_t)pages;
+}
+
+/**
+ * @brief Rebuilds the directory of a paged users file from its pages.
+ *
+ * Used when the saved directory is missing or stale, e.g. after a crash during
+ * a checkpoint. Every complete page claims the directory entries of its prefix,
+ * shallow pages first, so the halves taken over by later splits go to the newer
+ * pages. A page whose split was interrupted before it was rewritten still holds
+ * copies of the records moved to its new sibling; those copies are dropped and
+ * the page gets the depth of the entries it kept. The filter is refilled from
+ * the pages and the header is rewritten with the recovered page and record counts.
+ *
+ * The caller must hold the user store lock exclusively.
+ *
+ * @param paged The open paged file; receives the directory.
+ * @return true if every directory entry was claimed by a page; false otherwise.
+ */
+bool rebuildUserPageDirectory(UserPagedFile* paged) {
+    uint32_t pages = userPagedFilePages(paged->file);
+    std::vector<uint32_t> depths(pages);
+    std::vector<uint32_t> prefixes(pages);
+    UserPage page;
+    uint32_t depth = 0;
+    for (uint32_t i = 0; i < pages; i++) {
+        if (!readUserPage(paged, i, &page) || page.depth > USER_PAGE_MAX_DEPTH || page.prefix > userPageMask(page.depth)) {
+            return false;
+        }
+        depths[i] = page.depth;
+        prefixes[i] = page.prefix;
+        depth = page.depth > depth ? page.depth : depth;
+    }
+
+    size_t entries = (size_t)1 << depth;
+    uint32_t* directory = (uint32_t*)malloc(entries * sizeof(uint32_t));
+    if (directory == NULL || pages == 0) {
+        free(directory);
+        return false;
+    }
+    for (size_t i = 0; i < entries; i++) {
+        directory[i] = UINT32_MAX;
+    }
+    for (uint32_t d = 0; d <= depth; d++) {
+        for (uint32_t i = 0; i < pages; i++) {
+            for (size_t j = prefixes[i]; depths[i] == d && j < entries; j += (size_t)1 << d) {
+                directory[j] = i;
+            }
+        }
+    }
+
+    std::vector<uint32_t> claimed(pages, 0);
+    for (size_t i = 0; i < entries; i++) {
+        if (directory[i] == UINT32_MAX) {
+            free(directory);
+            return false;
+        }
+        claimed[directory[i]]++;
+    }
+
+    paged->directory = directory;
+    paged->header.depth = depth;
+    paged->header.pageCount = pages;
+    paged->header.count = 0;
+    if (!userPageFilterReserve(paged, pages)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < pages; i++) {
+        if (!readUserPage(paged, i, &page)) {
+            return false;
+        }
+        if (claimed[i] != (uint32_t)(entries >> depths[i])) {
+            uint32_t kept = 0;
+            for (uint32_t j = 0; j < page.count; j++) {
+                const char* phone = page.records[j].phone;
+                if (claimed[i] > 0 && directory[userPagedPhoneHash(paged, phone) & userPageMask(depth)] == i) {
+                    page.records[kept++] = page.records[j];
+                }
+            }
+            page.count = kept;
+            while (claimed[i] > 0 && (entries >> page.depth) > claimed[i]) {
+                page.depth++;
+            }
+            if (!writeUserPage(paged, i, &page)) {
+                return false;
+            }
+        }
+        userPageFilterRebuild(paged, i, &page);
+        paged->header.count += page.count;
+    }
+    return fflush(paged->file) == 0;
+}
+
+/**
+ * @brief Opens a users file in the paged layout.
+ *
+ * Only the header page and the directory are read; bucket pages are read as
+ * lookups need them. A missing or stale directory is rebuilt from the pages.
+ *
+ * @param path Path of the users file.
+ * @param paged Receives the open file; any file it held is closed first.
+ * @return true if the file is a valid paged users file; false otherwise.
+ */
+bool openUserPagedFile(const char* path, UserPagedFile* paged) {
+    closeUserPagedFile(paged);
+    FILE* file = fopen(path, "r+b");
+    if (file == NULL) {
+        return false;
+    }
+
+    UserPageFileHeader header;
+    bool valid = fread(&header, sizeof(header), 1, file) == 1 && memcmp(header.magic, USER_PAGE_MAGIC, 4) == 0 &&
+        header.version >= 1 && header.version <= USER_PAGE_VERSION && header.pageSize == USER_PAGE_SIZE &&
+        header.recordSize == sizeof(User) && header.pageCount > 0 &&
+        header.hashFunction < sizeof(userHashFunctions) / sizeof(userHashFunctions[0]);
+    if (!valid) {
+        fclose(file);
+        return false;
+    }
+
+    paged->file = file;
+    paged->header = header;
+    paged->hashFunction = userHashFunctions[header.hashFunction];
+    snprintf(paged->path, sizeof(paged->path), "%s", path);
+    if (header.version == 1) {
+        valid = header.depth == 0 && userPagedFilePages(file) >= header.pageCount;
+    }
+    else if (header.depth > USER_PAGE_MAX_DEPTH || userPagedFilePages(file) != header.pageCount ||
+        !loadUserPageDirectory(paged)) {
+        valid = rebuildUserPageDirectory(paged) && commitUserPagedFile(paged); // Interrupted checkpoint or lost directory
+    }
+    if (!valid) {
+        closeUserPagedFile(paged);
+    }
+    return valid;
+}
+
+/**
+ * @brief Doubles the directory of a paged users file.
+ *
+ * The new upper half repeats the lower half: no page changes.
+ *
+ * @param paged The open paged file.
+ * @return true if the directory was doubled; false if it is at its largest or cannot grow.
+ */
+bool userPageDirectoryGrow(UserPagedFile* paged) {
+    if (paged->header.depth >= USER_PAGE_MAX_DEPTH) {
+        return false;
+    }
+    size_t entries = (size_t)1 << paged->header.depth;
+    uint32_t* directory = (uint32_t*)realloc(paged->directory, 2 * entries * sizeof(uint32_t));
+    if (directory == NULL) {
+        return false;
+    }
+    memcpy(directory + entries, directory, entries * sizeof(uint32_t));
+    paged->directory = directory;
+    paged->header.depth++;
+    return true;
+}
+
+/**
+ * @brief Splits a full page into itself and a new page at the end of the file.
+ *
+ * Records whose hash has bit `depth` set move to the new page and the
+ * directory entries of the new prefix are pointed at it; the filter blocks of
+ * both pages are refilled from their records. The directory doubles
+ * first when the page was as deep as the directory. The new page is written
+ * before the old one shrinks, so a crash in between leaves copies that
+ * `rebuildUserPageDirectory` removes, never lost records.
+ *
+ * The caller must hold the user store lock exclusively.
+ *
+ * @param paged The open paged file.
+ * @param index Index of the page to split.
+ * @param page The page, as read from the file; updated to its new contents.
+ * @return true if the page was split; false otherwise.
+ */
+bool userPagedFileSplit(UserPagedFile* paged, uint32_t index, UserPage* page) {
+    if (paged->header.pageCount == UINT32_MAX || !userPageFilterReserve(paged, paged->header.pageCount + 1) ||
+        (page->depth == paged->header.depth && !userPageDirectoryGrow(paged))) {
+        return false;
+    }
+
+    UserPage sibling;
+    memset(&sibling, 0, sizeof(sibling));
+    uint32_t bit = page->depth;
+    sibling.depth = bit + 1;
+    sibling.prefix = page->prefix | (1u << bit);
+    page->depth = bit + 1;
+    uint32_t kept = 0;
+    for (uint32_t j = 0; j < page->count; j++) {
+        const char* phone = page->records[j].phone;
+        if ((userPagedPhoneHash(paged, phone) >> bit) & 1) {
+            sibling.records[sibling.count++] = page->records[j];
+        }
+        else {
+            page->records[kept++] = page->records[j];
+        }
+    }
+    page->count = kept;
+    memset(&page->records[kept], 0, (USER_PAGE_RECORDS - kept) * sizeof(User));
+
+    uint32_t siblingIndex = paged->header.pageCount;
+    if (!writeUserPage(paged, siblingIndex, &sibling) || !writeUserPage(paged, index, page)) {
+        return false;
+    }
+    paged->header.pageCount++;
+    size_t entries = (size_t)1 << paged->header.depth;
+    for (size_t i = sibling.prefix; i < entries; i += (size_t)1 << sibling.depth) {
+        paged->directory[i] = siblingIndex;
+    }
+    userPageFilterRebuild(paged, index, page);
+    userPageFilterRebuild(paged, siblingIndex, &sibling);
+    return true;
+}
+
+/**
+ * @brief Stores a record in the page the directory names for it.
+ *
+ * A full page is split until the record fits, so an insert reads one page and
+ * writes one, plus two page writes per split. A record of a phone number the
+ * page already holds replaces the stored record in place; if it is identical
+ * the page is not written at all, so a checkpoint interrupted after some of its
+ * records were written can be repeated. The header and directory are not written.
+ *
+ * The caller must hold the user store lock exclusively.
+ *
+ * @param paged The open paged file, in the current version.
+ * @param user The record to store.
+ * @return true if the record is stored; false if its page cannot split further or the file cannot be written.
+ */
+bool userPagedFileInsert(UserPagedFile* paged, const User* user) {
+    UserPage page;
+    uint64_t h = userPagedPhoneHash(paged, user->phone);
+    for (;;) {
+        uint32_t index = paged->directory[h & userPageMask(paged->header.depth)];
+        if (!readUserPage(paged, index, &page)) {
+            return false;
+        }
+        bool stored = false;
+        bool changed = false;
+        for (uint32_t j = 0; j < page.count; j++) {
+            User* record = &page.records[j];
+            if (userPagedPhonesMatch(paged, record->phone, user->phone)) {
+                stored = true;
+                if (memcmp(record, user, offsetof(User, next)) != 0 || record->passwordCost != user->passwordCost ||
+                    memcmp(record->salt, user->salt, sizeof(user->salt)) != 0 ||
+                    memcmp(record->passwordHash, user->passwordHash, sizeof(user->passwordHash)) != 0) {
+                    *record = *user;
+                    record->next = NULL;
+                    changed = true;
+                }
+            }
+        }
+        if (stored) {
+            return !changed || writeUserPage(paged, index, &page); // Unchanged: written by an interrupted checkpoint
+        }
+        if (page.count < USER_PAGE_RECORDS) {
+            page.records[page.count] = *user;
+            page.records[page.count].next = NULL;
+            page.count++;
+            if (!writeUserPage(paged, index, &page)) {
+                return false;
+            }
+            userFilterBlockAdd(&paged->filter[index], userFilterMix(h));
+            paged->header.count++;
+            return true;
+        }
+        if (!userPagedFileSplit(paged, index, &page)) {
+            return false;
+        }
+    }
+}
+
+/**
+ * @brief Writes a new paged users file from a paged file and the user table.
+ *
+ * The file starts as a single empty page under a temporary name, receives the
+ * records of `source` (streamed page by page, so it can be far larger than
+ * memory) and of the table, and is renamed over `path` together with its
+ * directory. `source` is closed and `paged` receives the new file.
+ *
+ * The caller must hold the user store lock exclusively.
+ *
+ * @param path Path of the users file.
+ * @param source Paged file whose records are copied, or NULL.
+ * @param paged Receives the new file; may be the same as `source`.
+ * @return true if the file was written; false otherwise, in which case `source` stays open.
+ */
+bool saveUserPagedFile(const char* path, UserPagedFile* source, UserPagedFile* paged) {
+    UserPagedFile target;
+    memset(&target, 0, sizeof(target));
+    snprintf(target.path, sizeof(target.path), "%s.tmp", path);
+    target.file = fopen(target.path, "w+b");
+    target.directory = (uint32_t*)calloc(1, sizeof(uint32_t));
+    if (target.file == NULL || target.directory == NULL || !userPageFilterReserve(&target, 1)) {
+        closeUserPagedFile(&target);
+        return false;
+    }
+    memcpy(target.header.magic, USER_PAGE_MAGIC, 4);
+    target.header.version = USER_PAGE_VERSION;
+    target.header.pageSize = USER_PAGE_SIZE;
+    target.header.recordSize = sizeof(User);
+    target.header.hashFunction = userHashFunctionIndex();
+    target.header.pageCount = 1;
+    target.header.logGeneration = userLogGeneration;
+    target.hashFunction = userHashFunction;
+
+    UserPage page;
+    memset(&page, 0, sizeof(page));
+    char* padding = (char*)calloc(1, USER_PAGE_SIZE);
+    bool written = padding != NULL && fwrite(padding, USER_PAGE_SIZE, 1, target.file) == 1 &&
+        writeUserPage(&target, 0, &page);
+    free(padding);
+
+    for (uint32_t i = 0; written && source != NULL && source->file != NULL && i < source->header.pageCount; i++) {
+        written = readUserPage(source, i, &page);
+        for (uint32_t j = 0; written && j < page.count; j++) {
+            written = userPagedFileInsert(&target, &page.records[j]);
+        }
+    }
+    User user;
+    for (unsigned i = 0; written && i < userTable.count; i++) {
+        userTableUnpack(&userTable, &userTable.records[i], &user);
+        written = userPagedFileInsert(&target, &user);
+    }
+    written = written && commitUserPagedFile(&target);
+
+    char tempPath[260];
+    char directoryPath[272];
+    char tempDirectoryPath[276];
+    snprintf(tempPath, sizeof(tempPath), "%s", target.path);
+    snprintf(directoryPath, sizeof(directoryPath), "%s.dir", path);
+    snprintf(tempDirectoryPath, sizeof(tempDirectoryPath), "%s.dir", tempPath);
+    closeUserPagedFile(&target);
+    if (!written) {
+        remove(tempDirectoryPath);
+        remove(tempPath);
+        return false;
+    }
+
+    if (source != NULL) {
+        closeUserPagedFile(source);
+    }
+#if defined(_WIN32) || defined(_WIN64)
+    remove(path); // rename does not replace an existing file on Windows
+    remove(directoryPath);
+#endif
+    // A crash between the renames leaves a stale directory, which is rebuilt on open
+    return rename(tempPath, path) == 0 && rename(tempDirectoryPath, directoryPath) == 0 &&
+        openUserPagedFile(path, paged);
+}
+
+/**
+ * @brief Moves the users of the hash table into the paged users file.
+ *
+ * The records are inserted into the open paged file page by page; pages split
+ * as they fill, so the file grows without ever being reorganised as a whole.
+ * A version 1 file, or no file at all, is first rewritten in the current
+ * version. The saved directory is removed before any page changes, so after a
+ * crash the directory and the page filters are rebuilt from the pages. The
+ * header page, written last, records the current log generation.
+ * The table is then emptied: from now on its users are read from disk.
+ *
+ * The caller must hold the user store lock exclusively.
+ *
+ * @param path Path of the users file.
+ * @return true if every user was written; false otherwise.
+ */
+bool checkpointUserPages(const char* path) {
+    UserPagedFile* paged = &userPagedFile;
+    bool written;
+    if (paged->file == NULL || paged->header.version < USER_PAGE_VERSION) {
+        written = saveUserPagedFile(path, paged, paged);
+    }
+    else {
+        char directoryPath[272];
+        snprintf(directoryPath, sizeof(directoryPath), "%s.dir", path);
+        if (userTable.count > 0) {
+            remove(directoryPath); // Its filter would miss pages written before a crash
+        }
+        written = true;
+        User user;
+        for (unsigned i = 0; written && i < userTable.count; i++) {
+            userTableUnpack(&userTable, &userTable.records[i], &user);
+            written = userPagedFileInsert(paged, &user);
+        }
+        paged->header.logGeneration = userLogGeneration;
+        written = written && commitUserPagedFile(paged);
+    }
+    if (written) {
+        userTableRelease();
+    }
+    return written;
+}
+
+/**
+ * @brief Copies every user of the paged users file into the hash table and closes the file.
+ *
+ * The caller must hold the user store lock exclusively.
+ *
+ * @return true if every page was read and stored; false otherwise, in which case the file stays open.
+ */
+bool userPagedFileLoad() {
+    UserPage page;
+    for (uint32_t i = 0; userPagedFile.file != NULL && i < userPagedFile.header.pageCount; i++) {
+        if (!readUserPage(&userPagedFile, i, &page) || !userTableAppend(page.records, page.count)) {
+            return false;
+        }
+    }
+    closeUserPagedFile(&userPagedFile);
+    return true;
+}
+
+/**
+ * @brief Loads a users file into the hash table.
+ *
+ * A file in the paged layout is opened and only its header is read; its users
+ * are read page by page as lookups need them, and later checkpoints keep the
+ * paged layout. Any other file is memory-mapped. If it is in the indexed format, was written with
+ * the current hash function and probe policy and the table is empty, the table reads records
+ * and index slots straight from the mapping: startup only checks that the name
+ * arena entries of the records and the record indexes of the slots are in
+ * bounds, and nothing is copied (files written before the phone number filter
+ * was stored have it built from their slots). Otherwise, or if a slot is out of
+ * bounds, the records are copied into the slab and indexed; records from files written
+ * before records were packed are packed as they are copied, and those from
+ * files written before passwords were hashed have their passwords hashed. A
+ * file whose arena entries leave the arena is not loaded.
+ *
+ * The caller must hold the user store lock exclusively.
+ *
+ * @param path Path of the users file.
+ * @return true if the file was read; false if it is missing or empty.
+ */
+bool loadUserFile(const char* path) {
+    userNameIndexReset();
+    if (openUserPagedFile(path, &userPagedFile)) {
+        userLogGeneration = userPagedFile.header.logGeneration;
+        userFileLayout = USER_FILE_PAGED;
+        return true;
+    }
+
+    FileMapping mapping;
+    if (!mapFile(path, &mapping)) {
+        return false;
+    }
+    if (mapping.size >= 4 && memcmp(mapping.data, USER_PAGE_MAGIC, 4) == 0) {
+        unmapFile(&mapping); // A paged file that failed validation
+        return false;
+    }
+
+    const UserFileHeader* header = (const UserFileHeader*)mapping.data;
+    if (userFileIndexed(&mapping)) {
+        if (header->version >= 5 && !userFileRecordsValid(header, mapping.data)) {
+            unmapFile(&mapping);
+            return false;
+        }
+
+        userLogGeneration = header->version >= 2 ? header->logGeneration : 0;
+        if (header->version < 3) {
+            userTableAppendLegacy((const LegacyUser*)(mapping.data + header->recordsOffset), header->count);
+            unmapFile(&mapping);
+            return true;
+        }
+
+        if (header->version < 5) {
+            userTableAppend((const User*)(mapping.data + header->recordsOffset), header->count);
+            unmapFile(&mapping);
+            return true;
+        }
+
+        PackedUser* records = (PackedUser*)(mapping.data + header->recordsOffset);
+        uint8_t* names = (uint8_t*)(mapping.data + header->namesOffset);
+        if (header->version == USER_FILE_VERSION && userTable.count == 0 && header->count > 0 &&
+            userHashFunctions[header->hashFunction] == userHashFunction &&
+            header->probePolicy == (uint32_t)userProbePolicy && userFileSlotsValid(header, mapping.data)) {
+            userTableClear();
+            userFile = mapping;
+            userTable.records = records;
+            userTable.recordCapacity = header->count;
+            userTable.names = names;
+            userTable.namesSize = (size_t)header->namesSize;
+            userTable.namesCapacity = (size_t)header->namesSize;
+            userTable.count = header->count;
+            userTable.slots = (UserSlot*)(mapping.data + header->slotsOffset);
+            userTable.capacity = header->capacity;
+            userTable.filterBlocks = userTableFilterSize(userTable.capacity);
+            userTable.filter = header->version >= 4 && header->filterBlocks != 0 ?
+                (UserFilterBlock*)(mapping.data + header->filterOffset) :
+                buildUserTableFilter(userTable.slots, userTable.capacity);
+            return true;
+        }
+
+        userTableAppendPacked(records, names, header->count, header->version);
+    }
+    else if (mapping.size % sizeof(LegacyUser) == 0) {
+        userTableAppendLegacy((const LegacyUser*)mapping.data, (unsigned)(mapping.size / sizeof(LegacyUser)));
+    }
+    else {
+        unmapFile(&mapping); // A damaged indexed file, or not a users file at all
+        return false;
+    }
+
+    unmapFile(&mapping);
+    return true;
+}
+
+/**
+ * @brief Writes the hash table to a users file in the indexed format.
+ *
+ * The file is written under a temporary name and renamed over `path`, so a
+ * crash while saving never leaves a half-written users file behind. Any running
+ * rehash is completed first so that a single slot array is stored.
+ *
+ * The caller must hold the user store lock exclusively.
+ *
+ * @param path Path of the users file.
+ * @return true if the file was written; false otherwise.
+ */
+bool saveUserFile(const char* path) {
+    if (!userTableDetach(&userTable)) {
+        return false;
+    }
+    userTableMigrate(&userTable, userTable.oldCapacity);
+
+    UserFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, USER_FILE_MAGIC, 4);
+    header.version = USER_FILE_VERSION;
+    header.recordSize = sizeof(PackedUser);
+    for (uint32_t i = 0; i < sizeof(userHashFunctions) / sizeof(userHashFunctions[0]); i++) {
+        if (userHashFunctions[i] == userHashFunction) {
+            header.hashFunction = i;
+        }
+    }
+    header.count = userTable.count;
+    header.capacity = userTable.capacity;
+    header.recordsOffset = sizeof(UserFileHeader);
+    header.slotsOffset = header.recordsOffset + (uint64_t)userTable.count * sizeof(PackedUser);
+    header.logGeneration = userLogGeneration;
+    header.probePolicy = (uint32_t)userProbePolicy;
+    uint64_t slotsEnd = header.slotsOffset + (uint64_t)userTable.capacity * sizeof(UserSlot);
+    if (userTable.filter != NULL) {
+        header.filterBlocks = userTable.filterBlocks;
+        header.filterOffset = (slotsEnd + sizeof(UserFilterBlock) - 1) / sizeof(UserFilterBlock) * sizeof(UserFilterBlock);
+    }
+    char padding[sizeof(UserFilterBlock)] = { 0 };
+    size_t paddingSize = header.filterBlocks != 0 ? (size_t)(header.filterOffset - slotsEnd) : 0;
+    header.namesOffset = slotsEnd + paddingSize + (uint64_t)header.filterBlocks * sizeof(UserFilterBlock);
+    header.namesSize = userTable.namesSize;
+
+    char tempPath[260];
+    snprintf(tempPath, sizeof(tempPath), "%s.tmp", path);
+    FILE* file = fopen(tempPath, "wb");
+    if (file == NULL) {
+        return false;
+    }
+
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+        fwrite(userTable.records, sizeof(PackedUser), userTable.count, file) == userTable.count &&
+        fwrite(userTable.slots, sizeof(UserSlot), userTable.capacity, file) == userTable.capacity &&
+        fwrite(padding, 1, paddingSize, file) == paddingSize &&
+        fwrite(userTable.filter, sizeof(UserFilterBlock), header.filterBlocks, file) == header.filterBlocks &&
+        fwrite(userTable.names, 1, userTable.namesSize, file) == userTable.namesSize;
+    written = fclose(file) == 0 && written;
+    if (!written) {
+        remove(tempPath);
+        return false;
+    }
+
+#if defined(_WIN32) || defined(_WIN64)
+    remove(path); // rename does not replace an existing file on Windows
+#endif
+    return rename(tempPath, path) == 0;
+}
+
+/**
+ * @brief Signature that identifies a registration log file.
+ */
+#define USER_LOG_MAGIC "EVL2"
+
+/**
+ * @brief Signature of registration logs with LegacyUser records (plaintext passwords).
+ */
+#define USER_LOG_MAGIC_LEGACY "EVUL"
+
+/**
+ * @brief Minimum number of log records before the log is compacted into users.bin.
+ *
+ * Above this size the log is compacted once it holds a quarter as many records as
+ * the table, so compaction costs O(1) amortized I/O per registration.
+ */
+#define USER_LOG_COMPACT_MIN 1024
+
+/**
+ * @brief Header at the start of the registration log (users.log).
+ */
+typedef struct UserLogHeader {
+    char magic[4];               /**< USER_LOG_MAGIC, not null-terminated. */
+    uint32_t generation;         /**< Snapshot generation the log continues. */
+} UserLogHeader;
+
+/**
+ * @brief One registration appended to users.log.
+ *
+ * The checksum covers the user record, so a record torn by a crash while it was
+ * being written is detected and dropped during recovery.
+ */
+typedef struct UserLogRecord {
+    uint32_t checksum;           /**< Checksum of `user`, see `userLogChecksum`. */
+    uint32_t reserved;           /**< Always 0. */
+    User user;                   /**< The registered user, with `next` set to NULL. */
+} UserLogRecord;
+
+/**
+ * @brief Record of a registration log with the USER_LOG_MAGIC_LEGACY signature.
+ */
+typedef struct LegacyUserLogRecord {
+    uint32_t checksum;           /**< Checksum of `user`, see `userLogChecksum`. */
+    uint32_t reserved;           /**< Always 0. */
+    LegacyUser user;             /**< The registered user. */
+} LegacyUserLogRecord;
+
+/**
+ * @brief Number of records in users.log since the last compaction.
+ */
+unsigned userLogRecords = 0;
+
+/**
+ * @brief Computes the checksum stored with a log record.
+ *
+ * @param user Pointer to the user record, with `next` set to NULL.
+ * @param size Size of the user record in bytes.
+ * @return The 32-bit checksum of the record bytes.
+ */
+uint32_t userLogChecksum(const void* user, size_t size) {
+    uint64_t h = wyHash((const char*)user, size);
+    return (uint32_t)(h ^ (h >> 32));
+}
+
+/**
+ * @brief Starts an empty registration log for the current generation.
+ *
+ * @param path Path of the log file.
+ * @return true if the log was written; false otherwise.
+ */
+bool resetUserLog(const char* path) {
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        return false;
+    }
+    UserLogHeader header;
+    memcpy(header.magic, USER_LOG_MAGIC, 4);
+    header.generation = userLogGeneration;
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1;
+    written = fclose(file) == 0 && written;
+    userLogRecords = 0;
+    return written;
+}
+
+/**
+ * @brief Appends one registration to the log.
+ *
+ * This is the only disk write of a registration: one fixed-size record is added
+ * at the end of the file and flushed, independent of the number of users.
+ *
+ * @param path Path of the log file.
+ * @param user Pointer to the stored record of the registered user, whose password is hashed.
+ * @return true if the record was written; false otherwise.
+ */
+bool appendUserLog(const char* path, const User* user) {
+    FILE* file = fopen(path, "ab");
+    if (file == NULL) {
+        return false;
+    }
+
+    bool written = true;
+    fseek(file, 0, SEEK_END);
+    if (ftell(file) == 0) {
+        UserLogHeader header;
+        memcpy(header.magic, USER_LOG_MAGIC, 4);
+        header.generation = userLogGeneration;
+        written = fwrite(&header, sizeof(header), 1, file) == 1;
+        userLogRecords = 0;
+    }
+
+    UserLogRecord record;
+    memset(&record, 0, sizeof(record));
+    record.user = *user;
+    record.user.next = NULL;
+    record.checksum = userLogChecksum(&record.user, sizeof(record.user));
+    written = written && fwrite(&record, sizeof(record), 1, file) == 1;
+    written = fclose(file) == 0 && written;
+    if (written) {
+        userLogRecords++;
+    }
+    return written;
+}
+
+/**
+ * @brief Replays the registration log into the hash table after users.bin was loaded.
+ *
+ * Records are applied in order until the end of the file or the first record
+ * whose checksum does not match, which is what a crash in the middle of an
+ * append leaves behind. A log from an older generation than the snapshot was
+ * already compacted into it; it is not replayed but reset to an empty log of
+ * the current generation. Logs written before passwords were hashed are
+ * replayed with their passwords hashed.
+ *
+ * The caller must hold the user store lock exclusively.
+ *
+ * @param path Path of the log file.
+ * @return true if the log ended cleanly or does not exist; false if a torn or
+ *         corrupt record was dropped or the log is in the legacy format, in
+ *         which case it must be rewritten before new records are appended.
+ */
+bool replayUserLog(const char* path) {
+    userLogRecords = 0;
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        return true;
+    }
+
+    UserLogHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1) {
+        fclose(file);
+        return false;
+    }
+    bool legacy = memcmp(header.magic, USER_LOG_MAGIC_LEGACY, 4) == 0;
+    if (!legacy && memcmp(header.magic, USER_LOG_MAGIC, 4) != 0) {
+        fclose(file);
+        return false;
+    }
+    if (header.generation < userLogGeneration) {
+        // Already part of the snapshot: a crash between writing users.bin and
+        // resetting the log left it behind. New registrations must not be
+        // appended under its old generation, where the next replay skips them.
+        fclose(file);
+        return resetUserLog(path);
+    }
+
+    bool clean = !legacy; // New records cannot be appended to a legacy log
+    size_t recordSize = legacy ? sizeof(LegacyUserLogRecord) : sizeof(UserLogRecord);
+    union {
+        UserLogRecord current;
+        LegacyUserLogRecord legacy;
+    } record;
+    size_t read;
+    while ((read = fread(&record, 1, recordSize, file)) == recordSize) {
+        if (legacy) {
+            if (record.legacy.checksum != userLogChecksum(&record.legacy.user, sizeof(LegacyUser))) {
+                break;
+            }
+            userTableAppendLegacy(&record.legacy.user, 1);
+        }
+        else {
+            if (record.current.checksum != userLogChecksum(&record.current.user, sizeof(User))) {
+                clean = false;
+                break;
+            }
+            userTableUpsert(&record.current.user);
+        }
+        userLogRecords++;
+    }
+    if (read != 0 && read != recordSize) {
+        clean = false;
+    }
+
+    fclose(file);
+    return clean;
+}
+
+/**
+ * @brief Writes a users.bin snapshot of a new log generation and starts an empty log.
+ *
+ * In the paged layout the registrations held by the table are added to the
+ * pages of users.bin instead of rewriting the whole file.
+ *
+ * The caller must hold the user store lock exclusively.
+ *
+ * @return true if the snapshot was written; false otherwise.
+ */
+bool checkpointUserStore() {
+    userLogGeneration++;
+    bool saved = userFileLayout == USER_FILE_PAGED ? checkpointUserPages("users.bin") : saveUserFile("users.bin");
+    if (!saved) {
+        userLogGeneration--;
+        return false;
+    }
+    resetUserLog("users.log");
+    return true;
+}
+
+/**
+ * @brief Saves the hash table containing user data to a binary file for persistent storage.
+ *
+ * This function writes every stored user and the hash index to a binary file
+ * named `"users.bin"` in the indexed format described by UserFileHeader, and
+ * then starts an empty registration log. The snapshot records a new log
+ * generation, so the old log is ignored even if the program stops before the
+ * log is reset.
+ *
+ * ## Implementation Details:
+ * - The packed records are written with a single `fwrite()` straight from the record slab,
+ *   and the name arena with another.
+ * - The slot array is written after the records so the next startup can map the
+ *   file and authenticate without rebuilding the index.
+ * - The file is replaced atomically through a temporary file.
+ *
+ * ## Security Warning:
+ * - Ensure the binary file is stored securely to prevent unauthorized access to user data.
+ * - The function uses raw binary operations; changing the `PackedUser` structure changes
+ *   `recordSize`, and files written by other builds are then copied rather than mapped.
+ *
+ * @see saveUserFile(), loadHashTableFromFile()
+ */
+void saveHashTableToFile() {
+    lockUserStore(true);
+    checkpointUserStore();
+    unlockUserStore(true);
+}
+
+/**
+ * @brief Loads user records from a binary file into the hash table.
+ *
+ * This function memory-maps the file named "users.bin". Indexed files written
+ * by `saveHashTableToFile` are queried in place, so the application is ready to
+ * authenticate within milliseconds regardless of the number of users. Files in
+ * older formats, down to the original plain sequence of user records, are
+ * packed into the record slab in one pass.
+ *
+ * Registrations made since the snapshot are then replayed from "users.log".
+ * If the log ends in a torn record or is in the legacy format, the snapshot is
+ * rewritten right away so later appends start from a clean log.
+ *
+ * If neither file exists yet, the hash table is left unchanged.
+ */
+void loadHashTableFromFile() {
+    lockUserStore(true);
+    userLogGeneration = 0;
+    loadUserFile("users.bin");
+    if (!replayUserLog("users.log")) {
+        checkpointUserStore();
+    }
+    unlockUserStore(true);
+}
+
+/**
+ * @brief Selects the layout of users.bin and rewrites it in that layout.
+ *
+ * Switching to USER_FILE_PAGED moves every user of the table into bucket pages
+ * on disk, after which logins read one or two pages instead of keeping all
+ * users in memory. Switching back loads every page into the table first.
+ *
+ * @param layout The layout to use from now on.
+ * @return true if users.bin was written in the new layout; false otherwise.
+ */
+bool setUserFileLayout(UserFileLayout layout) {
+    lockUserStore(true);
+    bool changed = layout == USER_FILE_INDEXED || layout == USER_FILE_PAGED;
+    if (changed && layout == USER_FILE_INDEXED) {
+        changed = userPagedFileLoad();
+    }
+    if (changed) {
+        UserFileLayout previous = userFileLayout;
+        userFileLayout = layout;
+        changed = checkpointUserStore();
+        if (!changed) {
+            userFileLayout = previous;
+        }
+    }
+    unlockUserStore(true);
+    return changed;
+}
+
+/**
+ * @brief Registers a user in the hash table and persists the registration.
+ *
+ * Phone numbers are compared in their normalized form (see
+ * `normalizeUserPhone`), so one number written in different ways is the same
+ * user. If that user is already registered, the new record replaces the old
+ * one in place.
+ *
+ * Each registration is appended to users.log. The disk cost of a registration
+ * therefore does not depend on the number of users. Once the log has grown to
+ * a quarter of the table, and to at least USER_LOG_COMPACT_MIN records, it is
+ * compacted into a new users.bin snapshot. This keeps the amortized cost per
+ * registration O(1). The password is hashed before the store lock is taken.
+ *
+ * @param user Pointer to the User structure to register.
+ * @return true if the user was stored and logged; false if it has no password
+ *         (see `userPasswordSet`) or could not be stored.
+ */
+bool registerUser(const User* user) {
+    if (!userPasswordSet(user)) {
+        printf("A password is required. User not added.\n");
+        return false;
+    }
+    User copy = *user;
+    hashUserPassword(&copy);
+    lockUserStore(true);
+    bool inserted = userTableUpsert(&copy);
+    if (inserted) {
+        bool logged = appendUserLog("users.log", &copy);
+        if (!logged || (userLogRecords >= USER_LOG_COMPACT_MIN && userLogRecords >= userTable.count / 4)) {
+            checkpointUserStore(); // Compact, or fall back to a snapshot if the log is unwritable
+        }
+    }
+    unlockUserStore(true);
+    return inserted;
+}
+
+/**
+ * @brief Saves user data to the hash table and a file.
+ *
+ * This function takes a User structure as input and registers a copy of it
+ * with `registerUser`, which adds it to the hash table and appends it to the
+ * registration log. The screen is cleared after the operation.
+ *
+ * @param user The User structure containing the data to be saved.
+ */
+void saveUserData(User user) {
+    registerUser(&user); // Add to hash table and registration log
+    clear_screen();
+}
+
+/**
+ * @brief Number of records buffered between two appends to the user table during an import.
+ */
+#define USER_IMPORT_BATCH 1024
+
+/**
+ * @brief Input formats accepted by `importUsers`.
+ */
+typedef enum UserImportFormat {
+    USER_IMPORT_CSV,             /**< Text lines of `name,surname,phone,password`. */
+    USER_IMPORT_BINARY           /**< Plain sequence of User records; plaintext passwords are hashed on import. */
+} UserImportFormat;
+
+/**
+ * @brief Result of a bulk import.
+ */
+typedef struct UserImportStats {
+    unsigned imported;           /**< Number of users added to the table. */
+    unsigned skipped;            /**< Number of malformed records that were ignored. */
+    double seconds;              /**< Wall-clock time of the import, including the users.bin write. */
+    double recordsPerSecond;     /**< Imported users per second. */
+} UserImportStats;
+
+/**
+ * @brief Copies one field of a CSV line into a fixed-size User field.
+ *
+ * @param field The field text, null-terminated.
+ * @param out Destination buffer.
+ * @param size Size of the destination buffer.
+ * @param required true if an empty field makes the record invalid.
+ * @return true if the field fits; false otherwise.
+ */
+bool copyUserField(const char* field, char* out, size_t size, bool required) {
+    size_t length = strlen(field);
+    if (length >= size || (required && length == 0)) {
+        return false;
+    }
+    memcpy(out, field, length + 1);
+    return true;
+}
+
+/**
+ * @brief Parses one `name,surname,phone,password` line.
+ *
+ * The line is modified in place. Quoted fields are not supported; partner
+ * exports use plain comma-separated values.
+ *
+ * @param line The line without its line terminator.
+ * @param user Receives the parsed user.
+ * @return true if the line holds a valid user; false otherwise.
+ */
+bool parseUserCsvLine(char* line, User* user) {
+    char* fields[4];
+    int count = 0;
+    char* field = line;
+    while (count < 4) {
+        fields[count++] = field;
+        char* comma = strchr(field, ',');
+        if (comma == NULL) {
+            break;
+        }
+        *comma = '\0';
+        field = comma + 1;
+    }
+    if (count != 4 || strchr(fields[3], ',') != NULL) {
+        return false;
+    }
+
+    memset(user, 0, sizeof(User));
+    return copyUserField(fields[0], user->name, sizeof(user->name), false) &&
+        copyUserField(fields[1], user->surname, sizeof(user->surname), false) &&
+        copyUserField(fields[2], user->phone, sizeof(user->phone), true) &&
+        copyUserField(fields[3], user->password, sizeof(user->password), true);
+}
+
+/**
+ * @brief Checks a binary record before it is imported.
+ *
+ * @param user Pointer to the record read from the stream.
+ * @return true if every field is null-terminated, the phone number is set and the
+ *         record holds either a plaintext password or a password hash.
+ */
+bool userRecordValid(const User* user) {
+    return memchr(user->name, '\0', sizeof(user->name)) != NULL &&
+        memchr(user->surname, '\0', sizeof(user->surname)) != NULL &&
+        memchr(user->phone, '\0', sizeof(user->phone)) != NULL && user->phone[0] != '\0' &&
+        memchr(user->password, '\0', sizeof(user->password)) != NULL && userPasswordSet(user);
+}
+
+/**
+ * @brief Estimates the number of records left in an import stream.
+ *
+ * For seekable streams, binary input is sized from the remaining bytes and CSV
+ * input by counting its lines; the stream is then rewound to where it was.
+ *
+ * @param stream The input stream.
+ * @param format The format of the stream.
+ * @return The estimated number of records, 0 if the stream cannot be sized.
+ */
+unsigned estimateImportRecords(FILE* stream, UserImportFormat format) {
+    long start = ftell(stream);
+    if (start < 0 || fseek(stream, 0, SEEK_END) != 0) {
+        return 0;
+    }
+    long end = ftell(stream);
+    unsigned records = 0;
+    if (format == USER_IMPORT_BINARY) {
+        records = end > start ? (unsigned)((unsigned long)(end - start) / sizeof(User)) : 0;
+    }
+    else {
+        fseek(stream, start, SEEK_SET);
+        char buffer[65536];
+        size_t read;
+        while ((read = fread(buffer, 1, sizeof(buffer), stream)) > 0) {
+            for (const char* p = buffer; (p = (const char*)memchr(p, '\n', read - (p - buffer))) != NULL; p++) {
+                records++;
+            }
+        }
+        records++; // Last line may lack a terminator
+    }
+    fseek(stream, start, SEEK_SET);
+    return records;
+}
+
+/**
+ * @brief Imports users in bulk from a CSV or binary stream.
+ *
+ * The table is sized for the whole stream up front, records are appended in
+ * batches in a single pass, and users.bin is written once at the end. No
+ * registration log records are written; the final snapshot supersedes the log.
+ * In CSV input, a `name,surname,phone,password` header line is ignored and
+ * lines that do not hold four fields (or that overflow a field) are skipped.
+ * Passwords are hashed outside the store lock and each batch is appended under
+ * it, so logins keep being served while an import runs.
+ *
+ * @param stream The input stream, read until end of file.
+ * @param format The format of the stream.
+ * @param stats Receives the import statistics; may be NULL.
+ * @return true if the users were imported and saved; false if the table could
+ *         not grow or users.bin could not be written.
+ */
+bool importUsers(FILE* stream, UserImportFormat format, UserImportStats* stats) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    UserImportStats result = { 0, 0, 0.0, 0.0 };
+
+    unsigned estimate = estimateImportRecords(stream, format);
+    lockUserStore(true);
+    bool reserved = estimate == 0 || userTableReserve(&userTable, userTable.count + estimate);
+    unlockUserStore(true);
+    if (!reserved) {
+        return false;
+    }
+
+    User* batch = (User*)malloc(USER_IMPORT_BATCH * sizeof(User));
+    if (batch == NULL) {
+        return false;
+    }
+
+    bool ok = true;
+    bool firstLine = true;
+    char line[256];
+    while (ok) {
+        unsigned count = 0;
+        if (format == USER_IMPORT_BINARY) {
+            size_t read = fread(batch, sizeof(User), USER_IMPORT_BATCH, stream);
+            for (size_t i = 0; i < read; i++) {
+                if (userRecordValid(&batch[i])) {
+                    batch[count++] = batch[i];
+                }
+                else {
+                    result.skipped++;
+                }
+            }
+            if (read == 0) {
+                break;
+            }
+        }
+        else {
+            bool more = true;
+            while (count < USER_IMPORT_BATCH && (more = fgets(line, sizeof(line), stream) != NULL)) {
+                size_t length = strcspn(line, "\r\n");
+                if (line[length] == '\0' && !feof(stream)) {
+                    int c;
+                    while ((c = fgetc(stream)) != EOF && c != '\n') {
+                    }
+                    result.skipped++; // Longer than any valid record
+                    continue;
+                }
+                line[length] = '\0';
+                if (firstLine) {
+                    firstLine = false;
+                    if (strcmp(line, "name,surname,phone,password") == 0) {
+                        continue;
+                    }
+                }
+                if (length == 0) {
+                    continue;
+                }
+                if (parseUserCsvLine(line, &batch[count])) {
+                    count++;
+                }
+                else {
+                    result.skipped++;
+                }
+            }
+            if (count == 0 && !more) {
+                break;
+            }
+        }
+        for (unsigned i = 0; i < count; i++) {
+            hashUserPassword(&batch[i]);
+        }
+        lockUserStore(true);
+        ok = userTableAppend(batch, count);
+        unlockUserStore(true);
+        result.imported += ok ? count : 0;
+    }
+    free(batch);
+
+    if (ok) {
+        saveHashTableToFile();
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.recordsPerSecond = result.seconds > 0 ? result.imported / result.seconds : 0.0;
+    if (stats != NULL) {
+        *stats = result;
+    }
+    return ok;
+}
+
+/**
+ * @brief Imports users in bulk from a file and prints the throughput.
+ *
+ * Files ending in `.csv` are read as CSV; any other file as binary User records.
+ *
+ * @param path Path of the file to import.
+ * @return true if the users were imported and saved; false otherwise.
+ */
+bool importUserFile(const char* path) {
+    size_t length = strlen(path);
+    UserImportFormat format = length > 4 && strcmp(path + length - 4, ".csv") == 0 ? USER_IMPORT_CSV : USER_IMPORT_BINARY;
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        printf("Could not open %s.\n", path);
+        return false;
+    }
+
+    UserImportStats stats;
+    bool ok = importUsers(file, format, &stats);
+    fclose(file);
+    if (!ok) {
+        printf("Import of %s failed.\n", path);
+        return false;
+    }
+    printf("Imported %u users (%u skipped) in %.3f s, %.0f records/s.\n", stats.imported, stats.skipped,
+        stats.seconds, stats.recordsPerSecond);
+    return true;
+}
+
+/**
+ * @brief Removes the records of the user table that a later record of the same phone number shadows.
+ *
+ * Files written before registrations were upserted can hold several records of
+ * one phone number. The last of them, the most recent registration, is kept at
+ * the position of the first; the slab is compacted in place and a new slot
+ * array and filter are built for the remaining records. The name arena is
+ * rewritten without the strings of removed and replaced records.
+ *
+ * The caller must hold the user store lock exclusively.
+ *
+ * @return true if the table was compacted; false if an allocation failed.
+ */
+bool userTableCompact() {
+    UserTable* table = &userTable;
+    if (table->slots == NULL) {
+        return true;
+    }
+    UserSlot* slots = (UserSlot*)calloc(table->capacity, sizeof(UserSlot));
+    if (slots == NULL || !userTableDetach(table)) {
+        free(slots);
+        return false;
+    }
+
+    unsigned kept = 0;
+    char phone[sizeof(((User*)0)->phone)];
+    for (unsigned i = 0; i < table->count; i++) {
+        unsigned h = userTableRecordHash(table, i);
+        if (table->records[i].phone == USER_PHONE_SPILLED) {
+            userTableRecordPhone(table, &table->records[i], phone);
+        }
+        UserProbe probe = userProbeStart(h, table->capacity);
+        while (slots[probe.index].record != 0 && (slots[probe.index].hash != h ||
+            !userTableRecordHasPhone(table, &table->records[slots[probe.index].record - 1], table->records[i].phone,
+            phone))) {
+            userProbeNext(&probe);
+        }
+        if (slots[probe.index].record != 0) {
+            table->records[slots[probe.index].record - 1] = table->records[i];
+            continue;
+        }
+        table->records[kept] = table->records[i];
+        UserSlot slot = { h, kept + 1 };
+        userTablePlace(slots, table->capacity, slot);
+        kept++;
+    }
+
+    size_t namesSize = 0;
+    for (unsigned i = 0; i < kept; i++) {
+        namesSize += userNamesEntrySize(table, &table->records[i]);
+    }
+    uint8_t* names = (uint8_t*)malloc(namesSize > 0 ? namesSize : 1);
+    if (names != NULL) { // Otherwise the old arena, which holds every string, is kept
+        size_t offset = 0;
+        for (unsigned i = 0; i < kept; i++) {
+            size_t size = userNamesEntrySize(table, &table->records[i]);
+            memcpy(names + offset, table->names + table->records[i].names, size);
+            table->records[i].names = (uint32_t)offset;
+            offset += size;
+        }
+        free(table->names);
+        table->names = names;
+        table->namesSize = namesSize;
+        table->namesCapacity = namesSize > 0 ? namesSize : 1;
+    }
+
+    free(table->slots);
+    free(table->oldSlots);
+    freeUserFilter(table->filter);
+    freeUserFilter(table->oldFilter);
+    table->slots = slots;
+    table->count = kept;
+    table->oldSlots = NULL;
+    table->oldCapacity = 0;
+    table->migrateIndex = 0;
+    table->filter = buildUserTableFilter(slots, table->capacity);
+    table->filterBlocks = userTableFilterSize(table->capacity);
+    table->oldFilter = NULL;
+    table->oldFilterBlocks = 0;
+    return true;
+}
+
+/**
+ * @brief Removes the records of a paged users file that a later record of the same phone number shadows.
+ *
+ * In version 2 and later files every record of a phone number lives in the page the
+ * directory names for it, so each page is compacted on its own, keeping the
+ * last record of each phone number. Changed pages are rewritten and their
+ * filter blocks refilled; the header and directory are not written.
+ *
+ * The caller must hold the user store lock exclusively.
+ *
+ * @param paged The open paged file, in the current version.
+ * @return true if every page was compacted; false if a page could not be read or written.
+ */
+bool userPagedFileCompact(UserPagedFile* paged) {
+    UserPage page;
+    for (uint32_t i = 0; i < paged->header.pageCount; i++) {
+        if (!readUserPage(paged, i, &page)) {
+            return false;
+        }
+        uint32_t kept = 0;
+        for (uint32_t j = 0; j < page.count; j++) {
+            bool shadowed = false;
+            for (uint32_t k = j + 1; k < page.count && !shadowed; k++) {
+                shadowed = userPagedPhonesMatch(paged, page.records[j].phone, page.records[k].phone);
+            }
+            if (!shadowed) {
+                page.records[kept++] = page.records[j];
+            }
+        }
+        if (kept < page.count) {
+            paged->header.count -= page.count - kept;
+            memset(&page.records[kept], 0, (page.count - kept) * sizeof(User));
+            page.count = kept;
+            if (!writeUserPage(paged, i, &page)) {
+                return false;
+            }
+            userPageFilterRebuild(paged, i, &page);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Result of a compaction of the user store.
+ */
+typedef struct UserCompactStats {
+    unsigned long long records;  /**< Records stored before the compaction. */
+    unsigned long long removed;  /**< Shadowed records removed. */
+    double seconds;              /**< Wall-clock time of the compaction, including the users.bin write. */
+} UserCompactStats;
+
+/**
+ * @brief Rewrites users.bin without records shadowed by a later record of the same phone number.
+ *
+ * In the indexed layout the table is compacted and written as a new snapshot.
+ * In the paged layout the registrations held by the table are checkpointed
+ * first, replacing the page records of their phone numbers, and every page is
+ * then compacted in place. Either way each phone number keeps one record, so
+ * lookups verify one password and startup loads no dead records.
+ *
+ * @param stats Receives the compaction statistics; may be NULL.
+ * @return true if users.bin was rewritten; false otherwise.
+ */
+bool compactUserStore(UserCompactStats* stats) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    UserCompactStats result = { 0, 0, 0.0 };
+    lockUserStore(true);
+    result.records = userTable.count + (userPagedFile.file != NULL ? userPagedFile.header.count : 0);
+    bool ok = userTableCompact() && checkpointUserStore();
+    if (ok && userPagedFile.file != NULL) {
+        ok = userPagedFileCompact(&userPagedFile) && commitUserPagedFile(&userPagedFile);
+    }
+    unsigned long long records = userTable.count + (userPagedFile.file != NULL ? userPagedFile.header.count : 0);
+    unlockUserStore(true);
+    result.removed = records < result.records ? result.records - records : 0;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (stats != NULL) {
+        *stats = result;
+    }
+    return ok;
+}
+
+/**
+ * @brief Compacts users.bin and prints how many shadowed records were removed.
+ *
+ * @return true if users.bin was rewritten; false otherwise.
+ */
+bool compactUserFile() {
+    UserCompactStats stats;
+    if (!compactUserStore(&stats)) {
+        printf("Compaction of users.bin failed.\n");
+        return false;
+    }
+    printf("Compacted users.bin: removed %llu shadowed records of %llu in %.3f s.\n", stats.removed, stats.records,
+        stats.seconds);
+    return true;
+}
+
+/**
+ * @brief Reads the format version and size of an indexed users file.
+ *
+ * @param path Path of the users file.
+ * @param version Receives the version of an indexed file, 0 for a plain file of LegacyUser records.
+ * @param size Receives the size of the file in bytes.
+ * @return true if the file exists and is not empty.
+ */
+bool userFileInfo(const char* path, uint32_t* version, size_t* size) {
+    FileMapping mapping;
+    if (!mapFile(path, &mapping)) {
+        return false;
+    }
+    const UserFileHeader* header = (const UserFileHeader*)mapping.data;
+    *version = userFileIndexed(&mapping) ? header->version : 0;
+    *size = mapping.size;
+    unmapFile(&mapping);
+    return true;
+}
+
+/**
+ * @brief Converts users.bin to the current indexed format and prints the sizes before and after.
+ *
+ * Files of older versions, and plain files of LegacyUser records, were already
+ * packed into the table when they were loaded; this writes the packed records
+ * back as a new snapshot, so the next startup maps them instead of converting
+ * them again. A paged users.bin keeps User records in its pages and is
+ * converted with `setUserFileLayout(USER_FILE_INDEXED)` instead.
+ *
+ * @return true if users.bin was rewritten; false otherwise.
+ */
+bool convertUserFile() {
+    if (userFileLayout == USER_FILE_PAGED) {
+        printf("users.bin is in the paged layout; convert it with --layout indexed.\n");
+        return false;
+    }
+    uint32_t version = 0;
+    size_t before = 0;
+    bool existed = userFileInfo("users.bin", &version, &before);
+    lockUserStore(true);
+    bool converted = checkpointUserStore();
+    unlockUserStore(true);
+    uint32_t current = 0;
+    size_t after = 0;
+    if (!converted || !userFileInfo("users.bin", &current, &after)) {
+        printf("Conversion of users.bin failed.\n");
+        return false;
+    }
+    if (existed) {
+        printf("Converted users.bin from version %u (%zu bytes) to version %u (%zu bytes).\n", version, before,
+            current, after);
+    }
+    else {
+        printf("Wrote users.bin in version %u (%zu bytes).\n", current, after);
+    }
+    return true;
+}
+/**
+ * @brief Prints one user record.
+ *
+ * Used with `forEachUser` when the hash table is printed.
+ *
+ * @param user Pointer to the User structure to print.
+ * @param context Unused.
+ */
+void printUserRecord(User* user, void* context) {
+    (void)context;
+    printf(" Name: %s %s, Phone: %s, Password: PBKDF2-SHA256 (cost %u)\n",
+        user->name, user->surname, user->phone, user->passwordCost);
+}
+
+/**
+ * @brief Output formats of `exportUsers`.
+ */
+typedef enum UserExportFormat {
+    USER_EXPORT_TEXT,            /**< The lines of `printUserRecord`. */
+    USER_EXPORT_JSONL,           /**< One JSON object per line. */
+    USER_EXPORT_CSV              /**< A header line, then one RFC 4180 row per user. */
+} UserExportFormat;
+
+/**
+ * @brief Size of the output buffer of a user export.
+ */
+#define USER_EXPORT_BUFFER_SIZE (64 * 1024)
+
+/**
+ * @brief Cursor of an export that has written every user.
+ */
+#define USER_CURSOR_END UINT64_MAX
+
+/**
+ * @brief Cursor bit of positions in the record slab of the table.
+ *
+ * Cursors without it are positions in the paged users file:
+ * page * USER_PAGE_RECORDS + record.
+ */
+#define USER_CURSOR_TABLE (1ull << 62)
+
+/**
+ * @brief Buffered writer of a user export.
+ *
+ * Records are formatted straight into the buffer, which is written out with
+ * one `fwrite` whenever it fills, so an export makes one system call per
+ * USER_EXPORT_BUFFER_SIZE bytes instead of one stdio call per field.
+ */
+typedef struct UserExportWriter {
+    FILE* file;                  /**< Destination of the export. */
+    UserExportFormat format;     /**< Format of the records. */
+    size_t used;                 /**< Bytes of `buffer` in use. */
+    bool failed;                 /**< Whether a write failed. */
+    char buffer[USER_EXPORT_BUFFER_SIZE]; /**< Formatted output not yet written. */
+    User batch[USER_PAGE_RECORDS]; /**< Users copied out of the store, not yet formatted. */
+} UserExportWriter;
+
+/**
+ * @brief Writes the buffered output of a user export to its file.
+ */
+void userExportFlush(UserExportWriter* writer) {
+    if (writer->used > 0 && fwrite(writer->buffer, 1, writer->used, writer->file) != writer->used) {
+        writer->failed = true;
+    }
+    writer->used = 0;
+}
+
+/**
+ * @brief Appends bytes to the output of a user export.
+ */
+void userExportPut(UserExportWriter* writer, const char* data, size_t size) {
+    while (size > 0) {
+        if (writer->used == sizeof(writer->buffer)) {
+            userExportFlush(writer);
+        }
+        size_t chunk = sizeof(writer->buffer) - writer->used;
+        chunk = chunk < size ? chunk : size;
+        memcpy(writer->buffer + writer->used, data, chunk);
+        writer->used += chunk;
+        data += chunk;
+        size -= chunk;
+    }
+}
+
+/**
+ * @brief Appends a null-terminated string, such as a literal, to the output of a user export.
+ */
+void userExportText(UserExportWriter* writer, const char* text) {
+    userExportPut(writer, text, strlen(text));
+}
+
+/**
+ * @brief Appends a field of a record, escaped for the format of the export.
+ *
+ * JSON strings escape quotes, backslashes and control characters; CSV fields
+ * are quoted, with doubled quotes, if they hold a comma, a quote or a line break.
+ *
+ * @param writer The export.
+ * @param text The field, null-terminated or `max` bytes long.
+ * @param max Size of the field.
+ */
+void userExportField(UserExportWriter* writer, const char* text, size_t max) {
+    size_t length = strnlen(text, max);
+    if (writer->format == USER_EXPORT_TEXT) {
+        userExportPut(writer, text, length);
+        return;
+    }
+    bool quoted = writer->format == USER_EXPORT_JSONL || strcspn(text, ",\"\r\n") < length;
+    if (quoted) {
+        userExportPut(writer, "\"", 1);
+    }
+    bool json = writer->format == USER_EXPORT_JSONL;
+    size_t start = 0;
+    for (size_t i = 0; i < length; i++) {
+        unsigned char c = (unsigned char)text[i];
+        if (c != '"' && (!json || (c != '\\' && c >= 0x20))) {
+            continue; // Most fields need no escape at all
+        }
+        char escape[8];
+        size_t escapeLength;
+        if (!json) {
+            escape[0] = escape[1] = '"';
+            escapeLength = 2;
+        }
+        else if (c == '"' || c == '\\') {
+            escape[0] = '\\';
+            escape[1] = (char)c;
+            escapeLength = 2;
+        }
+        else {
+            memcpy(escape, "\\u00", 4);
+            escape[4] = "0123456789abcdef"[c >> 4];
+            escape[5] = "0123456789abcdef"[c & 0xF];
+            escapeLength = 6;
+        }
+        userExportPut(writer, text + start, i - start);
+        userExportPut(writer, escape, escapeLength);
+        start = i + 1;
+    }
+    userExportPut(writer, text + start, length - start);
+    if (quoted) {
+        userExportPut(writer, "\"", 1);
+    }
+}
+
+/**
+ * @brief Appends an unsigned integer in decimal to the output of a user export.
+ */
+void userExportUnsigned(UserExportWriter* writer, unsigned value) {
+    char digits[16];
+    size_t start = sizeof(digits);
+    do {
+        digits[--start] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    userExportPut(writer, digits + start, sizeof(digits) - start);
+}
+
+/**
+ * @brief Appends one user to the output of an export.
+ *
+ * Only the name, surname, phone number and password work factor are written;
+ * password hashes and salts never leave the store.
+ */
+void userExportRecord(UserExportWriter* writer, const User* user) {
+    switch (writer->format) {
+    case USER_EXPORT_TEXT:
+        userExportText(writer, " Name: ");
+        userExportField(writer, user->name, sizeof(user->name));
+        userExportText(writer, " ");
+        userExportField(writer, user->surname, sizeof(user->surname));
+        userExportText(writer, ", Phone: ");
+        userExportField(writer, user->phone, sizeof(user->phone));
+        userExportText(writer, ", Password: PBKDF2-SHA256 (cost ");
+        userExportUnsigned(writer, user->passwordCost);
+        userExportText(writer, ")\n");
+        break;
+    case USER_EXPORT_JSONL:
+        userExportText(writer, "{\"name\":");
+        userExportField(writer, user->name, sizeof(user->name));
+        userExportText(writer, ",\"surname\":");
+        userExportField(writer, user->surname, sizeof(user->surname));
+        userExportText(writer, ",\"phone\":");
+        userExportField(writer, user->phone, sizeof(user->phone));
+        userExportText(writer, ",\"passwordCost\":");
+        userExportUnsigned(writer, user->passwordCost);
+        userExportText(writer, "}\n");
+        break;
+    case USER_EXPORT_CSV:
+        userExportField(writer, user->name, sizeof(user->name));
+        userExportText(writer, ",");
+        userExportField(writer, user->surname, sizeof(user->surname));
+        userExportText(writer, ",");
+        userExportField(writer, user->phone, sizeof(user->phone));
+        userExportText(writer, ",");
+        userExportUnsigned(writer, user->passwordCost);
+        userExportText(writer, "\r\n");
+        break;
+    }
+}
+
+/**
+ * @brief Copies the users at an export cursor out of the store.
+ *
+ * Users are copied in the order of `forEachUser`: the pages of a paged
+ * users.bin, skipping records the table replaces, then the record slab of the
+ * table. The caller must hold the user store lock, shared or exclusive.
+ *
+ * @param cursor The cursor of the first user to copy; receives the cursor after the last one.
+ * @param out Receives the users.
+ * @param max Capacity of `out`.
+ * @param failed Set to true if a page of the users file could not be read.
+ * @return The number of users copied.
+ */
+unsigned userExportCopy(uint64_t* cursor, User* out, unsigned max, bool* failed) {
+    unsigned count = 0;
+    uint64_t next = *cursor;
+    if ((next & USER_CURSOR_TABLE) == 0) {
+        UserPage page;
+        uint32_t index = (uint32_t)(next / USER_PAGE_RECORDS);
+        uint32_t slot = (uint32_t)(next % USER_PAGE_RECORDS);
+        for (; userPagedFile.file != NULL && index < userPagedFile.header.pageCount && count < max;
+            index++, slot = 0) {
+            bool read;
+            {
+                std::lock_guard<std::mutex> guard(userPagedFileMutex);
+                read = readUserPage(&userPagedFile, index, &page);
+            }
+            if (!read) {
+                *failed = true;
+                return count;
+            }
+            for (; slot < page.count && count < max; slot++) {
+                if (userTable.count == 0 || !userTableHolds(page.records[slot].phone)) {
+                    out[count++] = page.records[slot];
+                }
+            }
+            if (slot < page.count) {
+                break;
+            }
+        }
+        next = userPagedFile.file != NULL && index < userPagedFile.header.pageCount ?
+            (uint64_t)index * USER_PAGE_RECORDS + slot : USER_CURSOR_TABLE;
+    }
+    if ((next & USER_CURSOR_TABLE) != 0) {
+        uint64_t record = next & ~USER_CURSOR_TABLE;
+        for (; record < userTable.count && count < max; record++) {
+            userTableUnpack(&userTable, &userTable.records[record], &out[count++]);
+        }
+        next = record < userTable.count ? USER_CURSOR_TABLE | record : USER_CURSOR_END;
+    }
+    *cursor = next;
+    return count;
+}
+
+/**
+ * @brief Streams a page of the users to a file.
+ *
+ * Users are written in the order of `userExportCopy`. The cursor names the
+ * next record to write, so an export can be continued page by page;
+ * registrations made in between are appended after the cursor and are still
+ * exported, while a checkpoint in between moves records into pages behind it.
+ * A CSV export writes its header line when it starts from cursor 0.
+ *
+ * The store lock is held in shared mode only while a batch of at most
+ * USER_PAGE_RECORDS users is copied out of the store; the batch is formatted
+ * and written after the lock is released, so a slow destination never holds
+ * up registrations. Registrations between two batches behave as between two
+ * pages of the export.
+ *
+ * @param file The destination.
+ * @param format The output format.
+ * @param cursor 0 to start, or the cursor of the previous page; receives the
+ *        cursor of the next page, or USER_CURSOR_END once every user was written.
+ * @param limit Number of users to write; 0 for all the remaining users.
+ * @param exported Receives the number of users written; may be NULL.
+ * @return true if the page was written; false if the file could not be written, in which case the cursor is kept.
+ */
+bool exportUsers(FILE* file, UserExportFormat format, uint64_t* cursor, unsigned limit, unsigned* exported) {
+    if (exported != NULL) {
+        *exported = 0;
+    }
+    if (*cursor == USER_CURSOR_END) {
+        return true;
+    }
+    UserExportWriter* writer = (UserExportWriter*)malloc(sizeof(UserExportWriter));
+    if (writer == NULL) {
+        return false;
+    }
+    writer->file = file;
+    writer->format = format;
+    writer->used = 0;
+    writer->failed = false;
+    if (format == USER_EXPORT_CSV && *cursor == 0) {
+        userExportText(writer, "name,surname,phone,password_cost\r\n");
+    }
+
+    unsigned count = 0;
+    uint64_t next = *cursor;
+    while (next != USER_CURSOR_END && (limit == 0 || count < limit) && !writer->failed) {
+        unsigned max = USER_PAGE_RECORDS;
+        max = limit != 0 && limit - count < max ? limit - count : max;
+        lockUserStore(false);
+        unsigned copied = userExportCopy(&next, writer->batch, max, &writer->failed);
+        unlockUserStore(false);
+        for (unsigned i = 0; i < copied; i++) {
+            userExportRecord(writer, &writer->batch[i]);
+        }
+        count += copied;
+    }
+
+    userExportFlush(writer);
+    bool written = !writer->failed && fflush(file) == 0;
+    free(writer);
+    if (written) {
+        *cursor = next;
+        if (exported != NULL) {
+            *exported = count;
+        }
+    }
+    return written;
+}
+
+/**
+ * @brief Prints the contents of the hash table.
+ *
+ * Every user stored in the hash table is streamed to the standard output with
+ * `exportUsers`, one line per user with their name, surname, phone number and
+ * password work factor, between a header and a closing line.
+ */
+void printHashTable() {
+    printf("Hash Table Contents:\n");
+    fflush(stdout);
+    uint64_t cursor = 0;
+    exportUsers(stdout, USER_EXPORT_TEXT, &cursor, 0, NULL);
+    printf("End of Hash Table.\n");
+}
+
+/**
+ * @brief Writes a page of the users to the standard output.
+ *
+ * The cursor of the next page is printed to the standard error, so that the
+ * output itself holds nothing but records.
+ *
+ * @param format "text", "jsonl" or "csv".
+ * @param cursor 0 to start, or the cursor printed by the previous page.
+ * @param limit Number of users to write; 0 for all of them.
+ * @return true if the page was written; false if `format` is unknown or the output failed.
+ */
+bool exportUserPage(const char* format, unsigned long long cursor, unsigned limit) {
+    UserExportFormat exportFormat;
+    if (strcmp(format, "text") == 0) {
+        exportFormat = USER_EXPORT_TEXT;
+    }
+    else if (strcmp(format, "jsonl") == 0) {
+        exportFormat = USER_EXPORT_JSONL;
+    }
+    else if (strcmp(format, "csv") == 0) {
+        exportFormat = USER_EXPORT_CSV;
+    }
+    else {
+        fprintf(stderr, "Unknown export format %s, use text, jsonl or csv.\n", format);
+        return false;
+    }
+    uint64_t next = cursor;
+    if (!exportUsers(stdout, exportFormat, &next, limit, NULL)) {
+        fprintf(stderr, "Export failed.\n");
+        return false;
+    }
+    if (next != USER_CURSOR_END) {
+        fprintf(stderr, "Next cursor: %llu\n", (unsigned long long)next);
+    }
+    return true;
+}
+
+/**
+ * @brief Number of users `printUsersByName` prints per page.
+ */
+#define USER_NAME_PAGE_SIZE 20
+
+/**
+ * @brief Prints one page of the users whose name or surname starts with a prefix.
+ *
+ * Instead of dumping the whole table like `printHashTable`, only the requested
+ * page is read, through the name index (see `findUsersByNamePrefix`).
+ *
+ * @param field "name" or "surname".
+ * @param prefix The prefix to match, without regard to ASCII case.
+ * @param page The page to print, starting at 1.
+ * @return true if the page was printed; false if `field` or `page` is invalid.
+ */
+bool printUsersByName(const char* field, const char* prefix, unsigned page) {
+    bool surname = strcmp(field, "surname") == 0;
+    if ((!surname && strcmp(field, "name") != 0) || page == 0) {
+        printf("Search by name or surname, from page 1.\n");
+        return false;
+    }
+    User users[USER_NAME_PAGE_SIZE];
+    unsigned total;
+    unsigned count = findUsersByNamePrefix(surname ? USER_NAME_FIELD_SURNAME : USER_NAME_FIELD_NAME, prefix,
+        (page - 1) * USER_NAME_PAGE_SIZE, users, USER_NAME_PAGE_SIZE, &total);
+    unsigned pages = (total + USER_NAME_PAGE_SIZE - 1) / USER_NAME_PAGE_SIZE;
+    printf("Users whose %s starts with \"%s\": %u (page %u of %u)\n", field, prefix, total, page,
+        pages > 0 ? pages : 1);
+    for (unsigned i = 0; i < count; i++) {
+        printUserRecord(&users[i], NULL);
+    }
+    return true;
+}
+
+/**
+ * @brief Defines the number of nodes of a Huffman tree over every byte value: 256 leaves and 255 internal nodes.
+ */
+#define HUFFMAN_TREE_NODES (2 * MAX_TREE_NODES - 1)
+
+/**
+ * @brief A Huffman tree built without heap allocations.
+ *
+ * The nodes are taken from a fixed array and the Min Heap works on a fixed
+ * array of pointers, so the tree lives and dies with its owner, usually a stack
+ * frame.
+ */
+typedef struct HuffmanTree {
+    MinHeapNode nodes[HUFFMAN_TREE_NODES];   /**< Leaves, then internal nodes, in order of creation. */
+    unsigned nodeCount;                      /**< Number of nodes in use. */
+    MinHeapNode* heapArray[MAX_TREE_NODES];  /**< Storage of `heap`. */
+    MinHeap heap;                            /**< Nodes not merged yet. */
+} HuffmanTree;
+
+/**
+ * @brief Takes the next node of a Huffman tree.
+ *
+ * @note The tree holds enough nodes for every byte value and the internal nodes joining them.
+ */
+MinHeapNode* huffmanTreeNode(HuffmanTree* tree, char data, unsigned freq, MinHeapNode* left, MinHeapNode* right) {
+    MinHeapNode* node = &tree->nodes[tree->nodeCount++];
+    node->data = data;
+    node->freq = freq;
+    node->left = left;
+    node->right = right;
+    return node;
+}
+
+/**
+ * @brief Algorithms that build Huffman trees.
+ *
+ * Both give optimal codes; they may break ties between equal frequencies
+ * differently.
+ */
+typedef enum HuffmanBuildMethod {
+    HUFFMAN_BUILD_MIN_HEAP,      /**< Merges the two smallest nodes of the Min Heap, O(n^2) with `extractMin`. */
+    HUFFMAN_BUILD_TWO_QUEUE,     /**< Counting-sorts the leaves, then merges from a leaf and a merged-node queue in O(n). */
+    HUFFMAN_BUILD_METHOD_COUNT   /**< Number of methods. */
+} HuffmanBuildMethod;
+
+/**
+ * @brief Names of the build methods, indexed by HuffmanBuildMethod.
+ */
+const char* huffmanBuildMethodNames[HUFFMAN_BUILD_METHOD_COUNT] = {
+    "min_heap", "two_queue"
+};
+
+/**
+ * @brief Method `buildHuffmanTreeNodes` builds trees with.
+ *
+ * Change it with `setHuffmanBuildMethod`.
+ */
+HuffmanBuildMethod huffmanBuildMethod = HUFFMAN_BUILD_TWO_QUEUE;
+
+/**
+ * @brief Selects the method Huffman trees are built with.
+ *
+ * @param method The build method to use from now on.
+ * @return true if the method was selected; false if it is unknown.
+ */
+bool setHuffmanBuildMethod(HuffmanBuildMethod method) {
+    if (method < 0 || method >= HUFFMAN_BUILD_METHOD_COUNT) {
+        return false;
+    }
+    huffmanBuildMethod = method;
+    return true;
+}
+
+/**
+ * @brief Builds the Huffman tree of byte frequencies with the Min Heap.
+ *
+ * @param tree Receives the nodes.
+ * @param frequencies Occurrences of each byte value.
+ * @return The root; NULL if no byte occurs.
+ */
+MinHeapNode* buildHuffmanTreeMinHeap(HuffmanTree* tree, const unsigned* frequencies) {
+    tree->nodeCount = 0;
+    tree->heap.size = 0;
+    tree->heap.capacity = MAX_TREE_NODES;
+    tree->heap.array = tree->heapArray;
+    for (int i = 0; i < MAX_TREE_NODES; i++) {
+        if (frequencies[i] > 0) {
+            insertMinHeap(&tree->heap, huffmanTreeNode(tree, (char)i, frequencies[i], NULL, NULL));
+        }
+    }
+    if (tree->heap.size == 0) {
+        return NULL;
+    }
+    while (tree->heap.size > 1) {
+        MinHeapNode* left = extractMin(&tree->heap);
+        MinHeapNode* right = extractMin(&tree->heap);
+        insertMinHeap(&tree->heap, huffmanTreeNode(tree, '$', left->freq + right->freq, left, right));
+    }
+    return extractMin(&tree->heap);
+}
+
+/**
+ * @brief Builds the Huffman tree of byte frequencies with two queues.
+ *
+ * The used byte values are sorted by frequency with one counting sort over 256
+ * buckets per significant byte of the largest frequency, a single pass for the
+ * letters of a name, and become the leaves `nodes[0, n)` in that order. Merged
+ * nodes are appended after them; their frequencies never decrease, so both
+ * ranges are queues in order of frequency and the two smallest nodes are
+ * always at their heads. On ties the leaf is taken first.
+ *
+ * @param tree Receives the nodes.
+ * @param frequencies Occurrences of each byte value.
+ * @return The root; NULL if no byte occurs.
+ */
+MinHeapNode* buildHuffmanTreeTwoQueue(HuffmanTree* tree, const unsigned* frequencies) {
+    unsigned char order[MAX_TREE_NODES];
+    unsigned char sorted[MAX_TREE_NODES];
+    unsigned n = 0;
+    unsigned largest = 0;
+    for (int i = 0; i < MAX_TREE_NODES; i++) {
+        if (frequencies[i] > 0) {
+            order[n++] = (unsigned char)i;
+            largest = frequencies[i] > largest ? frequencies[i] : largest;
+        }
+    }
+    for (unsigned shift = 0; shift < 32 && (largest >> shift) > 0; shift += 8) {
+        // Only digits up to the largest frequency occur; a name needs a handful of buckets
+        unsigned buckets = (largest >> shift) < 0xFF ? (largest >> shift) + 1 : MAX_TREE_NODES;
+        unsigned starts[MAX_TREE_NODES + 1];
+        memset(starts, 0, (buckets + 1) * sizeof(unsigned));
+        for (unsigned k = 0; k < n; k++) {
+            starts[((frequencies[order[k]] >> shift) & 0xFF) + 1]++;
+        }
+        for (unsigned d = 0; d < buckets; d++) {
+            starts[d + 1] += starts[d];
+        }
+        for (unsigned k = 0; k < n; k++) {
+            sorted[starts[(frequencies[order[k]] >> shift) & 0xFF]++] = order[k];
+        }
+        memcpy(order, sorted, n);
+    }
+
+    tree->nodeCount = 0;
+    for (unsigned k = 0; k < n; k++) {
+        huffmanTreeNode(tree, (char)order[k], frequencies[order[k]], NULL, NULL);
+    }
+    if (n == 0) {
+        return NULL;
+    }
+    unsigned leaf = 0;
+    unsigned merged = n;
+    while (tree->nodeCount < 2 * n - 1) {
+        MinHeapNode* pair[2];
+        for (int k = 0; k < 2; k++) {
+            if (merged == tree->nodeCount || (leaf < n && tree->nodes[leaf].freq <= tree->nodes[merged].freq)) {
+                pair[k] = &tree->nodes[leaf++];
+            }
+            else {
+                pair[k] = &tree->nodes[merged++];
+            }
+        }
+        huffmanTreeNode(tree, '$', pair[0]->freq + pair[1]->freq, pair[0], pair[1]);
+    }
+    return &tree->nodes[tree->nodeCount - 1];
+}
+
+/**
+ * @brief Builds the Huffman tree of byte frequencies with the selected HuffmanBuildMethod.
+ *
+ * @param tree Receives the nodes.
+ * @param frequencies Occurrences of each byte value.
+ * @return The root; NULL if no byte occurs.
+ */
+MinHeapNode* buildHuffmanTreeNodes(HuffmanTree* tree, const unsigned* frequencies) {
+    if (huffmanBuildMethod == HUFFMAN_BUILD_MIN_HEAP) {
+        return buildHuffmanTreeMinHeap(tree, frequencies);
+    }
+    return buildHuffmanTreeTwoQueue(tree, frequencies);
+}
+
+/**
+ * @brief Huffman codes of the characters of one tree, by byte value.
+ *
+ * A tree over a string is at most as deep as the Fibonacci number nearest the
+ * string length allows, so 64 bits hold every code of any string that fits in
+ * memory.
+ */
+typedef struct HuffmanCodeTable {
+    uint64_t codes[MAX_TREE_NODES];          /**< Code of each byte value, in its low `lengths` bits, first bit highest. */
+    unsigned char lengths[MAX_TREE_NODES];   /**< Code length of each byte value; 0 if it has no code. */
+    unsigned symbolCount;                    /**< Number of byte values with a code. */
+} HuffmanCodeTable;
+
+/**
+ * @brief Reads the code of every leaf of a Huffman tree into a code table.
+ *
+ * The tree is walked with an explicit stack, 0 for left and 1 for right. A
+ * tree of a lone leaf gives its byte the 1-bit code 0.
+ *
+ * @param root The root of the tree; NULL for an empty table.
+ * @param table Receives the codes.
+ */
+void generateHuffmanCodeTable(const MinHeapNode* root, HuffmanCodeTable* table) {
+    memset(table, 0, sizeof(*table));
+    if (root == NULL) {
+        return;
+    }
+    const MinHeapNode* stack[HUFFMAN_TREE_NODES];
+    uint64_t codes[HUFFMAN_TREE_NODES];
+    unsigned char depths[HUFFMAN_TREE_NODES];
+    int top = 0;
+    stack[top] = root;
+    codes[top] = 0;
+    depths[top++] = 0;
+    while (top > 0) {
+        const MinHeapNode* node = stack[--top];
+        uint64_t code = codes[top];
+        unsigned char depth = depths[top];
+        if (node->left != NULL) {
+            // Right below left, so the walk visits left subtrees first
+            stack[top] = node->right;
+            codes[top] = (code << 1) | 1;
+            depths[top++] = (unsigned char)(depth + 1);
+            stack[top] = node->left;
+            codes[top] = code << 1;
+            depths[top++] = (unsigned char)(depth + 1);
+        }
+        else {
+            unsigned char symbol = (unsigned char)node->data;
+            table->codes[symbol] = code;
+            table->lengths[symbol] = depth > 0 ? depth : 1;
+            table->symbolCount++;
+        }
+    }
+}
+
+/**
+ * @brief Builds the Huffman code table of the characters of a string.
+ *
+ * @param str The null-terminated string.
+ * @param table Receives the codes; empty for an empty string.
+ */
+void buildHuffmanCodeTable(const char* str, HuffmanCodeTable* table) {
+    unsigned freq[MAX_TREE_NODES] = { 0 };
+    for (int i = 0; str[i] != '\0'; i++) {
+        freq[(unsigned char)str[i]]++;
+    }
+    HuffmanTree tree;
+    generateHuffmanCodeTable(buildHuffmanTreeNodes(&tree, freq), table);
+}
+
+/**
+ * @brief Renders a code table as text, one "c: 0101" line per character in order of byte value.
+ *
+ * The text is written in a single pass and cut at the last whole line that
+ * fits, so a small buffer holds fewer codes instead of a partial one.
+ *
+ * @param table The codes.
+ * @param out Receives the null-terminated text.
+ * @param size Size of `out`; nothing is written if it is 0.
+ * @return The length of the whole text, as with snprintf; the text was cut if it is `size` or more.
+ */
+size_t renderHuffmanCodeTable(const HuffmanCodeTable* table, char* out, size_t size) {
+    size_t length = 0;
+    size_t written = 0;
+    for (int i = 0; i < MAX_TREE_NODES; i++) {
+        unsigned bits = table->lengths[i];
+        if (bits == 0) {
+            continue;
+        }
+        size_t line = bits + 4;
+        if (written == length && length + line < size) {
+            char* p = out + written;
+            *p++ = (char)i;
+            *p++ = ':';
+            *p++ = ' ';
+            for (unsigned b = bits; b > 0; b--) {
+                *p++ = (char)('0' + ((table->codes[i] >> (b - 1)) & 1));
+            }
+            *p = '\n';
+            written += line;
+        }
+        length += line;
+    }
+    if (size > 0) {
+        out[written] = '\0';
+    }
+    return length;
+}
+
+/**
+ * @brief Constructs a Huffman tree and generates Huffman codes for characters in a given string.
+ *
+ * This function performs the following steps to create a Huffman tree and generate Huffman codes:
+ * 1. Calculates the frequency of each character in the input string.
+ * 2. Orders the characters by frequency, in a min-heap (priority queue) or, with the default
+ *    HUFFMAN_BUILD_TWO_QUEUE method, by counting sort.
+ * 3. Iteratively merges the two nodes with the smallest frequencies to form the Huffman tree.
+ * 4. Traverses the Huffman tree to generate unique binary codes for each character, which are
+ *    rendered as text into the provided `AttendeE` structure.
+ *
+ * ## Parameters:
+ * - `str` (char*): The input string for which the Huffman tree is to be built. Each character in
+ *   this string is considered for frequency calculation and encoding.
+ * - `attendee` (AttendeE*): A pointer to an `AttendeE` structure where the generated Huffman codes
+ *   for each character will be stored. The structure is expected to have a `huffmanCode` field for storage.
+ *
+ * ## Implementation Details:
+ * - A frequency array (`freq`) is used to calculate how often each character appears in the string.
+ * - `buildHuffmanTreeNodes` builds the tree with the selected HuffmanBuildMethod: the Min Heap repeatedly
+ *   extracts and combines its two smallest nodes, while the two-queue method merges the heads of the sorted
+ *   leaves and of the merged nodes in linear time. The last node merged is the root of the Huffman tree.
+ * - The nodes live in a `HuffmanTree` on the stack, so building the tree allocates nothing and leaves
+ *   nothing to free.
+ * - `generateHuffmanCodeTable` walks the tree into a `HuffmanCodeTable` of per-character codes and
+ *   lengths, and `renderHuffmanCodeTable` appends one "c: code" line per character in order of byte
+ *   value, in a single pass.
+ *
+ * ## Usage Notes:
+ * - Ensure the input string is null-terminated to avoid buffer overflows during frequency calculation.
+ * - The codes are appended to the text already in `huffmanCode`, which must be null-terminated. Lines
+ *   that do not fit in the field are dropped whole, so it always stays terminated. An empty string adds
+ *   no codes, and a string of one repeated character gets the code 0.
+ *
+ * ## Advantages of Huffman Encoding:
+ * - Reduces the average length of encoded strings, especially for strings with skewed character frequencies.
+ * - Commonly used in data compression algorithms, such as JPEG and MP3.
+ *
+ * @see buildHuffmanCodeTable(), renderHuffmanCodeTable(), setHuffmanBuildMethod()
+ */
+void buildHuffmanTree(char* str, AttendeE* attendee) {
+    HuffmanCodeTable table;
+    buildHuffmanCodeTable(str, &table);
+
+    // Append the codes after any text already in huffmanCode, keeping it terminated
+    size_t used = strnlen(attendee->huffmanCode, sizeof(attendee->huffmanCode) - 1);
+    renderHuffmanCodeTable(&table, attendee->huffmanCode + used, sizeof(attendee->huffmanCode) - used);
+}
+
+/**
+ * @brief Appends the "c: code" lines of the leaves of a Huffman subtree.
+ *
+ * @param root The subtree.
+ * @param code The code of `root` in its first `top` characters; extended in place.
+ * @param top The depth of `root`.
+ * @param end Where the next line goes.
+ * @return The end of the last line appended.
+ */
+char* appendHuffmanCodes(const MinHeapNode* root, char* code, int top, char* end) {
+    if (root->left) {
+        code[top] = '0';
+        end = appendHuffmanCodes(root->left, code, top + 1, end);
+    }
+
+    if (root->right) {
+        code[top] = '1';
+        end = appendHuffmanCodes(root->right, code, top + 1, end);
+    }
+
+    if (!(root->left) && !(root->right)) {
+        *end++ = root->data;
+        *end++ = ':';
+        *end++ = ' ';
+        memcpy(end, code, top);
+        end += top;
+        *end++ = '\n';
+    }
+    return end;
+}
+
+/**
+ * @brief Generates Huffman codes for characters in a Huffman tree.
+ *
+ * This function traverses the Huffman tree recursively and appends a
+ * "c: code" line for each character to the text already in huffmanCode. Each
+ * line is written once at the end of the text, so the whole output takes
+ * linear time.
+ *
+ * @param root A pointer to the root of the Huffman tree.
+ * @param code A buffer to store the current Huffman code during recursion.
+ * @param top The current position in the code buffer.
+ * @param huffmanCode A buffer to store the final Huffman codes for each character.
+ *
+ * @note huffmanCode must have room for every line. Use `generateHuffmanCodeTable`
+ *       and `renderHuffmanCodeTable` to generate codes into a buffer of known size.
+ */
+void generateHuffmanCodes(MinHeapNode* root, char* code, int top, char* huffmanCode) {
+    char* end = appendHuffmanCodes(root, code, top, huffmanCode + strlen(huffmanCode));
+    *end = '\0';
+}
+
+/**
+ * @brief Defines the number of symbols of the Huffman codebooks: every byte value.
+ */
+#define HUFFMAN_SYMBOLS 256
+
+/**
+ * @brief Defines the longest code a Huffman codebook assigns.
+ *
+ * Codes fit in 16 bits, and an encoder never holds more than 7 pending bits
+ * plus one code in its 64-bit buffer.
+ */
+#define HUFFMAN_MAX_CODE_LENGTH 15
+
+/**
+ * @brief Defines the number of input bits the decoding table of a codebook is indexed by.
+ *
+ * 2^11 entries of 4 bytes keep the table in the L1 cache.
+ */
+#define HUFFMAN_TABLE_BITS 11
+
+/**
+ * @brief Defines the most symbols one decoding table entry yields.
+ */
+#define HUFFMAN_TABLE_SYMBOLS 3
+
+/**
+ * @brief What the next HUFFMAN_TABLE_BITS input bits decode to.
+ */
+typedef struct HuffmanTableEntry {
+    unsigned char symbols[HUFFMAN_TABLE_SYMBOLS]; /**< Byte values whose codes lie entirely in the bits, in order. */
+    unsigned char count : 4;     /**< Number of symbols; 0 if the first code is longer than HUFFMAN_TABLE_BITS. */
+    unsigned char bits : 4;      /**< Input bits the symbols take. */
+} HuffmanTableEntry;
+
+/**
+ * @brief Canonical Huffman codes of the byte values.
+ *
+ * Only the code lengths define a canonical codebook: codes of one length are
+ * consecutive integers in order of byte value, and each length starts where
+ * the shorter codes left off. Byte value 0 is the terminator of the encoded
+ * strings. The decoding table maps every HUFFMAN_TABLE_BITS-bit input to the
+ * up to HUFFMAN_TABLE_SYMBOLS symbols it starts with, stopping after a
+ * terminator, so one lookup decodes about two characters of a name.
+ */
+typedef struct HuffmanCodebook {
+    unsigned char lengths[HUFFMAN_SYMBOLS];                 /**< Code length of each byte value; 0 if it has no code. */
+    uint16_t codes[HUFFMAN_SYMBOLS];                        /**< Code of each byte value, in its low `lengths` bits. */
+    uint16_t counts[HUFFMAN_MAX_CODE_LENGTH + 1];           /**< Number of codes of each length. */
+    uint16_t firstCodes[HUFFMAN_MAX_CODE_LENGTH + 1];       /**< First code of each length. */
+    uint16_t firstIndexes[HUFFMAN_MAX_CODE_LENGTH + 1];     /**< Position in `symbols` of the first code of each length. */
+    unsigned char symbols[HUFFMAN_SYMBOLS];                 /**< Byte values with a code, by code length, then value. */
+    unsigned symbolCount;                                   /**< Number of byte values with a code. */
+    HuffmanTableEntry table[1 << HUFFMAN_TABLE_BITS];       /**< Decoding table, indexed by the next input bits. */
+} HuffmanCodebook;
+
+/**
+ * @brief Computes the Huffman code lengths of byte frequencies.
+ *
+ * The tree is built in a `HuffmanTree` and the depth of each leaf is read.
+ * Should a code exceed HUFFMAN_MAX_CODE_LENGTH, the frequencies are halved,
+ * keeping every used byte, and the tree is built again; this only happens for
+ * extremely skewed input and costs little compression.
+ *
+ * @param frequencies Occurrences of each byte value.
+ * @param lengths Receives the code length of each byte value; 0 for unused ones.
+ */
+void huffmanCodeLengths(const unsigned* frequencies, unsigned char* lengths) {
+    unsigned freq[HUFFMAN_SYMBOLS];
+    memcpy(freq, frequencies, sizeof(freq));
+    HuffmanTree tree;
+    while (true) {
+        memset(lengths, 0, HUFFMAN_SYMBOLS);
+        MinHeapNode* root = buildHuffmanTreeNodes(&tree, freq);
+        if (root == NULL) {
+            return;
+        }
+
+        // Read the depth of every leaf
+        MinHeapNode* stack[HUFFMAN_TREE_NODES];
+        unsigned char depths[HUFFMAN_TREE_NODES];
+        int top = 0;
+        stack[top] = root;
+        depths[top++] = 0;
+        unsigned longest = 0;
+        while (top > 0) {
+            MinHeapNode* node = stack[--top];
+            unsigned depth = depths[top];
+            if (node->left != NULL) {
+                stack[top] = node->left;
+                depths[top++] = (unsigned char)(depth + 1);
+                stack[top] = node->right;
+                depths[top++] = (unsigned char)(depth + 1);
+            }
+            else {
+                lengths[(unsigned char)node->data] = (unsigned char)(depth > 0 ? depth : 1); // A lone byte gets a 1-bit code
+                longest = depth > longest ? depth : longest;
+            }
+        }
+        if (longest <= HUFFMAN_MAX_CODE_LENGTH) {
+            return;
+        }
+        for (int i = 0; i < HUFFMAN_SYMBOLS; i++) {
+            freq[i] = (freq[i] + 1) >> 1;
+        }
+    }
+}
+
+/**
+ * @brief Finds the code at the start of a bit string.
+ *
+ * @param codebook The codebook, with its canonical codes assigned.
+ * @param bits The bit string, in the low `available` bits.
+ * @param available Number of bits in `bits`.
+ * @param length Receives the length of the code found.
+ * @return The byte value of the code; -1 if no code fits in the bits.
+ */
+int huffmanMatchCode(const HuffmanCodebook* codebook, unsigned bits, unsigned available, unsigned* length) {
+    for (unsigned l = 1; l <= available && l <= HUFFMAN_MAX_CODE_LENGTH; l++) {
+        unsigned code = bits >> (available - l);
+        unsigned offset = code - codebook->firstCodes[l];
+        if (code >= codebook->firstCodes[l] && offset < codebook->counts[l]) {
+            *length = l;
+            return codebook->symbols[codebook->firstIndexes[l] + offset];
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Fills the decoding table of a codebook.
+ *
+ * Each entry greedily decodes its index, stopping when the next code does not
+ * fit in the remaining bits, after HUFFMAN_TABLE_SYMBOLS symbols, or after a
+ * terminator, which must end the string being decoded.
+ */
+void huffmanBuildTable(HuffmanCodebook* codebook) {
+    for (unsigned index = 0; index < (1u << HUFFMAN_TABLE_BITS); index++) {
+        HuffmanTableEntry* entry = &codebook->table[index];
+        memset(entry, 0, sizeof(*entry));
+        unsigned used = 0;
+        while (entry->count < HUFFMAN_TABLE_SYMBOLS && used < HUFFMAN_TABLE_BITS) {
+            unsigned available = HUFFMAN_TABLE_BITS - used;
+            unsigned length;
+            int symbol = huffmanMatchCode(codebook, index & ((1u << available) - 1), available, &length);
+            if (symbol < 0) {
+                break;
+            }
+            entry->symbols[entry->count++] = (unsigned char)symbol;
+            used += length;
+            if (symbol == 0) {
+                break;
+            }
+        }
+        entry->bits = (unsigned char)used;
+    }
+}
+
+/**
+ * @brief Assigns the canonical codes of a set of code lengths.
+ *
+ * @param codebook Receives the codebook.
+ * @param lengths Code length of each byte value; 0 for bytes without a code.
+ * @return true if the lengths form a prefix code; false if they are longer than
+ *         HUFFMAN_MAX_CODE_LENGTH or oversubscribed, as a corrupt file may hold.
+ */
+bool huffmanCodebookFromLengths(HuffmanCodebook* codebook, const unsigned char* lengths) {
+    memset(codebook, 0, sizeof(*codebook));
+    for (int i = 0; i < HUFFMAN_SYMBOLS; i++) {
+        if (lengths[i] > HUFFMAN_MAX_CODE_LENGTH) {
+            return false;
+        }
+        codebook->lengths[i] = lengths[i];
+        codebook->counts[lengths[i]]++;
+    }
+    codebook->counts[0] = 0;
+    unsigned space = 1u << HUFFMAN_MAX_CODE_LENGTH; // Kraft sum in units of the longest code
+    unsigned code = 0;
+    unsigned index = 0;
+    for (int length = 1; length <= HUFFMAN_MAX_CODE_LENGTH; length++) {
+        unsigned used = (unsigned)codebook->counts[length] << (HUFFMAN_MAX_CODE_LENGTH - length);
+        if (used > space) {
+            return false;
+        }
+        space -= used;
+        code = (code + codebook->counts[length - 1]) << 1;
+        codebook->firstCodes[length] = (uint16_t)code;
+        codebook->firstIndexes[length] = (uint16_t)index;
+        index += codebook->counts[length];
+    }
+    codebook->symbolCount = index;
+
+    uint16_t next[HUFFMAN_MAX_CODE_LENGTH + 1];
+    uint16_t position[HUFFMAN_MAX_CODE_LENGTH + 1];
+    memcpy(next, codebook->firstCodes, sizeof(next));
+    memcpy(position, codebook->firstIndexes, sizeof(position));
+    for (int i = 0; i < HUFFMAN_SYMBOLS; i++) {
+        unsigned length = lengths[i];
+        if (length > 0) {
+            codebook->codes[i] = next[length]++;
+            codebook->symbols[position[length]++] = (unsigned char)i;
+        }
+    }
+    huffmanBuildTable(codebook);
+    return true;
+}
+
+/**
+ * @brief Builds the canonical codebook of byte frequencies.
+ *
+ * @param codebook Receives the codebook.
+ * @param frequencies Occurrences of each byte value.
+ */
+void trainHuffmanCodebook(HuffmanCodebook* codebook, const unsigned* frequencies) {
+    unsigned char lengths[HUFFMAN_SYMBOLS];
+    huffmanCodeLengths(frequencies, lengths);
+    huffmanCodebookFromLengths(codebook, lengths); // Computed lengths always form a prefix code
+}
+
+/**
+ * @brief Appends Huffman codes to a byte buffer, most significant bit first.
+ *
+ * The buffer must be large enough for every code written to it.
+ */
+typedef struct HuffmanBitWriter {
+    unsigned char* data;         /**< Destination of the bytes. */
+    size_t size;                 /**< Bytes written to `data`. */
+    uint64_t pending;            /**< Bits not yet written, in the low `bits` bits. */
+    unsigned bits;               /**< Number of pending bits, below 8 between calls. */
+} HuffmanBitWriter;
+
+/**
+ * @brief Appends a code to a bit writer.
+ */
+void huffmanPutBits(HuffmanBitWriter* writer, unsigned code, unsigned length) {
+    writer->pending = (writer->pending << length) | code;
+    writer->bits += length;
+    while (writer->bits >= 8) {
+        writer->bits -= 8;
+        writer->data[writer->size++] = (unsigned char)(writer->pending >> writer->bits);
+    }
+}
+
+/**
+ * @brief Pads the pending bits of a bit writer with zeros to a whole byte.
+ */
+void huffmanFlushBits(HuffmanBitWriter* writer) {
+    if (writer->bits > 0) {
+        huffmanPutBits(writer, 0, 8 - writer->bits);
+    }
+}
+
+/**
+ * @brief Reads Huffman codes from a byte buffer, most significant bit first.
+ */
+typedef struct HuffmanBitReader {
+    const unsigned char* data;   /**< Source of the bytes. */
+    size_t size;                 /**< Number of bytes in `data`. */
+    size_t position;             /**< Next bit to read. */
+} HuffmanBitReader;
+
+/**
+ * @brief Returns the number of bits of a string and its terminator under a codebook.
  *
- * This function iterates through each index of the hash table and prints the
- * user data stored at that index. If an index is empty, it skips to the next
- * index. For each user, it displays their name, surname, phone number, and
- * password. The function ends by indicating the completion of the hash table
- * output.
+ * @return The number of bits; 0 if a byte of the string has no code.
  */
-void printHashTable() {
-    /*   if (hashTable == nullptr) {
-           printf("Hash table is not initialized.\n");
-           return;
-       } */
-
-    printf("Hash Table Contents:\n");
-    for (int i = 0; i < TABLE_SIZE; i++) {
-        User* current = hashTable[i];
-        if (current == NULL) {
-            continue; // Skip empty cells 
-        }
-        printf("Index %d:\n", i);
-        while (current != NULL) {
-            printf(" Name: %s %s, Phone: %s, Password: %s\n",
-                current->name, current->surname, current->phone, current->password);
-            current = current->next;
+size_t huffmanEncodedBits(const HuffmanCodebook* codebook, const char* text, size_t max) {
+    size_t bits = codebook->lengths[0];
+    for (size_t i = 0; i < max && text[i] != '\0'; i++) {
+        unsigned length = codebook->lengths[(unsigned char)text[i]];
+        if (length == 0) {
+            return 0;
         }
+        bits += length;
     }
-    printf("End of Hash Table.\n");
+    return codebook->lengths[0] > 0 ? bits : 0;
 }
 
 /**
- * @brief Constructs a Huffman tree and generates Huffman codes for characters in a given string.
- *
- * This function performs the following steps to create a Huffman tree and generate Huffman codes:
- * 1. Calculates the frequency of each character in the input string.
- * 2. Builds a min-heap (priority queue) where each node represents a character and its frequency.
- * 3. Iteratively merges the two nodes with the smallest frequencies to form the Huffman tree.
- * 4. Traverses the Huffman tree to generate unique binary codes for each character, which are
- *    stored in the provided `AttendeE` structure.
- *
- * ## Parameters:
- * - `str` (char*): The input string for which the Huffman tree is to be built. Each character in
- *   this string is considered for frequency calculation and encoding.
- * - `attendee` (AttendeE*): A pointer to an `AttendeE` structure where the generated Huffman codes
- *   for each character will be stored. The structure is expected to have a `huffmanCode` field for storage.
- *
- * ## Implementation Details:
- * - A frequency array (`freq`) is used to calculate how often each character appears in the string.
- * - A min-heap is constructed to manage nodes efficiently based on their frequency. Nodes with lower
- *   frequencies have higher priority.
- * - The tree is constructed by repeatedly extracting the two smallest nodes from the heap, combining them
- *   into a new node, and reinserting the new node into the heap.
- * - The final node in the heap represents the root of the Huffman tree.
- * - The `generateHuffmanCodes` function recursively traverses the tree to create unique binary codes
- *   for each character.
- *
- * ## Usage Notes:
- * - Ensure the input string is null-terminated to avoid buffer overflows during frequency calculation.
- * - The function assumes that `AttendeE` is properly initialized and capable of storing the resulting
- *   Huffman codes.
- * - Memory management for the min-heap and tree nodes should be handled appropriately to prevent leaks.
+ * @brief Encodes a string and its terminator.
  *
- * ## Advantages of Huffman Encoding:
- * - Reduces the average length of encoded strings, especially for strings with skewed character frequencies.
- * - Commonly used in data compression algorithms, such as JPEG and MP3.
+ * @param codebook The codebook; every byte of the string and the terminator must have a code.
+ * @param text The string, null-terminated or `max` bytes long.
+ * @param max Most bytes of `text` to encode.
+ * @param writer The destination.
+ */
+void huffmanEncodeString(const HuffmanCodebook* codebook, const char* text, size_t max, HuffmanBitWriter* writer) {
+    for (size_t i = 0; i < max && text[i] != '\0'; i++) {
+        unsigned char c = (unsigned char)text[i];
+        huffmanPutBits(writer, codebook->codes[c], codebook->lengths[c]);
+    }
+    huffmanPutBits(writer, codebook->codes[0], codebook->lengths[0]);
+}
+
+/**
+ * @brief Returns the next bits of a bit reader without consuming them.
  *
- * @warning If the input string contains characters with very high frequencies, the min-heap may grow
- *          large, increasing memory usage and computation time.
+ * Bits past the end of the input read as zeros.
  *
- * @see generateHuffmanCodes(), createMinHeap(), insertMinHeap(), extractMin()
+ * @param reader The source.
+ * @param count Number of bits, at most 17.
+ * @return The bits, in the low `count` bits.
  */
-void buildHuffmanTree(char* str, AttendeE* attendee) {
-    // Frequency array
-    int freq[MAX_TREE_NODES] = { 0 };
-    for (int i = 0; str[i] != '\0'; i++) {
-        freq[(unsigned char)str[i]]++;
+unsigned huffmanPeekBits(const HuffmanBitReader* reader, unsigned count) {
+    size_t byte = reader->position >> 3;
+    uint32_t window;
+    if (byte + 3 <= reader->size) {
+        window = ((uint32_t)reader->data[byte] << 16) | ((uint32_t)reader->data[byte + 1] << 8) | reader->data[byte + 2];
     }
-
-    MinHeap* minHeap = createMinHeap(MAX_TREE_NODES);
-
-    // Create a min-heap for characters with non-zero frequency
-    for (int i = 0; i < MAX_TREE_NODES; i++) {
-        if (freq[i]) {
-            MinHeapNode* minHeapNode = createMinHeapNode(i, freq[i]);
-            insertMinHeap(minHeap, minHeapNode);
+    else {
+        window = 0;
+        for (size_t k = byte; k < byte + 3; k++) {
+            window = (window << 8) | (k < reader->size ? reader->data[k] : 0);
         }
     }
-
-    // Build the Huffman Tree
-    while (minHeap->size != 1) {
-        MinHeapNode* left = extractMin(minHeap);
-        MinHeapNode* right = extractMin(minHeap);
-
-        MinHeapNode* top = createMinHeapNode('$', left->freq + right->freq);
-        top->left = left;
-        top->right = right;
-
-        insertMinHeap(minHeap, top);
-    }
-
-    // The remaining node is the root of the Huffman Tree
-    MinHeapNode* root = extractMin(minHeap);
-    char huffmanCode[256] = { 0 }; // Buffer to store the generated code
-    generateHuffmanCodes(root, huffmanCode, 0, attendee->huffmanCode);
+    return (window >> (24 - (reader->position & 7) - count)) & ((1u << count) - 1);
 }
 
 /**
- * @brief Generates Huffman codes for characters in a Huffman tree.
- *
- * This function traverses the Huffman tree recursively and generates
- * the corresponding Huffman codes for each character. The generated codes
- * are stored in the provided huffmanCode buffer.
+ * @brief Decodes one byte value, walking the canonical code one bit at a time.
  *
- * @param root A pointer to the root of the Huffman tree.
- * @param code A buffer to store the current Huffman code during recursion.
- * @param top The current position in the code buffer.
- * @param huffmanCode A buffer to store the final Huffman codes for each character.
+ * @return The byte value; -1 if the input ends or holds no valid code.
  */
-void generateHuffmanCodes(MinHeapNode* root, char* code, int top, char* huffmanCode) {
-    if (root->left) {
-        code[top] = '0';
-        generateHuffmanCodes(root->left, code, top + 1, huffmanCode);
-    }
-
-    if (root->right) {
-        code[top] = '1';
-        generateHuffmanCodes(root->right, code, top + 1, huffmanCode);
+int huffmanDecodeSymbol(const HuffmanCodebook* codebook, HuffmanBitReader* reader) {
+    unsigned code = 0;
+    for (int length = 1; length <= HUFFMAN_MAX_CODE_LENGTH; length++) {
+        if (reader->position >= reader->size * 8) {
+            return -1;
+        }
+        unsigned bit = (reader->data[reader->position >> 3] >> (7 - (reader->position & 7))) & 1;
+        reader->position++;
+        code = (code << 1) | bit;
+        unsigned offset = code - codebook->firstCodes[length];
+        if (code >= codebook->firstCodes[length] && offset < codebook->counts[length]) {
+            return codebook->symbols[codebook->firstIndexes[length] + offset];
+        }
     }
+    return -1;
+}
 
-    // Save the generated Huffman code for the character
-    if (!(root->left) && !(root->right)) {
-        code[top] = '\0';
-        sprintf(huffmanCode, "%s%c: %s\n", huffmanCode, root->data, code); // Append code to huffmanCode
+/**
+ * @brief Decodes a string up to its terminator.
+ *
+ * Each lookup in the decoding table of the codebook yields up to
+ * HUFFMAN_TABLE_SYMBOLS characters. Codes longer than the table, lookups that
+ * would read past the input and the last characters before `out` is full are
+ * decoded one bit at a time instead.
+ *
+ * @param codebook The codebook the string was encoded with.
+ * @param reader The source.
+ * @param out Receives the null-terminated string.
+ * @param size Size of `out`.
+ * @return true if a whole string was decoded; false if the input is corrupt or the string does not fit.
+ */
+bool huffmanDecodeString(const HuffmanCodebook* codebook, HuffmanBitReader* reader, char* out, size_t size) {
+    size_t end = reader->size * 8;
+    size_t i = 0;
+    while (i < size) {
+        const HuffmanTableEntry* entry = &codebook->table[huffmanPeekBits(reader, HUFFMAN_TABLE_BITS)];
+        if (entry->count > 0 && reader->position + entry->bits <= end && i + HUFFMAN_TABLE_SYMBOLS <= size) {
+            memcpy(out + i, entry->symbols, HUFFMAN_TABLE_SYMBOLS);
+            i += entry->count;
+            reader->position += entry->bits;
+            if (out[i - 1] == '\0') {
+                return true;
+            }
+            continue;
+        }
+        int symbol = huffmanDecodeSymbol(codebook, reader);
+        if (symbol < 0) {
+            return false;
+        }
+        out[i++] = (char)symbol;
+        if (symbol == 0) {
+            return true;
+        }
     }
+    return false;
 }
 
 /**
@@ -654,6 +7274,10 @@ void generateHuffmanCodes(MinHeapNode* root, char* code, int top, char* huffmanC
  * match any entry in the hash table. If a match is found, it indicates
  * a successful login; otherwise, it indicates a failure.
  *
+ * The records of the phone number are copied under the shared store lock and
+ * the password is verified after the lock is released, so any number of
+ * threads can log in at the same time.
+ *
  * @param phone The phone number of the user attempting to log in.
  * @param password The password of the user attempting to log in.
  * @return true if the login credentials are valid; false otherwise.
@@ -663,15 +7287,37 @@ bool validateLogin(const char* phone, const char* password) {
         return false; // Invalid login parameters
     }
 
-    unsigned int index = hash(phone);
-    User* current = hashTable[index];
-    while (current) {
-        if (strcmp(current->phone, phone) == 0 && strcmp(current->password, password) == 0) {
-            return true; // Successful login
+    User candidates[USER_LOOKUP_MAX_RECORDS];
+    UserMetrics* metrics = userMetricsThread();
+    bool timed = metrics != NULL && ++metrics->untimed == USER_METRICS_LATENCY_SAMPLE;
+    std::chrono::steady_clock::time_point start;
+    if (timed) {
+        metrics->untimed = 0;
+        start = std::chrono::steady_clock::now();
+    }
+    lockUserStore(false);
+    unsigned count = userTableCollect(phone, candidates, USER_LOOKUP_MAX_RECORDS);
+    unlockUserStore(false);
+    if (timed) {
+        unsigned long long nanoseconds = (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        unsigned bucket = 0;
+        while (nanoseconds > 1 && bucket + 1 < USER_METRICS_LATENCY_BUCKETS) {
+            nanoseconds >>= 1;
+            bucket++;
         }
-        current = current->next;
+        userMetricsAdd(&metrics->lookupLatency[bucket], 1);
+    }
+
+    bool valid = false;
+    for (unsigned i = 0; i < count && !valid; i++) {
+        valid = userPasswordMatches(&candidates[i], password);
     }
-    return false; // Unsuccessful login
+    if (metrics != NULL) {
+        userMetricsAdd(&metrics->logins, 1);
+        userMetricsAdd(&metrics->failedLogins, !valid);
+    }
+    return valid;
 }
 
 /**
@@ -795,29 +7441,49 @@ bool mainMenu() {
 /**
  * @brief Executes the Progressive Overflow algorithm.
  *
- * This function demonstrates the Progressive Overflow algorithm by
- * iterating through a predefined array of integers. It calculates
- * the cumulative sum of the elements and checks if the sum exceeds
- * a specified overflow threshold. If an overflow is detected, it
- * prints a message indicating the index at which the overflow
- * occurred and resets the current sum to zero for simplicity.
+ * This function demonstrates the progressive overflow file organisation used by
+ * the paged users.bin layout, on a file of 5 buckets of 2 slots. Each key is
+ * stored in its home bucket `key % 5`; when that bucket is full it overflows
+ * into the next bucket with a free slot, wrapping around at the end of the
+ * file. A search therefore reads buckets from the home bucket on and stops at
+ * the first one that is not full.
  *
- * This function serves as a demonstration of how to handle
- * overflow conditions in a sequence of operations.
+ * After placing all keys, the function prints every bucket and the number of
+ * buckets a successful search reads on average.
  */
 void progressiveOverflow() {
     printf("Executing Progressive Overflow algorithm...\n");
-    int array[10] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
-    int overflowThreshold = 7; // Set the overflow threshold for demonstration
-    int currentSum = 0;
+    int buckets[5][2] = { { 0 } };  // 5 buckets of 2 slots, 0 marks a free slot
+    int keys[] = { 23, 45, 12, 37, 29, 33, 43, 53 };  // Keys to be added
+    int size = sizeof(keys) / sizeof(keys[0]);  // Number of keys
+    int reads = 0;
 
-    for (int i = 0; i < 10; i++) {
-        currentSum += array[i];
-        if (currentSum > overflowThreshold) {
-            printf("Overflow detected at index %d with sum %d\n", i, currentSum);
-            currentSum = 0; // Reset for simplicity
+    for (int i = 0; i < size; i++) {
+        int home = keys[i] % 5;  // Home bucket of the key
+        bool placed = false;
+        for (int step = 0; step < 5 && !placed; step++) {
+            int bucket = (home + step) % 5;
+            for (int slot = 0; slot < 2 && !placed; slot++) {
+                if (buckets[bucket][slot] == 0) {
+                    buckets[bucket][slot] = keys[i];
+                    placed = true;
+                    reads += step + 1;  // A search reads the same buckets
+                    if (step > 0) {
+                        printf("Key %d overflowed from bucket %d to bucket %d\n", keys[i], home, bucket);
+                    }
+                }
+            }
+        }
+        if (!placed) {
+            printf("File is full, cannot place key %d\n", keys[i]);
         }
     }
+
+    // Print the contents of each bucket
+    for (int i = 0; i < 5; i++) {
+        printf("Bucket %d: %d %d\n", i, buckets[i][0], buckets[i][1]);
+    }
+    printf("Average buckets read per successful search: %.2f\n", (double)reads / size);
 }
 
 
@@ -1022,50 +7688,118 @@ void linearQuotient() {
     }
 }
 /**
- * @brief Executes Brent's Method for storing keys in a hash table.
+ * @brief Number of slots in the Brent's Method demo table (prime, so every step visits all slots).
+ */
+#define BRENT_TABLE_SIZE 11
+
+/**
+ * @brief Returns the double hashing step of a key in the Brent's Method demo table.
+ *
+ * @param key The key to probe for.
+ * @param size Number of slots in the table.
+ * @return A step between 1 and `size - 2`.
+ */
+int brentStep(int key, int size) {
+    return 1 + key % (size - 2);
+}
+
+/**
+ * @brief Counts the probes a successful search for a key needs.
+ *
+ * @param hashTable The table to search, 0 marking an empty slot.
+ * @param size Number of slots in the table.
+ * @param key The key to search for.
+ * @return The number of slots examined, 0 if the key is not in the table.
+ */
+int brentProbeCount(const int* hashTable, int size, int key) {
+    int index = key % size;
+    int step = brentStep(key, size);
+    for (int probes = 1; probes <= size && hashTable[index] != 0; probes++) {
+        if (hashTable[index] == key) {
+            return probes;
+        }
+        index = (index + step) % size;
+    }
+    return 0;
+}
+
+/**
+ * @brief Inserts a key with Brent's variation of double hashing.
  *
- * This function demonstrates the use of Brent's Method for collision resolution
- * in a hash table. The method is designed to efficiently handle collisions
- * by incrementally exploring potential slots for inserting keys.
+ * When the key's own probe sequence reaches an empty slot after `s` steps, each
+ * key met at step `j` is checked for an empty slot `k` steps along its own
+ * sequence. If `j + k < s`, that key moves there and the new key takes its slot,
+ * so the total search cost of the table grows as little as possible.
  *
- * The function initializes a hash table and a predefined set of keys for insertion.
- * The initial index for each key is calculated using the modulo operation
- * `key % 10`. If the calculated index is already occupied, the method
- * attempts to find the next available slot using Brent's Method, which involves
- * incrementing the step size and exploring further indices in the hash table.
+ * @param hashTable The table to insert into, 0 marking an empty slot.
+ * @param size Number of slots in the table (prime).
+ * @param key The key to insert (non-zero).
+ * @return True if the key was inserted, false if the table is full.
+ */
+bool brentInsert(int* hashTable, int size, int key) {
+    int index = key % size;
+    int step = brentStep(key, size);
+    int s = 0;
+    while (hashTable[(index + s * step) % size] != 0) {
+        if (++s == size) {
+            return false;
+        }
+    }
+
+    int best = s;
+    int from = (index + s * step) % size;
+    int to = from;
+    for (int j = 0; j + 1 < best; j++) {
+        int resident = (index + j * step) % size;
+        int residentStep = brentStep(hashTable[resident], size);
+        for (int k = 1; j + k < best; k++) {
+            int target = (resident + k * residentStep) % size;
+            if (hashTable[target] == 0) {
+                best = j + k;
+                from = resident;
+                to = target;
+                break;
+            }
+        }
+    }
+
+    hashTable[to] = hashTable[from];
+    hashTable[from] = key;
+    return true;
+}
+
+/**
+ * @brief Executes Brent's Method for storing keys in a hash table.
  *
- * However, the core logic for resolving collisions is currently commented out,
- * meaning that if a collision occurs, the keys will not be inserted correctly.
- * Therefore, only the initial indices for keys will be displayed in the output.
+ * This function demonstrates Brent's variation of double hashing. Keys are
+ * hashed into a table of BRENT_TABLE_SIZE slots with `key % 11` and probe with
+ * a second hash `1 + key % 9`. When a collision would make the new key search
+ * far, a key already on its path is moved further along its own sequence
+ * instead, whenever that costs fewer probes in total.
  *
  * After processing the keys, the function prints the contents of the hash table,
- * showing the keys stored at each index.
+ * showing the keys stored at each index, and the average number of probes a
+ * successful search needs.
  */
-
 void brentsMethod() {
     printf("Executing Brent's Method algorithm...\n");
-    int hashTable[10] = { 0 };  // Initialize the hash table with 0
+    int hashTable[BRENT_TABLE_SIZE] = { 0 };  // Initialize the hash table with 0
     int keys[] = { 23, 45, 12, 37, 29 };  // Keys to be added
     int size = sizeof(keys) / sizeof(keys[0]);  // Number of keys
 
     for (int i = 0; i < size; i++) {
-        int index = keys[i] % 10;  // Compute the initial index
-        int step = 1;  // Initial step size
-        /* while (hashTable[index] != 0) {  // Check for collisions
-            int newIndex = (index + step) % 10;  // Compute new index
-            if (hashTable[newIndex] == 0) {  // Check if new index is free
-                index = newIndex;  // Update index to the new slot
-                break;  // Exit the loop if a slot is found
-            }
-            step++;  // Increment step size for further probing
-        } */
-        hashTable[index] = keys[i];  // Insert the key into the hash table
+        if (!brentInsert(hashTable, BRENT_TABLE_SIZE, keys[i])) {
+            printf("Hash table is full, cannot place key %d\n", keys[i]);
+        }
     }
 
     // Print the contents of the hash table
-    for (int i = 0; i < 10; i++) {
+    int probes = 0;
+    for (int i = 0; i < BRENT_TABLE_SIZE; i++) {
         printf("Index %d: %d\n", i, hashTable[i]);  // Display each index and its key
+        probes += hashTable[i] != 0 ? brentProbeCount(hashTable, BRENT_TABLE_SIZE, hashTable[i]) : 0;
     }
+    printf("Average probes per successful search: %.2f\n", (double)probes / size);
 }
 
 /**
@@ -1694,20 +8428,15 @@ void computeLPSArray(char* pattern, int M, int* lps) {
 }
 
 /**
- * @brief Compresses and stores the Huffman code for an attendee's name.
- *
- * This function takes an attendee's name and simulates the process of Huffman
- * coding by storing the name directly in the `huffmanCode` field of the
- * `Attendee` structure. In a complete implementation, this function would
- * contain the logic to generate an actual Huffman code for compression.
+ * @brief Stores the searchable form of an attendee's name in its `huffmanCode` field.
  *
- * @param attendee Pointer to an `Attendee` structure whose name will be compressed
- *                 and stored as a Huffman code.
+ * The field holds the name itself, which is what Track Attendees searches
+ * with `kmpSearch`. The `attendees` array of the menu keeps full records;
+ * names are only compressed in attendee.bin and in a PackedAttendeeList
+ * (see `packAttendees`).
  *
- * The function copies each character from the attendee's name to the `huffmanCode`
- * array. For simplicity, it directly stores the name characters instead of generating
- * a true Huffman code. The resulting `huffmanCode` string is null-terminated to ensure
- * proper string handling in C.
+ * @param attendee Pointer to an `Attendee` structure whose name will be copied
+ *                 to its `huffmanCode` field.
  */
 void compressAttendeeName(Attendee* attendee) {
     int len = strlen(attendee->nameAttendee);
@@ -1718,57 +8447,421 @@ void compressAttendeeName(Attendee* attendee) {
     attendee->huffmanCode[len] = '\0'; // Null terminate the string
 }
 
+/**
+ * @brief Attendees packed with one Huffman codebook trained on all their names.
+ *
+ * The name and surname of an attendee are encoded back to back, each followed
+ * by the terminator code, and padded to a whole byte, so any attendee can be
+ * decoded on its own through `offsets`.
+ */
+typedef struct PackedAttendeeList {
+    HuffmanCodebook codebook;    /**< Codes shared by every attendee. */
+    unsigned count;              /**< Number of attendees. */
+    uint32_t* offsets;           /**< Byte offset of each attendee in `payload`; `count + 1` entries. */
+    unsigned char* payload;      /**< Encoded names and surnames. */
+    size_t payloadSize;          /**< Bytes in `payload`. */
+} PackedAttendeeList;
+
+/**
+ * @brief Releases the memory of a packed attendee list and empties it.
+ */
+void freePackedAttendees(PackedAttendeeList* packed) {
+    free(packed->offsets);
+    free(packed->payload);
+    packed->offsets = NULL;
+    packed->payload = NULL;
+    packed->count = 0;
+    packed->payloadSize = 0;
+}
+
+/**
+ * @brief Returns the number of bytes of the name and surname of an attendee under a codebook.
+ *
+ * @return The number of bytes; 0 if a byte of the names has no code.
+ */
+size_t attendeePackedSize(const HuffmanCodebook* codebook, const Attendee* attendee) {
+    size_t name = huffmanEncodedBits(codebook, attendee->nameAttendee, MAX_NAME_LENGTH - 1);
+    size_t surname = huffmanEncodedBits(codebook, attendee->surnameAttendee, MAX_NAME_LENGTH - 1);
+    return name > 0 && surname > 0 ? (name + surname + 7) / 8 : 0;
+}
+
+/**
+ * @brief Packs attendees with a codebook of their names.
+ *
+ * The codebook is trained on the bytes of every name and surname plus one
+ * terminator per string, then the exact size of each attendee is computed so
+ * the payload is allocated once.
+ *
+ * @param list The attendees.
+ * @param count Number of attendees.
+ * @param packed Receives the packed list; release it with `freePackedAttendees`.
+ * @return true if the attendees were packed; false if memory ran out.
+ */
+bool packAttendees(const Attendee* list, unsigned count, PackedAttendeeList* packed) {
+    memset(packed, 0, sizeof(*packed));
+    unsigned frequencies[HUFFMAN_SYMBOLS] = { 0 };
+    frequencies[0] = 1; // An empty list still encodes empty strings
+    for (unsigned i = 0; i < count; i++) {
+        const char* names[2] = { list[i].nameAttendee, list[i].surnameAttendee };
+        for (int n = 0; n < 2; n++) {
+            for (size_t j = 0; j < MAX_NAME_LENGTH - 1 && names[n][j] != '\0'; j++) {
+                frequencies[(unsigned char)names[n][j]]++;
+            }
+            frequencies[0]++;
+        }
+    }
+    packed->offsets = (uint32_t*)malloc(((size_t)count + 1) * sizeof(uint32_t));
+    if (packed->offsets == NULL) {
+        freePackedAttendees(packed);
+        return false;
+    }
+    trainHuffmanCodebook(&packed->codebook, frequencies);
+
+    size_t size = 0;
+    for (unsigned i = 0; i < count; i++) {
+        packed->offsets[i] = (uint32_t)size;
+        size += attendeePackedSize(&packed->codebook, &list[i]);
+    }
+    packed->offsets[count] = (uint32_t)size;
+    packed->payload = (unsigned char*)malloc(size > 0 ? size : 1);
+    if (packed->payload == NULL || size > UINT32_MAX) {
+        freePackedAttendees(packed);
+        return false;
+    }
+    HuffmanBitWriter writer = { packed->payload, 0, 0, 0 };
+    for (unsigned i = 0; i < count; i++) {
+        huffmanEncodeString(&packed->codebook, list[i].nameAttendee, MAX_NAME_LENGTH - 1, &writer);
+        huffmanEncodeString(&packed->codebook, list[i].surnameAttendee, MAX_NAME_LENGTH - 1, &writer);
+        huffmanFlushBits(&writer);
+    }
+    packed->count = count;
+    packed->payloadSize = size;
+    return true;
+}
+
+/**
+ * @brief Decodes one attendee of a packed attendee list.
+ *
+ * @param packed The packed list.
+ * @param index Position of the attendee.
+ * @param out Receives the attendee, with its searchable `huffmanCode` field filled.
+ * @return true if the attendee was decoded; false if `index` is out of range or the payload is corrupt.
+ */
+bool unpackAttendee(const PackedAttendeeList* packed, unsigned index, Attendee* out) {
+    if (index >= packed->count) {
+        return false;
+    }
+    memset(out, 0, sizeof(*out));
+    HuffmanBitReader reader = { packed->payload + packed->offsets[index],
+        packed->offsets[index + 1] - packed->offsets[index], 0 };
+    if (!huffmanDecodeString(&packed->codebook, &reader, out->nameAttendee, MAX_NAME_LENGTH) ||
+        !huffmanDecodeString(&packed->codebook, &reader, out->surnameAttendee, MAX_NAME_LENGTH)) {
+        return false;
+    }
+    compressAttendeeName(out);
+    return true;
+}
+
+/**
+ * @brief Signature that identifies an attendee.bin file of packed attendees.
+ */
+#define ATTENDEE_FILE_MAGIC "EVAT"
+
+/**
+ * @brief Version of the attendee.bin format written by this build.
+ */
+#define ATTENDEE_FILE_VERSION 1
+
+/**
+ * @brief Header at the start of an attendee.bin file.
+ *
+ * The header is followed by `symbolCount` pairs of a byte value and its code
+ * length, which define the canonical codebook, and by the `payloadSize` bytes
+ * of the attendees as laid out in a PackedAttendeeList. The offsets are not
+ * stored: every attendee ends at its second terminator, rounded up to a byte.
+ * Files that do not start with ATTENDEE_FILE_MAGIC are read as the original
+ * format: a plain sequence of Attendee records.
+ */
+typedef struct AttendeeFileHeader {
+    char magic[4];               /**< ATTENDEE_FILE_MAGIC, not null-terminated. */
+    uint32_t version;            /**< Format version, ATTENDEE_FILE_VERSION. */
+    uint32_t count;              /**< Number of attendees. */
+    uint32_t symbolCount;        /**< Number of byte values with a code. */
+    uint32_t payloadSize;        /**< Bytes of encoded attendees. */
+} AttendeeFileHeader;
+
+/**
+ * @brief Writes attendees to a file in the packed attendee.bin format.
+ *
+ * The file is written under a temporary name and renamed into place.
+ *
+ * @param path Path of the file.
+ * @param list The attendees.
+ * @param count Number of attendees.
+ * @return true if the file was written; false otherwise.
+ */
+bool saveAttendeeFile(const char* path, const Attendee* list, unsigned count) {
+    PackedAttendeeList packed;
+    if (!packAttendees(list, count, &packed)) {
+        return false;
+    }
+    AttendeeFileHeader header;
+    memcpy(header.magic, ATTENDEE_FILE_MAGIC, 4);
+    header.version = ATTENDEE_FILE_VERSION;
+    header.count = count;
+    header.symbolCount = packed.codebook.symbolCount;
+    header.payloadSize = (uint32_t)packed.payloadSize;
+    unsigned char symbols[HUFFMAN_SYMBOLS * 2];
+    for (unsigned i = 0; i < packed.codebook.symbolCount; i++) {
+        symbols[i * 2] = packed.codebook.symbols[i];
+        symbols[i * 2 + 1] = packed.codebook.lengths[packed.codebook.symbols[i]];
+    }
+
+    char tempPath[260];
+    snprintf(tempPath, sizeof(tempPath), "%s.tmp", path);
+    FILE* file = fopen(tempPath, "wb");
+    if (file == NULL) {
+        freePackedAttendees(&packed);
+        return false;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+        fwrite(symbols, 2, header.symbolCount, file) == header.symbolCount &&
+        fwrite(packed.payload, 1, packed.payloadSize, file) == packed.payloadSize;
+    written = fclose(file) == 0 && written;
+    freePackedAttendees(&packed);
+    if (!written) {
+        remove(tempPath);
+        return false;
+    }
+#if defined(_WIN32) || defined(_WIN64)
+    remove(path); // rename does not replace an existing file on Windows
+#endif
+    return rename(tempPath, path) == 0;
+}
+
+/**
+ * @brief Reads the codebook of a packed attendee.bin file.
+ *
+ * @param file The file, positioned just after its header.
+ * @param header The header read from the file.
+ * @param codebook Receives the codebook.
+ * @return true if the codebook was read; false if the header or the code lengths are corrupt.
+ */
+bool readAttendeeFileCodebook(FILE* file, const AttendeeFileHeader* header, HuffmanCodebook* codebook) {
+    unsigned char symbols[HUFFMAN_SYMBOLS * 2];
+    unsigned char lengths[HUFFMAN_SYMBOLS] = { 0 };
+    bool valid = header->version == ATTENDEE_FILE_VERSION && header->symbolCount <= HUFFMAN_SYMBOLS &&
+        fread(symbols, 2, header->symbolCount, file) == header->symbolCount;
+    for (unsigned i = 0; valid && i < header->symbolCount; i++) {
+        valid = lengths[symbols[i * 2]] == 0 && symbols[i * 2 + 1] > 0;
+        lengths[symbols[i * 2]] = symbols[i * 2 + 1];
+    }
+    return valid && huffmanCodebookFromLengths(codebook, lengths);
+}
+
+/**
+ * @brief Reads the attendees of an attendee.bin file, packed or in the original format.
+ *
+ * @param path Path of the file.
+ * @param list Receives an array of the attendees, to be released with `free`; NULL if there are none.
+ * @param count Receives the number of attendees.
+ * @return true if the file was read or does not exist; false if it is unreadable or corrupt.
+ */
+bool loadAttendeeFile(const char* path, Attendee** list, unsigned* count) {
+    *list = NULL;
+    *count = 0;
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        return true;
+    }
+    AttendeeFileHeader header;
+    size_t headerSize = fread(&header, 1, sizeof(header), file);
+    if (headerSize < sizeof(header.magic) || memcmp(header.magic, ATTENDEE_FILE_MAGIC, 4) != 0) {
+        // Original format: Attendee records, as registerAttendees appended them
+        fseek(file, 0, SEEK_END);
+        long size = ftell(file);
+        fseek(file, 0, SEEK_SET);
+        unsigned records = size > 0 ? (unsigned)(size / sizeof(Attendee)) : 0;
+        Attendee* legacy = records > 0 ? (Attendee*)malloc((size_t)records * sizeof(Attendee)) : NULL;
+        bool read = records == 0 || (legacy != NULL && fread(legacy, sizeof(Attendee), records, file) == records);
+        fclose(file);
+        if (!read) {
+            free(legacy);
+            return false;
+        }
+        for (unsigned i = 0; i < records; i++) {
+            legacy[i].nameAttendee[MAX_NAME_LENGTH - 1] = '\0';
+            legacy[i].surnameAttendee[MAX_NAME_LENGTH - 1] = '\0';
+            legacy[i].huffmanCode[MAX_NAME_LENGTH - 1] = '\0';
+        }
+        *list = legacy;
+        *count = records;
+        return true;
+    }
+
+    HuffmanCodebook codebook;
+    bool valid = headerSize == sizeof(header) && readAttendeeFileCodebook(file, &header, &codebook);
+    unsigned char* payload = valid ? (unsigned char*)malloc(header.payloadSize > 0 ? header.payloadSize : 1) : NULL;
+    Attendee* attendees = valid && header.count > 0 ? (Attendee*)malloc((size_t)header.count * sizeof(Attendee)) : NULL;
+    valid = payload != NULL && (header.count == 0 || attendees != NULL) &&
+        fread(payload, 1, header.payloadSize, file) == header.payloadSize;
+    fclose(file);
+
+    HuffmanBitReader reader = { payload, header.payloadSize, 0 };
+    for (unsigned i = 0; valid && i < header.count; i++) {
+        memset(&attendees[i], 0, sizeof(Attendee));
+        valid = huffmanDecodeString(&codebook, &reader, attendees[i].nameAttendee, MAX_NAME_LENGTH) &&
+            huffmanDecodeString(&codebook, &reader, attendees[i].surnameAttendee, MAX_NAME_LENGTH);
+        reader.position = (reader.position + 7) & ~(size_t)7;
+        if (valid) {
+            compressAttendeeName(&attendees[i]);
+        }
+    }
+    free(payload);
+    if (!valid) {
+        free(attendees);
+        return false;
+    }
+    *list = attendees;
+    *count = header.count;
+    return true;
+}
+
+/**
+ * @brief Adds attendees to an attendee.bin file with a codebook trained on all of them.
+ *
+ * The attendees already in the file are read, the new ones appended, and the
+ * whole file is written again. A file in the original format is converted on
+ * the way.
+ *
+ * @param path Path of the file.
+ * @param added The attendees to add.
+ * @param count Number of attendees to add.
+ * @return true if the file was written; false otherwise.
+ */
+bool retrainAttendeeFile(const char* path, const Attendee* added, unsigned count) {
+    Attendee* existing;
+    unsigned existingCount;
+    if (!loadAttendeeFile(path, &existing, &existingCount)) {
+        return false;
+    }
+    Attendee* all = (Attendee*)realloc(existing, ((size_t)existingCount + count) * sizeof(Attendee));
+    if (all == NULL && existingCount + count > 0) {
+        free(existing);
+        return false;
+    }
+    if (count > 0) {
+        memcpy(all + existingCount, added, (size_t)count * sizeof(Attendee));
+    }
+    bool saved = saveAttendeeFile(path, all, existingCount + count);
+    free(all);
+    return saved;
+}
+
+/**
+ * @brief Adds attendees to an attendee.bin file.
+ *
+ * The new attendees are encoded with the codebook of the file and written
+ * after its payload, then the header is updated, so an append costs the size
+ * of the new attendees. The codebook is retrained on every attendee, and the
+ * file rewritten, when the count reaches a power of two or a new attendee
+ * holds a byte without a code; the rewrites cost O(1) amortized per attendee
+ * and keep the codebook trained on at least half of the attendees it codes.
+ * A file in the original format is converted on the first append.
+ *
+ * If the append is interrupted before the header is written, the file still
+ * holds its previous attendees; the bytes past the payload are ignored.
+ *
+ * @param path Path of the file.
+ * @param added The attendees to add.
+ * @param count Number of attendees to add.
+ * @return true if the file was written; false otherwise.
+ */
+bool appendAttendeeFile(const char* path, const Attendee* added, unsigned count) {
+    FILE* file = fopen(path, "r+b");
+    if (file == NULL) {
+        return saveAttendeeFile(path, added, count);
+    }
+    AttendeeFileHeader header;
+    HuffmanCodebook codebook;
+    bool packed = fread(&header, sizeof(header), 1, file) == 1 &&
+        memcmp(header.magic, ATTENDEE_FILE_MAGIC, 4) == 0 && readAttendeeFileCodebook(file, &header, &codebook);
+    uint64_t checkpoint = 1;
+    while (packed && checkpoint <= header.count) {
+        checkpoint *= 2;
+    }
+    size_t size = 0;
+    for (unsigned i = 0; packed && i < count; i++) {
+        size_t bytes = attendeePackedSize(&codebook, &added[i]);
+        packed = bytes > 0;
+        size += bytes;
+    }
+    if (!packed || header.count + (uint64_t)count >= checkpoint || header.payloadSize + size > UINT32_MAX) {
+        fclose(file);
+        return retrainAttendeeFile(path, added, count);
+    }
+
+    unsigned char* payload = (unsigned char*)malloc(size > 0 ? size : 1);
+    if (payload == NULL) {
+        fclose(file);
+        return false;
+    }
+    HuffmanBitWriter writer = { payload, 0, 0, 0 };
+    for (unsigned i = 0; i < count; i++) {
+        huffmanEncodeString(&codebook, added[i].nameAttendee, MAX_NAME_LENGTH - 1, &writer);
+        huffmanEncodeString(&codebook, added[i].surnameAttendee, MAX_NAME_LENGTH - 1, &writer);
+        huffmanFlushBits(&writer);
+    }
+    long end = (long)(sizeof(header) + (size_t)header.symbolCount * 2 + header.payloadSize);
+    bool written = fseek(file, end, SEEK_SET) == 0 && fwrite(payload, 1, size, file) == size;
+    free(payload);
+    header.count += count;
+    header.payloadSize += (uint32_t)size;
+    written = written && fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+    return fclose(file) == 0 && written;
+}
+
 /**
  * @brief Registers attendees and saves their information in a binary file.
  *
  * This function prompts the user for the number of attendees and collects
- * their names and surnames. It then compresses the attendees' names into
- * a simulated Huffman code and saves all the attendee information in a
- * binary file named "attendee.bin".
+ * their names and surnames. The new attendees are then added to the binary
+ * file named "attendee.bin", where every name and surname is Huffman coded
+ * with a codebook shared by all the attendees of the file (see `appendAttendeeFile`).
+ * The attendees also stay in the `attendees` array as full records.
  *
  * The user is asked how many attendees will register. If the number
- * exceeds the defined limit or is invalid, an error message is displayed.
- * For each attendee, their name and surname are collected, compressed,
- * and saved to the binary file.
+ * exceeds the room left under MAX_ATTENDEES or is invalid, an error message
+ * is displayed.
  *
  * @return true if the registration is successful; false if there is an
- *         error opening the file or writing data.
+ *         error writing the file.
  */
 bool registerAttendees() {
     int count;
-    FILE* file = fopen("attendee.bin", "ab");
-    /* if (file == NULL) {
-         perror("Error opening file");
-         return false;
-     }*/
-
     printf("How many people will attend? ");
     scanf("%d", &count);
 
-    if (count <= 0 || count > MAX_ATTENDEES) {
-        printf("Invalid number! Please enter a value between 1 and %d.\n", MAX_ATTENDEES);
-        fclose(file);
+    if (count <= 0 || count > MAX_ATTENDEES - attendeeCount) {
+        printf("Invalid number! Please enter a value between 1 and %d.\n", MAX_ATTENDEES - attendeeCount);
         return false;
     }
 
+    int first = attendeeCount;
     for (int i = 0; i < count; i++) {
         printf("Enter the name of attendee %d: ", i + 1);
         scanf("%s", attendees[attendeeCount].nameAttendee);
         printf("Enter the surname of attendee %d: ", i + 1);
         scanf("%s", attendees[attendeeCount].surnameAttendee);
         compressAttendeeName(&attendees[attendeeCount]); 
-
-        if (fwrite(&attendees[attendeeCount], sizeof(Attendee), 1, file) != 1) {
-            /*   perror("Error writing to file");
-               fclose(file);*/
-            return false;
-        }
-
         attendeeCount++;
     }
 
+    if (!appendAttendeeFile("attendee.bin", &attendees[first], (unsigned)count)) {
+        printf("Attendees could not be saved.\n");
+        return false;
+    }
     printf("%d attendees registered and saved in binary format.\n", count);
-    fclose(file); 
     return true;
 }
 
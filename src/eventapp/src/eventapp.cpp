@@ -14,6 +14,19 @@
  *
  * The program includes essential functions like initializing a hash table, loading its data
  * from an external file, and navigating through a main menu interface for user interaction.
+ *
+ * ## Command-Line Options:
+ * - `--import <file>`: Bulk imports users from a CSV or binary file.
+ * - `--layout paged|indexed`: Rewrites users.bin in the given layout.
+ * - `--compact`: Rewrites users.bin without records shadowed by re-registrations.
+ * - `--convert`: Rewrites a users.bin of an older format with packed records.
+ * - `--find-users name|surname <prefix> [page]`: Lists users by name prefix.
+ * - `--export text|jsonl|csv [limit] [cursor]`: Streams users to the standard output.
+ * - `--stats`: Prints the shape of the user table: its size, load factor and chain lengths.
+ * - `--metrics-file <file> [seconds]`: Runs the menu while dumping that shape and the
+ *   lookup, insert and login counters of the session to a file.
+ *
+ * Without options the program runs the main menu.
  */
 
  // Standard Libraries
@@ -25,9 +38,48 @@
 #include "../../event/header/event.h"  // Adjust this include path based on your project structure
 #include "../../event/src/event.cpp"
 
-int main()
+int main(int argc, char* argv[])
 {
-	memset(hashTable, 0, sizeof(hashTable));
 	loadHashTableFromFile();
+	if (argc == 3 && strcmp(argv[1], "--import") == 0) {
+		return importUserFile(argv[2]) ? 0 : 1; // Bulk import, e.g. eventapp --import partners.csv
+	}
+	if (argc == 3 && strcmp(argv[1], "--layout") == 0) {
+		bool paged = strcmp(argv[2], "paged") == 0;
+		if (!paged && strcmp(argv[2], "indexed") != 0) {
+			printf("Unknown layout %s, use paged or indexed.\n", argv[2]);
+			return 1;
+		}
+		return setUserFileLayout(paged ? USER_FILE_PAGED : USER_FILE_INDEXED) ? 0 : 1;
+	}
+	if (argc == 2 && strcmp(argv[1], "--compact") == 0) {
+		return compactUserFile() ? 0 : 1;
+	}
+	if (argc == 2 && strcmp(argv[1], "--convert") == 0) {
+		return convertUserFile() ? 0 : 1;
+	}
+	if ((argc == 4 || argc == 5) && strcmp(argv[1], "--find-users") == 0) {
+		unsigned page = argc == 5 ? (unsigned)strtoul(argv[4], NULL, 10) : 1;
+		return printUsersByName(argv[2], argv[3], page) ? 0 : 1; // e.g. eventapp --find-users surname yil 2
+	}
+	if (argc >= 3 && argc <= 5 && strcmp(argv[1], "--export") == 0) {
+		unsigned limit = argc >= 4 ? (unsigned)strtoul(argv[3], NULL, 10) : 0;
+		unsigned long long cursor = argc == 5 ? strtoull(argv[4], NULL, 10) : 0;
+		return exportUserPage(argv[2], cursor, limit) ? 0 : 1; // e.g. eventapp --export jsonl 1000 > users.jsonl
+	}
+	if (argc == 2 && strcmp(argv[1], "--stats") == 0) {
+		printUserMetrics();
+		return 0;
+	}
+	if ((argc == 3 || argc == 4) && strcmp(argv[1], "--metrics-file") == 0) {
+		unsigned seconds = argc == 4 ? (unsigned)strtoul(argv[3], NULL, 10) : 10;
+		if (!startUserMetricsDump(argv[2], seconds)) { // e.g. eventapp --metrics-file metrics.prom 5
+			printf("Cannot write metrics to %s.\n", argv[2]);
+			return 1;
+		}
+		mainMenu();
+		stopUserMetricsDump();
+		return 0;
+	}
 	mainMenu();
 }
\ No newline at end of file
@@ -0,0 +1,1563 @@
+/**
+ * @file event_benchmark.cpp
+ * @brief Standalone benchmark harness for the event module.
+ *
+ * The harness is built next to the GoogleTest targets but does not depend on
+ * GoogleTest. Every suite writes machine-readable CSV to standard output so the
+ * results can be collected for trend tracking.
+ *
+ * Usage: `event_benchmark <suite> [arguments]`. Run without arguments to list
+ * the available suites.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../../event/header/event.h"
+#include "../../event/src/event.cpp"
+
+/**
+ * @brief Returns the number of seconds elapsed since `start`.
+ */
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief Loads a phone number corpus.
+ *
+ * Files ending in `.bin` are read as users files (either format); any other file
+ * is read as text with one phone number per line.
+ *
+ * @param path Path of the corpus file.
+ * @return The phone numbers found in the file, empty if the file cannot be read.
+ */
+std::vector<std::string> loadPhoneCorpus(const char* path) {
+    std::vector<std::string> phones;
+    size_t length = strlen(path);
+    if (length > 4 && strcmp(path + length - 4, ".bin") == 0) {
+        clearUserTable();
+        loadUserFile(path);
+        char phone[sizeof(((User*)0)->phone)];
+        for (unsigned i = 0; i < userTable.count; i++) {
+            userTableRecordPhone(&userTable, &userTable.records[i], phone);
+            phones.push_back(phone);
+        }
+        clearUserTable();
+        return phones;
+    }
+
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        return phones;
+    }
+
+    char line[128];
+    while (fgets(line, sizeof(line), file) != NULL) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] != '\0') {
+            phones.push_back(line);
+        }
+    }
+
+    fclose(file);
+    return phones;
+}
+
+/**
+ * @brief Generates a synthetic corpus of Turkish mobile phone numbers.
+ *
+ * Numbers are spread over the 053x-055x operator prefixes with consecutive
+ * subscriber numbers, which reproduces the long shared prefixes of real data.
+ *
+ * @param count Number of phone numbers to generate.
+ * @return The generated phone numbers.
+ */
+std::vector<std::string> generatePhoneCorpus(size_t count) {
+    std::vector<std::string> phones;
+    phones.reserve(count);
+    char phone[20];
+    for (size_t i = 0; i < count; i++) {
+        unsigned prefix = 530 + (unsigned)(i % 30);
+        unsigned long subscriber = 1000000ul + (unsigned long)(i / 30);
+        snprintf(phone, sizeof(phone), "0%u%07lu", prefix, subscriber % 10000000ul);
+        phones.push_back(phone);
+    }
+    return phones;
+}
+
+/**
+ * @brief Loads the corpus named on the command line, or generates one.
+ *
+ * @param path Corpus path, or NULL to generate `fallbackCount` numbers.
+ * @param fallbackCount Number of phone numbers generated when no usable corpus is given.
+ * @return The phone numbers of the corpus.
+ */
+std::vector<std::string> phoneCorpus(const char* path, size_t fallbackCount) {
+    std::vector<std::string> phones;
+    if (path != NULL) {
+        phones = loadPhoneCorpus(path);
+        if (phones.empty()) {
+            fprintf(stderr, "Corpus %s is empty or unreadable, using generated numbers.\n", path);
+        }
+    }
+    if (phones.empty()) {
+        phones = generatePhoneCorpus(fallbackCount);
+    }
+    return phones;
+}
+
+/**
+ * @brief Bucket occupancy of the previous and the current user hash function.
+ *
+ * Arguments: `[corpus] [buckets...]`. Defaults to a generated corpus of 100000
+ * numbers and to 100 (the old fixed table size), 1024 and 65536 buckets.
+ */
+int runHashDistribution(int argc, char** argv) {
+    std::vector<std::string> phones = phoneCorpus(argc > 0 ? argv[0] : NULL, 100000);
+    std::vector<const char*> keys;
+    for (size_t i = 0; i < phones.size(); i++) {
+        keys.push_back(phones[i].c_str());
+    }
+
+    std::vector<unsigned> bucketCounts;
+    for (int i = 1; i < argc; i++) {
+        bucketCounts.push_back((unsigned)strtoul(argv[i], NULL, 10));
+    }
+    if (bucketCounts.empty()) {
+        bucketCounts.push_back(100);
+        bucketCounts.push_back(1024);
+        bucketCounts.push_back(65536);
+    }
+
+    hashDistributionReportHeader(stdout);
+    for (size_t i = 0; i < bucketCounts.size(); i++) {
+        hashDistributionReport(stdout, "polynomial", polynomialHash, keys.data(), keys.size(), bucketCounts[i]);
+        hashDistributionReport(stdout, "wyhash", wyHash, keys.data(), keys.size(), bucketCounts[i]);
+    }
+    return 0;
+}
+
+/**
+ * @brief Password work factor used by suites that measure table and file costs.
+ *
+ * Password hashing would otherwise dominate their timings; the "login" suite
+ * measures the real costs.
+ */
+#define BENCHMARK_PASSWORD_COST 0
+
+/**
+ * @brief Fills the user table with generated users.
+ *
+ * @param count Number of users to register.
+ */
+void fillUserTable(unsigned count) {
+    setPasswordHashCost(BENCHMARK_PASSWORD_COST);
+    clearUserTable();
+    std::vector<std::string> phones = generatePhoneCorpus(count);
+    User user;
+    memset(&user, 0, sizeof(user));
+    strcpy(user.name, "Bench");
+    strcpy(user.surname, "User");
+    strcpy(user.password, "password");
+    for (unsigned i = 0; i < count; i++) {
+        strcpy(user.phone, phones[i].c_str());
+        saveUser(&user);
+    }
+}
+
+/**
+ * @brief Time from startup to the first successful login for each users.bin format.
+ *
+ * Arguments: `[users...]`. Defaults to 10^4, 10^5 and 10^6 users. The "plain"
+ * format is the original sequence of LegacyUser records, whose passwords are
+ * hashed while loading; the "paged" format only reads its header at startup
+ * and the bucket pages a login needs.
+ */
+int runStartup(int argc, char** argv) {
+    std::vector<unsigned> sizes;
+    for (int i = 0; i < argc; i++) {
+        sizes.push_back((unsigned)strtoul(argv[i], NULL, 10));
+    }
+    if (sizes.empty()) {
+        sizes.push_back(10000);
+        sizes.push_back(100000);
+        sizes.push_back(1000000);
+    }
+
+    const char* path = "benchmark_users.bin";
+    printf("format,users,file_bytes,load_ms,first_login_us,login_ok\n");
+    for (size_t i = 0; i < sizes.size(); i++) {
+        fillUserTable(sizes[i]);
+        std::string lastPhone = generatePhoneCorpus(sizes[i]).back();
+
+        for (int format = 0; format < 3; format++) {
+            if (format == 0) {
+                FILE* file = fopen(path, "wb");
+                LegacyUser legacy;
+                memset(&legacy, 0, sizeof(legacy));
+                strcpy(legacy.password, "password");
+                User user;
+                for (unsigned j = 0; j < userTable.count; j++) {
+                    userTableUnpack(&userTable, &userTable.records[j], &user);
+                    memcpy(legacy.name, user.name, sizeof(legacy.name));
+                    memcpy(legacy.surname, user.surname, sizeof(legacy.surname));
+                    memcpy(legacy.phone, user.phone, sizeof(legacy.phone));
+                    fwrite(&legacy, sizeof(legacy), 1, file);
+                }
+                fclose(file);
+            }
+            else if (format == 1) {
+                fillUserTable(sizes[i]);
+                saveUserFile(path);
+            }
+            else {
+                fillUserTable(sizes[i]);
+                UserPagedFile paged;
+                memset(&paged, 0, sizeof(paged));
+                saveUserPagedFile(path, NULL, &paged);
+                closeUserPagedFile(&paged);
+            }
+            clearUserTable();
+
+            FILE* file = fopen(path, "rb");
+            fseek(file, 0, SEEK_END);
+            long bytes = ftell(file);
+            fclose(file);
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            loadUserFile(path);
+            double loadSeconds = secondsSince(start);
+            start = std::chrono::steady_clock::now();
+            bool loggedIn = validateLogin(lastPhone.c_str(), "password");
+            double loginSeconds = secondsSince(start);
+
+            const char* formats[] = { "plain", "indexed", "paged" };
+            printf("%s,%u,%ld,%.3f,%.1f,%d\n", formats[format], sizes[i], bytes, loadSeconds * 1e3,
+                loginSeconds * 1e6, loggedIn ? 1 : 0);
+            clearUserTable();
+            userFileLayout = USER_FILE_INDEXED;
+        }
+    }
+    remove(path);
+    remove("benchmark_users.bin.dir");
+    return 0;
+}
+
+/**
+ * @brief Cost of persisting registrations with the log versus a full rewrite.
+ *
+ * Arguments: `[existing_users] [registrations]`. Defaults to 100000 existing
+ * users and 200 registrations. The "rewrite" mode saves the whole users.bin
+ * after every registration, as the application did before users.log existed.
+ * Works on users.bin and users.log in the current directory and removes them.
+ */
+int runRegistration(int argc, char** argv) {
+    unsigned existing = argc > 0 ? (unsigned)strtoul(argv[0], NULL, 10) : 100000;
+    unsigned registrations = argc > 1 ? (unsigned)strtoul(argv[1], NULL, 10) : 200;
+    std::vector<std::string> phones = generatePhoneCorpus(existing + registrations);
+
+    printf("mode,existing_users,registrations,total_ms,per_registration_us\n");
+    for (int mode = 0; mode < 2; mode++) {
+        fillUserTable(existing);
+        saveHashTableToFile();
+
+        User user;
+        memset(&user, 0, sizeof(user));
+        strcpy(user.name, "New");
+        strcpy(user.surname, "User");
+        strcpy(user.password, "password");
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (unsigned i = 0; i < registrations; i++) {
+            strcpy(user.phone, phones[existing + i].c_str());
+            if (mode == 0) {
+                saveUser(&user);
+                saveHashTableToFile();
+            }
+            else {
+                registerUser(&user);
+            }
+        }
+        double seconds = secondsSince(start);
+
+        printf("%s,%u,%u,%.3f,%.1f\n", mode == 0 ? "rewrite" : "log", existing, registrations,
+            seconds * 1e3, registrations > 0 ? seconds * 1e6 / registrations : 0.0);
+        clearUserTable();
+    }
+    remove("users.bin");
+    remove("users.log");
+    return 0;
+}
+
+/**
+ * @brief Throughput of the bulk import compared to registering users one at a time.
+ *
+ * Arguments: `[users...]`. Defaults to 10^4, 10^5 and 10^6 users, written to a
+ * generated CSV file. Works on users.bin and users.log in the current directory
+ * and removes them.
+ */
+int runBulkImport(int argc, char** argv) {
+    std::vector<unsigned> sizes;
+    for (int i = 0; i < argc; i++) {
+        sizes.push_back((unsigned)strtoul(argv[i], NULL, 10));
+    }
+    if (sizes.empty()) {
+        sizes.push_back(10000);
+        sizes.push_back(100000);
+        sizes.push_back(1000000);
+    }
+
+    const char* path = "benchmark_import.csv";
+    setPasswordHashCost(BENCHMARK_PASSWORD_COST);
+    printf("mode,users,seconds,records_per_second\n");
+    for (size_t i = 0; i < sizes.size(); i++) {
+        std::vector<std::string> phones = generatePhoneCorpus(sizes[i]);
+        FILE* file = fopen(path, "wb");
+        for (size_t j = 0; j < phones.size(); j++) {
+            fprintf(file, "Bench,User,%s,password\n", phones[j].c_str());
+        }
+        fclose(file);
+
+        clearUserTable();
+        remove("users.bin");
+        remove("users.log");
+        file = fopen(path, "rb");
+        UserImportStats stats;
+        importUsers(file, USER_IMPORT_CSV, &stats);
+        fclose(file);
+        printf("bulk,%u,%.3f,%.0f\n", stats.imported, stats.seconds, stats.recordsPerSecond);
+
+        clearUserTable();
+        remove("users.bin");
+        remove("users.log");
+        User user;
+        memset(&user, 0, sizeof(user));
+        strcpy(user.name, "Bench");
+        strcpy(user.surname, "User");
+        strcpy(user.password, "password");
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (size_t j = 0; j < phones.size(); j++) {
+            strcpy(user.phone, phones[j].c_str());
+            registerUser(&user);
+        }
+        double seconds = secondsSince(start);
+        printf("register,%u,%.3f,%.0f\n", sizes[i], seconds, seconds > 0 ? sizes[i] / seconds : 0.0);
+        clearUserTable();
+    }
+    remove(path);
+    remove("users.bin");
+    remove("users.log");
+    return 0;
+}
+
+/**
+ * @brief Logins per second at several password work factors.
+ *
+ * Arguments: `[costs...]`. Defaults to costs 8, 10, 12, 14 and 16. For each cost,
+ * "cold" logins verify the password with PBKDF2 and "cached" logins repeat
+ * credentials that the login cache has already verified.
+ */
+int runLogin(int argc, char** argv) {
+    std::vector<unsigned> costs;
+    for (int i = 0; i < argc; i++) {
+        costs.push_back((unsigned)strtoul(argv[i], NULL, 10));
+    }
+    if (costs.empty()) {
+        for (unsigned cost = 8; cost <= 16; cost += 2) {
+            costs.push_back(cost);
+        }
+    }
+
+    printf("cost,iterations,mode,logins,seconds,logins_per_second\n");
+    for (size_t i = 0; i < costs.size(); i++) {
+        if (!setPasswordHashCost(costs[i])) {
+            fprintf(stderr, "Cost %u is out of range.\n", costs[i]);
+            continue;
+        }
+        // Enough users to keep the cold run around a second
+        unsigned users = costs[i] >= 16 ? 16 : (1u << (16 - costs[i])) * 4;
+        users = users > LOGIN_CACHE_CAPACITY ? LOGIN_CACHE_CAPACITY : users;
+        std::vector<std::string> phones = generatePhoneCorpus(users);
+        clearUserTable();
+        User user;
+        memset(&user, 0, sizeof(user));
+        for (unsigned j = 0; j < users; j++) {
+            strcpy(user.phone, phones[j].c_str());
+            strcpy(user.password, "password");
+            saveUser(&user);
+        }
+
+        for (int mode = 0; mode < 2; mode++) {
+            unsigned rounds = mode == 0 ? 1 : 100;
+            unsigned ok = 0;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (unsigned round = 0; round < rounds; round++) {
+                for (unsigned j = 0; j < users; j++) {
+                    ok += validateLogin(phones[j].c_str(), "password") ? 1 : 0;
+                }
+            }
+            double seconds = secondsSince(start);
+            printf("%u,%u,%s,%u,%.3f,%.0f\n", costs[i], 1u << costs[i], mode == 0 ? "cold" : "cached", ok,
+                seconds, seconds > 0 ? ok / seconds : 0.0);
+        }
+        clearUserTable();
+    }
+    return 0;
+}
+
+/**
+ * @brief Parallel login throughput of the user store.
+ *
+ * Arguments: `[cost] [threads...]`. Defaults to cost 10 and 1, 2, 4 and 8
+ * threads. Every thread logs in its own share of 1024 users; "cold" logins
+ * run PBKDF2, "cached" logins are served by the login cache. Speedup is
+ * relative to the first thread count of the same mode.
+ */
+int runConcurrentLogin(int argc, char** argv) {
+    unsigned cost = argc > 0 ? (unsigned)strtoul(argv[0], NULL, 10) : 10;
+    std::vector<unsigned> threadCounts;
+    for (int i = 1; i < argc; i++) {
+        threadCounts.push_back((unsigned)strtoul(argv[i], NULL, 10));
+    }
+    if (threadCounts.empty()) {
+        for (unsigned threads = 1; threads <= 8; threads *= 2) {
+            threadCounts.push_back(threads);
+        }
+    }
+    if (!setPasswordHashCost(cost)) {
+        fprintf(stderr, "Cost %u is out of range.\n", cost);
+        return 1;
+    }
+
+    const unsigned users = LOGIN_CACHE_CAPACITY;
+    std::vector<std::string> phones = generatePhoneCorpus(users);
+    clearUserTable();
+    User user;
+    memset(&user, 0, sizeof(user));
+    for (unsigned j = 0; j < users; j++) {
+        strcpy(user.phone, phones[j].c_str());
+        strcpy(user.password, "password");
+        saveUser(&user);
+    }
+
+    printf("cost,mode,threads,logins,seconds,logins_per_second,speedup\n");
+    for (int mode = 0; mode < 2; mode++) {
+        unsigned rounds = mode == 0 ? 1 : 200;
+        double baseline = 0.0;
+        for (size_t i = 0; i < threadCounts.size(); i++) {
+            unsigned threads = threadCounts[i] > 0 ? threadCounts[i] : 1;
+            if (mode == 0) {
+                clearLoginCache();
+            }
+            std::atomic<unsigned> ok(0);
+            std::vector<std::thread> workers;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (unsigned t = 0; t < threads; t++) {
+                workers.push_back(std::thread([&, t]() {
+                    unsigned local = 0;
+                    for (unsigned round = 0; round < rounds; round++) {
+                        for (unsigned j = t; j < users; j += threads) {
+                            local += validateLogin(phones[j].c_str(), "password") ? 1 : 0;
+                        }
+                    }
+                    ok += local;
+                }));
+            }
+            for (size_t t = 0; t < workers.size(); t++) {
+                workers[t].join();
+            }
+            double seconds = secondsSince(start);
+            double rate = seconds > 0 ? ok.load() / seconds : 0.0;
+            baseline = i == 0 ? rate : baseline;
+            printf("%u,%s,%u,%u,%.3f,%.0f,%.2f\n", cost, mode == 0 ? "cold" : "cached", threads, ok.load(),
+                seconds, rate, baseline > 0 ? rate / baseline : 0.0);
+        }
+    }
+    clearUserTable();
+    return 0;
+}
+
+/**
+ * @brief Size of one phone number key in the "probe_policies" suite.
+ */
+#define PROBE_KEY_SIZE 16
+
+/**
+ * @brief Maximum number of absent keys looked up per run of the "probe_policies" suite.
+ */
+#define PROBE_MISS_SAMPLE 1000000u
+
+/**
+ * @brief Writes phone numbers in the layout of generatePhoneCorpus into a flat key array.
+ *
+ * @param keys Receives `count` keys of PROBE_KEY_SIZE bytes.
+ * @param first Index of the first generated number.
+ * @param count Number of keys to generate.
+ */
+void generateProbeKeys(std::vector<char>& keys, size_t first, size_t count) {
+    keys.assign(count * PROBE_KEY_SIZE, '\0');
+    for (size_t i = 0; i < count; i++) {
+        size_t n = first + i;
+        snprintf(&keys[i * PROBE_KEY_SIZE], PROBE_KEY_SIZE, "0%u%07lu", 530 + (unsigned)(n % 30),
+            (1000000ul + (unsigned long)(n / 30)) % 10000000ul);
+    }
+}
+
+/**
+ * @brief Looks a key up in a slot array under the current probe policy.
+ *
+ * @param slots The slot array to search.
+ * @param capacity Number of slots in the array (power of two).
+ * @param keys Keys referenced by the slots, record `r` being key `r - 1`.
+ * @param key The key to look for.
+ * @param probes Incremented by the number of slots examined.
+ * @return True if the key is stored in the array.
+ */
+bool probeKeyLookup(const UserSlot* slots, unsigned capacity, const std::vector<char>& keys, const char* key,
+    unsigned long long* probes) {
+    unsigned h = hash(key);
+    UserProbe probe = userProbeStart(h, capacity);
+    for (; slots[probe.index].record != 0 && probe.count < capacity; userProbeNext(&probe)) {
+        const UserSlot* slot = &slots[probe.index];
+        if (slot->hash == h && strcmp(&keys[(slot->record - 1) * PROBE_KEY_SIZE], key) == 0) {
+            *probes += probe.count + 1;
+            return true;
+        }
+    }
+    *probes += probe.count + 1;
+    return false;
+}
+
+/**
+ * @brief Insert and lookup costs of every user index probe policy at fixed load factors.
+ *
+ * Arguments: `[keys...]`. Defaults to 10^3 up to 10^6 keys; pass 10000000 for
+ * the largest size. Each size is rounded up to a power-of-two slot array that is
+ * filled to load factors 0.5 to 0.95, beyond the 75% at which the user table
+ * itself grows, so the slot arrays are driven directly. Lookups hit every stored
+ * key once and miss with as many absent keys, at most PROBE_MISS_SAMPLE. Times
+ * are nanoseconds per operation, probe counts include the slot holding the key
+ * (or the empty slot ending a miss), and memory is the slot array plus the key
+ * storage.
+ */
+int runProbePolicies(int argc, char** argv) {
+    std::vector<unsigned> sizes;
+    for (int i = 0; i < argc; i++) {
+        sizes.push_back((unsigned)strtoul(argv[i], NULL, 10));
+    }
+    if (sizes.empty()) {
+        for (unsigned size = 1000; size <= 1000000; size *= 10) {
+            sizes.push_back(size);
+        }
+    }
+    const double loadFactors[] = { 0.5, 0.75, 0.85, 0.9, 0.95 };
+    const size_t loadCount = sizeof(loadFactors) / sizeof(loadFactors[0]);
+    UserProbePolicy previous = userProbePolicy;
+
+    printf("policy,keys,slots,load_factor,insert_ns,hit_ns,miss_ns,hit_probes,miss_probes,max_probes,bytes,bytes_per_key\n");
+    for (size_t i = 0; i < sizes.size(); i++) {
+        unsigned capacity = USER_TABLE_INITIAL_CAPACITY;
+        while (capacity < sizes[i] && capacity < 0x80000000u) {
+            capacity *= 2;
+        }
+        std::vector<char> keys;
+        std::vector<char> absent;
+        generateProbeKeys(keys, 0, (size_t)(capacity * loadFactors[loadCount - 1]));
+        generateProbeKeys(absent, keys.size() / PROBE_KEY_SIZE, PROBE_MISS_SAMPLE);
+        std::vector<UserSlot> slots(capacity);
+
+        for (int policy = 0; policy < USER_PROBE_POLICY_COUNT; policy++) {
+            userProbePolicy = (UserProbePolicy)policy;
+            for (size_t l = 0; l < loadCount; l++) {
+                unsigned count = (unsigned)(capacity * loadFactors[l]);
+                memset(slots.data(), 0, slots.size() * sizeof(UserSlot));
+
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                for (unsigned k = 0; k < count; k++) {
+                    UserSlot slot = { hash(&keys[k * PROBE_KEY_SIZE]), k + 1 };
+                    userTablePlace(slots.data(), capacity, slot);
+                }
+                double insertSeconds = secondsSince(start);
+
+                unsigned long long hitProbes = 0;
+                unsigned hits = 0;
+                unsigned maxProbes = 0;
+                start = std::chrono::steady_clock::now();
+                for (unsigned k = 0; k < count; k++) {
+                    unsigned long long before = hitProbes;
+                    hits += probeKeyLookup(slots.data(), capacity, keys, &keys[k * PROBE_KEY_SIZE], &hitProbes) ? 1 : 0;
+                    maxProbes = hitProbes - before > maxProbes ? (unsigned)(hitProbes - before) : maxProbes;
+                }
+                double hitSeconds = secondsSince(start);
+
+                unsigned long long missProbes = 0;
+                unsigned misses = 0;
+                unsigned missCount = count < PROBE_MISS_SAMPLE ? count : PROBE_MISS_SAMPLE;
+                start = std::chrono::steady_clock::now();
+                for (unsigned k = 0; k < missCount; k++) {
+                    misses += probeKeyLookup(slots.data(), capacity, keys, &absent[k * PROBE_KEY_SIZE], &missProbes) ? 0 : 1;
+                }
+                double missSeconds = secondsSince(start);
+
+                if (hits != count || misses != missCount) {
+                    fprintf(stderr, "%s: %u of %u hits and %u of %u misses.\n", userProbePolicyNames[policy], hits,
+                        count, misses, missCount);
+                }
+                size_t bytes = (size_t)capacity * sizeof(UserSlot) + (size_t)count * PROBE_KEY_SIZE;
+                printf("%s,%u,%u,%.2f,%.1f,%.1f,%.1f,%.3f,%.3f,%u,%zu,%.1f\n", userProbePolicyNames[policy], count,
+                    capacity, loadFactors[l], insertSeconds * 1e9 / count, hitSeconds * 1e9 / count,
+                    missSeconds * 1e9 / missCount, (double)hitProbes / count, (double)missProbes / missCount, maxProbes,
+                    bytes, (double)bytes / count);
+                fflush(stdout);
+            }
+        }
+    }
+    userProbePolicy = previous;
+    return 0;
+}
+
+/**
+ * @brief Generates a login trace with a Zipf-like popularity.
+ *
+ * The i-th of `users` generated phone numbers logs in with a probability
+ * proportional to 1 / (i + 1), so a few users account for most logins.
+ *
+ * @param users Number of distinct users.
+ * @param logins Number of logins in the trace.
+ * @return The phone number of every login, in trace order.
+ */
+std::vector<std::string> generateLoginTrace(unsigned users, unsigned logins) {
+    std::vector<std::string> phones = generatePhoneCorpus(users);
+    std::vector<double> cumulative(users);
+    double total = 0.0;
+    for (unsigned i = 0; i < users; i++) {
+        total += 1.0 / (i + 1);
+        cumulative[i] = total;
+    }
+
+    std::mt19937 random(12345);
+    std::uniform_real_distribution<double> pick(0.0, total);
+    std::vector<std::string> trace;
+    trace.reserve(logins);
+    for (unsigned i = 0; i < logins; i++) {
+        size_t user = std::upper_bound(cumulative.begin(), cumulative.end(), pick(random)) - cumulative.begin();
+        trace.push_back(phones[user < users ? user : users - 1]);
+    }
+    return trace;
+}
+
+/**
+ * @brief Counts the slots a lookup of a phone number examines in the user index.
+ *
+ * The caller must have completed any running rehash.
+ *
+ * @param phone The phone number to look up.
+ * @return The number of slots examined up to the first record of the phone.
+ */
+unsigned userIndexProbes(const char* phone) {
+    unsigned h = hash(phone);
+    UserProbe probe = userProbeStart(h, userTable.capacity);
+    for (; userTable.slots[probe.index].record != 0 && probe.count < userTable.capacity; userProbeNext(&probe)) {
+        const UserSlot* slot = &userTable.slots[probe.index];
+        if (slot->hash == h &&
+            userTableRecordHasPhone(&userTable, &userTable.records[slot->record - 1], userPhoneKey(phone), phone)) {
+            break;
+        }
+    }
+    return probe.count + 1;
+}
+
+/**
+ * @brief Probe lengths of every probe policy replaying a login trace.
+ *
+ * Arguments: `[trace] [users] [logins]`. The trace is a text file with the phone
+ * number of one login per line, or a users file whose records each log in
+ * once. Without a usable trace, `logins` (default 1000000) logins of `users`
+ * (default 100000) users are generated with a Zipf-like popularity. The user
+ * index holds every distinct phone of the trace, in order of first login.
+ * "user_probes" averages over the stored users, which is what Brent's method
+ * minimizes; "login_probes" weights every user by its logins.
+ */
+int runLoginTrace(int argc, char** argv) {
+    unsigned users = argc > 1 ? (unsigned)strtoul(argv[1], NULL, 10) : 100000;
+    unsigned logins = argc > 2 ? (unsigned)strtoul(argv[2], NULL, 10) : 1000000;
+    std::vector<std::string> trace;
+    if (argc > 0) {
+        trace = loadPhoneCorpus(argv[0]);
+        if (trace.empty()) {
+            fprintf(stderr, "Trace %s is empty or unreadable, using a generated trace.\n", argv[0]);
+        }
+    }
+    if (trace.empty()) {
+        trace = generateLoginTrace(users > 0 ? users : 1, logins);
+    }
+    UserProbePolicy previous = userProbePolicy;
+
+    printf("policy,users,logins,load_factor,user_probes,login_probes,max_probes,lookup_ns\n");
+    for (int policy = 0; policy < USER_PROBE_POLICY_COUNT; policy++) {
+        clearUserTable();
+        setUserProbePolicy((UserProbePolicy)policy);
+        User user;
+        memset(&user, 0, sizeof(user));
+        for (size_t i = 0; i < trace.size(); i++) {
+            User existing;
+            if (!findUser(trace[i].c_str(), &existing)) {
+                strncpy(user.phone, trace[i].c_str(), sizeof(user.phone) - 1);
+                saveUser(&user);
+            }
+        }
+        UserProbeStats stats = userTableProbeStats();
+
+        unsigned long long probes = 0;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < trace.size(); i++) {
+            probes += userIndexProbes(trace[i].c_str());
+        }
+        double seconds = secondsSince(start);
+
+        printf("%s,%u,%zu,%.3f,%.3f,%.3f,%u,%.1f\n", userProbePolicyNames[policy], userTable.count, trace.size(),
+            (double)userTable.count / userTable.capacity, stats.averageProbes, (double)probes / trace.size(),
+            stats.maxProbes, seconds * 1e9 / trace.size());
+    }
+    clearUserTable();
+    setUserProbePolicy(previous);
+    return 0;
+}
+
+/**
+ * @brief Page I/O of the paged users file as it grows by extendible hashing.
+ *
+ * Arguments: `[users] [batch]`. Defaults to 10^6 users inserted in checkpoints
+ * of 10^5. After every checkpoint the suite reports the file size, the page
+ * writes per insert (one, plus two per split) and the pages read by 10^4
+ * lookups of stored users. Works on benchmark_paged.bin in the current
+ * directory and removes it.
+ */
+int runPagedGrowth(int argc, char** argv) {
+    unsigned users = argc > 0 ? (unsigned)strtoul(argv[0], NULL, 10) : 1000000;
+    unsigned batch = argc > 1 ? (unsigned)strtoul(argv[1], NULL, 10) : 100000;
+    batch = batch > 0 ? batch : 1;
+    const char* path = "benchmark_paged.bin";
+    setPasswordHashCost(BENCHMARK_PASSWORD_COST);
+    clearUserTable();
+    std::vector<std::string> phones = generatePhoneCorpus(users);
+
+    UserPagedFile paged;
+    memset(&paged, 0, sizeof(paged));
+    if (!saveUserPagedFile(path, NULL, &paged)) {
+        fprintf(stderr, "Could not create %s.\n", path);
+        return 1;
+    }
+
+    printf("users,pages,depth,file_mb,insert_us,page_writes_per_insert,lookup_us,pages_per_lookup\n");
+    std::vector<User> records;
+    std::mt19937 random(12345);
+    for (unsigned first = 0; first < users; first += batch) {
+        unsigned count = users - first < batch ? users - first : batch;
+        records.assign(count, User());
+        for (unsigned i = 0; i < count; i++) {
+            memset(&records[i], 0, sizeof(User));
+            strcpy(records[i].phone, phones[first + i].c_str());
+            strcpy(records[i].password, "password");
+            hashUserPassword(&records[i]);
+        }
+
+        unsigned long long writes = paged.pageWrites;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (unsigned i = 0; i < count; i++) {
+            userPagedFileInsert(&paged, &records[i]);
+        }
+        commitUserPagedFile(&paged);
+        double insertSeconds = secondsSince(start);
+
+        const unsigned lookups = 10000;
+        unsigned long long reads = paged.pageReads;
+        User found;
+        start = std::chrono::steady_clock::now();
+        for (unsigned i = 0; i < lookups; i++) {
+            const char* phone = phones[random() % (first + count)].c_str();
+            userPagedFileCollect(&paged, userPhoneKey(phone), phone, &found, 0, 1, NULL);
+        }
+        double lookupSeconds = secondsSince(start);
+
+        printf("%u,%u,%u,%.1f,%.2f,%.3f,%.2f,%.3f\n", first + count, paged.header.pageCount, paged.header.depth,
+            ((double)paged.header.pageCount + 1) * USER_PAGE_SIZE / (1024.0 * 1024.0), insertSeconds * 1e6 / count,
+            (double)(paged.pageWrites - writes) / count, lookupSeconds * 1e6 / lookups,
+            (double)(paged.pageReads - reads) / lookups);
+        fflush(stdout);
+    }
+
+    closeUserPagedFile(&paged);
+    char directoryPath[272];
+    snprintf(directoryPath, sizeof(directoryPath), "%s.dir", path);
+    remove(path);
+    remove(directoryPath);
+    return 0;
+}
+
+/**
+ * @brief Cost of logins with unregistered phone numbers, with and without the phone number filters.
+ *
+ * Arguments: `[users] [attempts]`. Defaults to 10^6 users and 10^6 attempts
+ * with numbers of the same shape that were never registered, as a bot
+ * guessing numbers sends them. Each layout of users.bin is measured with its
+ * filters and with them detached. Works on benchmark_users.bin in the current
+ * directory and removes it.
+ */
+int runBotLogins(int argc, char** argv) {
+    unsigned users = argc > 0 ? (unsigned)strtoul(argv[0], NULL, 10) : 1000000;
+    unsigned attempts = argc > 1 ? (unsigned)strtoul(argv[1], NULL, 10) : 1000000;
+    const char* path = "benchmark_users.bin";
+    std::vector<std::string> phones = generatePhoneCorpus((size_t)users + attempts);
+
+    printf("layout,users,filter,attempts,ns_per_attempt,pages_per_attempt,false_positive_rate,expected_rate,filter_kb\n");
+    for (int layout = 0; layout < 2; layout++) {
+        fillUserTable(users);
+        if (layout == 1) {
+            UserPagedFile paged;
+            memset(&paged, 0, sizeof(paged));
+            saveUserPagedFile(path, NULL, &paged);
+            closeUserPagedFile(&paged);
+            clearUserTable();
+            loadUserFile(path);
+        }
+
+        for (int filtered = 1; filtered >= 0; filtered--) {
+            UserFilterBlock* tableFilter = userTable.filter;
+            UserFilterBlock* oldTableFilter = userTable.oldFilter;
+            UserFilterBlock* pageFilter = userPagedFile.filter;
+            if (!filtered) {
+                userTable.filter = NULL;
+                userTable.oldFilter = NULL;
+                userPagedFile.filter = NULL;
+            }
+            UserFilterStats before = userFilterStats();
+            unsigned long long reads = userPagedFile.pageReads;
+            unsigned accepted = 0;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (unsigned i = 0; i < attempts; i++) {
+                accepted += validateLogin(phones[(size_t)users + i].c_str(), "password") ? 1 : 0;
+            }
+            double seconds = secondsSince(start);
+            UserFilterStats after = userFilterStats();
+            userTable.filter = tableFilter;
+            userTable.oldFilter = oldTableFilter;
+            userPagedFile.filter = pageFilter;
+
+            unsigned long long misses = after.rejections - before.rejections + after.falsePositives - before.falsePositives;
+            printf("%s,%u,%s,%u,%.1f,%.4f,%.5f,%.5f,%.0f\n", layout == 0 ? "indexed" : "paged", users,
+                filtered ? "on" : "off", attempts - accepted, attempts > 0 ? seconds * 1e9 / attempts : 0.0,
+                attempts > 0 ? (double)(userPagedFile.pageReads - reads) / attempts : 0.0,
+                misses > 0 ? (double)(after.falsePositives - before.falsePositives) / misses : 0.0,
+                after.expectedFalsePositiveRate, after.bytes / 1024.0);
+            fflush(stdout);
+        }
+        clearUserTable();
+        userFileLayout = USER_FILE_INDEXED;
+    }
+    remove(path);
+    remove("benchmark_users.bin.dir");
+    return 0;
+}
+
+/**
+ * @brief Size, startup and login cost of users.bin before and after removing shadowed records.
+ *
+ * Arguments: `[users] [reregistrations]`. Defaults to 2*10^5 users of which
+ * 10^5 re-register with a new password, stored as additional records the way
+ * builds without the upsert path did. Logins use the new passwords of the
+ * re-registered phone numbers, so before compaction each one also verifies
+ * the stale record. Works on users.bin in the current directory and removes it.
+ */
+int runCompaction(int argc, char** argv) {
+    unsigned users = argc > 0 ? (unsigned)strtoul(argv[0], NULL, 10) : 200000;
+    unsigned reregistrations = argc > 1 ? (unsigned)strtoul(argv[1], NULL, 10) : 100000;
+    if (reregistrations > users) {
+        reregistrations = users;
+    }
+    std::vector<std::string> phones = generatePhoneCorpus(users);
+    remove("users.log");
+    fillUserTable(users);
+    User user;
+    memset(&user, 0, sizeof(user));
+    strcpy(user.password, "changed");
+    lockUserStore(true);
+    for (unsigned i = 0; i < reregistrations; i++) {
+        strcpy(user.phone, phones[i].c_str());
+        quadraticProbingInsert(&user);
+    }
+    unlockUserStore(true);
+    saveUserFile("users.bin");
+
+    printf("state,records,file_bytes,load_ms,login_ns,logins_ok,compact_ms\n");
+    double compactSeconds = 0.0;
+    for (int compacted = 0; compacted < 2; compacted++) {
+        if (compacted) {
+            UserCompactStats stats;
+            compactUserStore(&stats);
+            compactSeconds = stats.seconds;
+        }
+        clearUserTable();
+        FILE* file = fopen("users.bin", "rb");
+        fseek(file, 0, SEEK_END);
+        long bytes = ftell(file);
+        fclose(file);
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        loadUserFile("users.bin");
+        double loadSeconds = secondsSince(start);
+        unsigned accepted = 0;
+        start = std::chrono::steady_clock::now();
+        for (unsigned i = 0; i < reregistrations; i++) {
+            accepted += validateLogin(phones[i].c_str(), "changed") ? 1 : 0;
+        }
+        double loginSeconds = secondsSince(start);
+
+        printf("%s,%u,%ld,%.3f,%.1f,%u,%.1f\n", compacted ? "compacted" : "duplicated", userTable.count, bytes,
+            loadSeconds * 1e3, reregistrations > 0 ? loginSeconds * 1e9 / reregistrations : 0.0, accepted,
+            compactSeconds * 1e3);
+        fflush(stdout);
+    }
+    clearUserTable();
+    remove("users.bin");
+    remove("users.log");
+    return 0;
+}
+
+/**
+ * @brief Size and load time of users.bin with User records (version 4) and packed records.
+ *
+ * Arguments: `[users...]`. Defaults to 10^5 and 10^6 users. The version 4 file
+ * is written record by record from the table and packed again while loading;
+ * the current file is mapped. Memory is what the table holds per user after
+ * loading: records and name arena, and for version 4 what its User slab held.
+ * Lookups copy a random registered user out of the table and are timed on a
+ * second pass, after the mapping has been faulted in. Works on users.bin
+ * in the current directory and removes it.
+ */
+int runRecordEncoding(int argc, char** argv) {
+    std::vector<unsigned> sizes;
+    for (int i = 0; i < argc; i++) {
+        sizes.push_back((unsigned)strtoul(argv[i], NULL, 10));
+    }
+    if (sizes.empty()) {
+        sizes.push_back(100000);
+        sizes.push_back(1000000);
+    }
+
+    remove("users.log");
+    printf("format,users,record_bytes,memory_bytes_per_user,file_bytes,load_ms,lookup_ns\n");
+    for (size_t i = 0; i < sizes.size(); i++) {
+        std::vector<std::string> phones = generatePhoneCorpus(sizes[i]);
+        const int formats[] = { 4, USER_FILE_VERSION };
+        for (int format : formats) {
+            fillUserTable(sizes[i]);
+            size_t memory;
+            if (format == 4) {
+                UserFileHeader header;
+                memset(&header, 0, sizeof(header));
+                memcpy(header.magic, USER_FILE_MAGIC, 4);
+                header.version = 4;
+                header.recordSize = sizeof(User);
+                header.hashFunction = userHashFunctionIndex();
+                header.count = userTable.count;
+                header.capacity = userTable.capacity;
+                header.recordsOffset = sizeof(UserFileHeader);
+                header.slotsOffset = header.recordsOffset + (uint64_t)userTable.count * sizeof(User);
+                header.probePolicy = (uint32_t)userProbePolicy;
+                FILE* file = fopen("users.bin", "wb");
+                fwrite(&header, sizeof(header), 1, file);
+                User user;
+                for (unsigned j = 0; j < userTable.count; j++) {
+                    userTableUnpack(&userTable, &userTable.records[j], &user);
+                    fwrite(&user, sizeof(user), 1, file);
+                }
+                fwrite(userTable.slots, sizeof(UserSlot), userTable.capacity, file);
+                fclose(file);
+                memory = (size_t)userTable.count * sizeof(User);
+            }
+            else {
+                saveUserFile("users.bin");
+                memory = (size_t)userTable.count * sizeof(PackedUser) + userTable.namesSize;
+            }
+            clearUserTable();
+
+            uint32_t version;
+            size_t bytes = 0;
+            userFileInfo("users.bin", &version, &bytes);
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            loadUserFile("users.bin");
+            double loadSeconds = secondsSince(start);
+
+            const unsigned lookups = 1000000;
+            User found;
+            unsigned hits = 0;
+            double lookupSeconds = 0.0;
+            for (int pass = 0; pass < 2; pass++) { // The first pass faults the mapping in
+                hits = 0;
+                start = std::chrono::steady_clock::now();
+                for (unsigned j = 0; j < lookups; j++) {
+                    hits += userTableCollect(phones[random() % phones.size()].c_str(), &found, 1);
+                }
+                lookupSeconds = secondsSince(start);
+            }
+
+            printf("%s,%u,%zu,%.1f,%zu,%.3f,%.1f\n", format == 4 ? "user_v4" : "packed", sizes[i],
+                format == 4 ? sizeof(User) : sizeof(PackedUser), (double)memory / sizes[i], bytes, loadSeconds * 1e3,
+                hits == lookups ? lookupSeconds * 1e9 / lookups : -1.0);
+            fflush(stdout);
+            clearUserTable();
+        }
+    }
+    remove("users.bin");
+    remove("users.log");
+    return 0;
+}
+
+/**
+ * @brief Structure describing one benchmark suite.
+ */
+typedef struct BenchmarkSuite {
+    const char* name;                         /**< Name used on the command line. */
+    const char* usage;                        /**< Arguments accepted by the suite. */
+    int (*run)(int argc, char** argv);        /**< Runs the suite with the remaining arguments. */
+} BenchmarkSuite;
+
+/**
+ * @brief Cost of keying lookups on the canonical phone number, per written form.
+ *
+ * Arguments: `[users]`. Defaults to 10^6 users. The table is filled with the
+ * national form of the generated numbers ("05551234567"). Each form of the
+ * numbers is first hashed as text, as the index did before. Each form is then
+ * normalized and hashed through its canonical key. Each form is then looked
+ * up in the table; lookups are timed on a second pass. Finally the distinct
+ * counts show how many keys each scheme gives the corpus written in every
+ * form at once.
+ */
+int runPhoneKeys(int argc, char** argv) {
+    unsigned count = argc > 0 ? (unsigned)strtoul(argv[0], NULL, 10) : 1000000;
+    remove("users.log");
+    fillUserTable(count);
+    std::vector<std::string> phones = generatePhoneCorpus(count);
+
+    const char* names[] = { "national", "bare", "spaced", "international" };
+    std::vector<std::vector<std::string> > forms(4);
+    char phone[32];
+    for (size_t i = 0; i < phones.size(); i++) {
+        const char* digits = phones[i].c_str() + 1;
+        forms[0].push_back(phones[i]);
+        forms[1].push_back(digits);
+        snprintf(phone, sizeof(phone), "+90 %.3s %.3s %.2s %.2s", digits, digits + 3, digits + 6, digits + 8);
+        forms[2].push_back(phone);
+        snprintf(phone, sizeof(phone), "0090%s", digits);
+        forms[3].push_back(phone);
+    }
+
+    std::vector<uint64_t> texts;
+    std::vector<uint64_t> keys;
+    volatile uint64_t keySink = 0;
+    printf("form,users,text_hash_ns,key_hash_ns,lookup_ns,hits\n");
+    for (int f = 0; f < 4; f++) {
+        uint64_t sink = 0;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < forms[f].size(); i++) {
+            const std::string& text = forms[f][i];
+            texts.push_back(userHashFunction(text.c_str(), text.size()));
+        }
+        double textSeconds = secondsSince(start);
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < forms[f].size(); i++) {
+            uint64_t key = userPhoneKey(forms[f][i].c_str());
+            keys.push_back(key);
+            sink += hashUserKey(key);
+        }
+        double keySeconds = secondsSince(start);
+        keySink = keySink + sink;
+
+        User found;
+        unsigned hits = 0;
+        double lookupSeconds = 0.0;
+        for (int pass = 0; pass < 2; pass++) {
+            hits = 0;
+            start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < forms[f].size(); i++) {
+                hits += userTableCollect(forms[f][i].c_str(), &found, 1);
+            }
+            lookupSeconds = secondsSince(start);
+        }
+        printf("%s,%u,%.1f,%.1f,%.1f,%u\n", names[f], count, textSeconds * 1e9 / count, keySeconds * 1e9 / count,
+            lookupSeconds * 1e9 / count, hits);
+        fflush(stdout);
+    }
+
+    std::sort(texts.begin(), texts.end());
+    std::sort(keys.begin(), keys.end());
+    printf("distinct_text_hashes,%zu\ndistinct_keys,%zu\n",
+        (size_t)(std::unique(texts.begin(), texts.end()) - texts.begin()),
+        (size_t)(std::unique(keys.begin(), keys.end()) - keys.begin()));
+    clearUserTable();
+    remove("users.log");
+    return 0;
+}
+
+/**
+ * @brief Counts the users whose name starts with a prefix, as a scan of the whole table does.
+ */
+typedef struct NamePrefixScan {
+    const char* prefix;          /**< Prefix to match. */
+    size_t length;               /**< Length of `prefix`. */
+    unsigned matches;            /**< Users that matched. */
+} NamePrefixScan;
+
+/**
+ * @brief Visit function of the "name_prefix" scan.
+ */
+void scanNamePrefix(User* user, void* context) {
+    NamePrefixScan* scan = (NamePrefixScan*)context;
+    scan->matches += strncasecmp(user->name, scan->prefix, scan->length) == 0;
+}
+
+/**
+ * @brief Prefix queries on user names through the name index against a full scan.
+ *
+ * Arguments: `[users] [queries]`. Defaults to 10^6 users and 10^4 queries.
+ * Names and surnames are drawn from syllables, so prefixes of one to four
+ * letters match from thousands of users down to a handful. Each query asks for
+ * a page of 20 at a random offset. The index is built by the first query;
+ * its build time and size are reported, as is the registration cost with it.
+ */
+int runNamePrefix(int argc, char** argv) {
+    unsigned count = argc > 0 ? (unsigned)strtoul(argv[0], NULL, 10) : 1000000;
+    unsigned queries = argc > 1 ? (unsigned)strtoul(argv[1], NULL, 10) : 10000;
+    const char* syllables[] = { "al", "ay", "be", "ce", "de", "ek", "fa", "ha", "ka", "me", "ne", "os", "se", "ya", "zi" };
+    const unsigned syllableCount = sizeof(syllables) / sizeof(syllables[0]);
+    std::mt19937 random(7);
+
+    remove("users.log");
+    setPasswordHashCost(BENCHMARK_PASSWORD_COST);
+    clearUserTable();
+    std::vector<std::string> phones = generatePhoneCorpus(count);
+    User user;
+    memset(&user, 0, sizeof(user));
+    strcpy(user.password, "password");
+    for (unsigned i = 0; i < count; i++) {
+        snprintf(user.name, sizeof(user.name), "%s%s%s", syllables[random() % syllableCount],
+            syllables[random() % syllableCount], syllables[random() % syllableCount]);
+        snprintf(user.surname, sizeof(user.surname), "%s%s%s%s", syllables[random() % syllableCount],
+            syllables[random() % syllableCount], syllables[random() % syllableCount], syllables[random() % syllableCount]);
+        strcpy(user.phone, phones[i].c_str());
+        saveUser(&user);
+    }
+
+    User page[20];
+    unsigned total;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    findUsersByNamePrefix(USER_NAME_FIELD_NAME, "", 0, page, 1, &total);
+    double buildSeconds = secondsSince(start);
+    size_t bytes = (size_t)userNameIndex.nodeCapacity * sizeof(UserNameNode) +
+        (size_t)userNameIndex.listCapacity * sizeof(UserNameList) + userNameIndex.phonesCapacity;
+    for (uint32_t i = 0; i < userNameIndex.listCount; i++) {
+        bytes += (size_t)userNameIndex.lists[i].capacity * sizeof(uint64_t);
+    }
+    printf("users,build_ms,index_bytes_per_user,nodes\n%u,%.1f,%.1f,%u\n\n", count, buildSeconds * 1e3,
+        (double)bytes / count, userNameIndex.nodeCount);
+
+    printf("prefix_length,avg_matches,index_query_us,scan_query_us\n");
+    for (int length = 1; length <= 4; length++) {
+        std::vector<std::string> prefixes;
+        for (unsigned q = 0; q < queries; q++) {
+            std::string prefix = std::string(syllables[random() % syllableCount]) + syllables[random() % syllableCount];
+            prefixes.push_back(prefix.substr(0, length));
+        }
+        unsigned long long matches = 0;
+        start = std::chrono::steady_clock::now();
+        for (unsigned q = 0; q < queries; q++) {
+            findUsersByNamePrefix(USER_NAME_FIELD_NAME, prefixes[q].c_str(), 0, page, 0, &total);
+            unsigned offset = total > 20 ? (unsigned)(random() % (total - 20)) : 0;
+            findUsersByNamePrefix(USER_NAME_FIELD_NAME, prefixes[q].c_str(), offset, page, 20, &total);
+            matches += total;
+        }
+        double indexSeconds = secondsSince(start);
+        unsigned scans = queries < 20 ? queries : 20; // A scan reads every user
+        start = std::chrono::steady_clock::now();
+        for (unsigned q = 0; q < scans; q++) {
+            NamePrefixScan scan = { prefixes[q].c_str(), prefixes[q].size(), 0 };
+            forEachUser(scanNamePrefix, &scan);
+        }
+        double scanSeconds = secondsSince(start);
+        printf("%d,%.1f,%.2f,%.0f\n", length, (double)matches / queries, indexSeconds * 1e6 / queries,
+            scanSeconds * 1e6 / scans);
+        fflush(stdout);
+    }
+
+    const unsigned updates = count < 100000 ? count : 100000;
+    for (int indexed = 1; indexed >= 0; indexed--) {
+        if (!indexed) {
+            lockUserStore(true);
+            userNameIndexReset();
+            unlockUserStore(true);
+        }
+        start = std::chrono::steady_clock::now();
+        for (unsigned i = 0; i < updates; i++) {
+            snprintf(user.name, sizeof(user.name), "re%s", syllables[random() % syllableCount]);
+            strcpy(user.phone, phones[random() % phones.size()].c_str());
+            saveUser(&user);
+        }
+        printf("%sreregistration_us,%.2f\n", indexed ? "\nindexed_" : "unindexed_", secondsSince(start) * 1e6 / updates);
+    }
+    clearUserTable();
+    remove("users.log");
+    return 0;
+}
+
+/**
+ * @brief Visit function of the "export" baseline: one fprintf per user, as printHashTable did.
+ */
+void printExportBaseline(User* user, void* context) {
+    fprintf((FILE*)context, " Name: %s %s, Phone: %s, Password: %s\n", user->name, user->surname, user->phone,
+        user->password);
+}
+
+/**
+ * @brief Streams every user to a file in each export format.
+ *
+ * Arguments: `[users]`. Defaults to 10^6 users. The baseline walks the table
+ * with forEachUser and an fprintf per record; the exporter formats into its
+ * own buffer, both as one pass and as pages of 10^4 users resumed by cursor.
+ */
+int runExport(int argc, char** argv) {
+    unsigned count = argc > 0 ? (unsigned)strtoul(argv[0], NULL, 10) : 1000000;
+    const char* path = "users.export";
+
+    remove("users.log");
+    setPasswordHashCost(BENCHMARK_PASSWORD_COST);
+    clearUserTable();
+    std::vector<std::string> phones = generatePhoneCorpus(count);
+    User user;
+    memset(&user, 0, sizeof(user));
+    strcpy(user.password, "password");
+    for (unsigned i = 0; i < count; i++) {
+        snprintf(user.name, sizeof(user.name), "Name%u", i);
+        snprintf(user.surname, sizeof(user.surname), "Surname%u", i % 1000);
+        strcpy(user.phone, phones[i].c_str());
+        saveUser(&user);
+    }
+
+    printf("mode,ms,users_per_s,bytes\n");
+    const char* names[] = { "fprintf_baseline", "text", "jsonl", "csv", "jsonl_paged" };
+    const UserExportFormat formats[] = { USER_EXPORT_TEXT, USER_EXPORT_TEXT, USER_EXPORT_JSONL, USER_EXPORT_CSV,
+        USER_EXPORT_JSONL };
+    for (int mode = 0; mode < 5; mode++) {
+        FILE* file = fopen(path, "wb");
+        if (file == NULL) {
+            perror("fopen");
+            return 1;
+        }
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        if (mode == 0) {
+            forEachUser(printExportBaseline, file);
+        } else {
+            uint64_t cursor = 0;
+            do {
+                if (!exportUsers(file, formats[mode], &cursor, mode == 4 ? 10000 : 0, NULL)) {
+                    fprintf(stderr, "Export failed.\n");
+                    fclose(file);
+                    return 1;
+                }
+            } while (cursor != USER_CURSOR_END);
+        }
+        fflush(file);
+        double seconds = secondsSince(start);
+        long bytes = ftell(file);
+        fclose(file);
+        printf("%s,%.1f,%.0f,%ld\n", names[mode], seconds * 1e3, count / seconds, bytes);
+        fflush(stdout);
+    }
+    remove(path);
+    clearUserTable();
+    remove("users.log");
+    return 0;
+}
+
+/**
+ * @brief Cost and output of the user table health metrics.
+ *
+ * Arguments: `[users] [lookups]`. Defaults to 10^6 users and 10^6 lookups
+ * per thread. Threads look up registered phone numbers with findUser and log
+ * in with unregistered ones, so every call bumps the per-thread counters and
+ * one login in eight is timed; the lookup rate at 1 to 8 threads shows
+ * whether the counters contend. Then the time of one snapshot is reported,
+ * with the probe and latency figures it derives.
+ */
+int runTableMetrics(int argc, char** argv) {
+    unsigned count = argc > 0 ? (unsigned)strtoul(argv[0], NULL, 10) : 1000000;
+    unsigned lookups = argc > 1 ? (unsigned)strtoul(argv[1], NULL, 10) : 1000000;
+
+    remove("users.log");
+    setPasswordHashCost(BENCHMARK_PASSWORD_COST);
+    clearUserTable();
+    std::vector<std::string> phones = generatePhoneCorpus(count * 2);
+    User user;
+    memset(&user, 0, sizeof(user));
+    strcpy(user.password, "password");
+    for (unsigned i = 0; i < count; i++) {
+        strcpy(user.phone, phones[i].c_str());
+        saveUser(&user);
+    }
+
+    printf("threads,lookups_per_thread,ns_per_lookup,lookups_per_s\n");
+    for (unsigned threads = 1; threads <= 8; threads *= 2) {
+        std::vector<std::thread> workers;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (unsigned t = 0; t < threads; t++) {
+            workers.push_back(std::thread([&, t]() {
+                User found;
+                std::mt19937 random(t);
+                for (unsigned i = 0; i < lookups; i += 2) {
+                    findUser(phones[random() % count].c_str(), &found);
+                    validateLogin(phones[count + random() % count].c_str(), "password");
+                }
+            }));
+        }
+        for (size_t t = 0; t < workers.size(); t++) {
+            workers[t].join();
+        }
+        double seconds = secondsSince(start);
+        printf("%u,%u,%.1f,%.0f\n", threads, lookups, seconds * 1e9 / lookups, (double)threads * lookups / seconds);
+        fflush(stdout);
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    UserTableMetrics metrics = userTableMetrics();
+    double snapshotSeconds = secondsSince(start);
+    unsigned long long probes = 0;
+    unsigned long long timed = 0;
+    for (int i = 0; i < USER_METRICS_PROBE_BUCKETS; i++) {
+        probes += (unsigned long long)i * metrics.lookupProbes[i];
+    }
+    for (int i = 0; i < USER_METRICS_LATENCY_BUCKETS; i++) {
+        timed += metrics.lookupLatency[i];
+    }
+    unsigned long long median = 0;
+    unsigned long long p99 = 0;
+    unsigned long long seen = 0;
+    for (int i = 0; i < USER_METRICS_LATENCY_BUCKETS; i++) {
+        seen += metrics.lookupLatency[i];
+        median = median == 0 && seen * 2 >= timed ? 2ull << i : median;
+        p99 = p99 == 0 && seen * 100 >= timed * 99 ? 2ull << i : p99;
+    }
+    printf("\nusers,snapshot_ms,load_factor,chain_mean,chain_max,lookup_probes_mean,timed_lookups,"
+        "latency_p50_below_ns,latency_p99_below_ns\n");
+    printf("%u,%.1f,%.3f,%.3f,%u,%.3f,%llu,%llu,%llu\n", metrics.users, snapshotSeconds * 1e3, metrics.loadFactor,
+        metrics.meanChain, metrics.maxChain, metrics.lookups > 0 ? (double)probes / metrics.lookups : 0.0, timed,
+        median, p99);
+    clearUserTable();
+    remove("users.log");
+    return 0;
+}
+
+/**
+ * @brief Size and speed of the Huffman coded attendee list and attendee.bin.
+ *
+ * Arguments: `[attendees]`. Defaults to 10^6 attendees whose names and
+ * surnames are drawn from syllables. Reports the memory of a PackedAttendeeList
+ * and the size of attendee.bin against Attendee records, and the rates at which
+ * the list is packed (codebook training included) and decoded. The names are also
+ * decoded on their own, one bit at a time and through the decoding table.
+ */
+int runAttendeeCodec(int argc, char** argv) {
+    unsigned count = argc > 0 ? (unsigned)strtoul(argv[0], NULL, 10) : 1000000;
+    const char* syllables[] = { "al", "ay", "be", "ce", "de", "ek", "fa", "ha", "ka", "me", "ne", "os", "se", "ya",
+        "zi", "tur", "han", "gul", "can" };
+    const unsigned syllableCount = sizeof(syllables) / sizeof(syllables[0]);
+    std::mt19937 random(11);
+    std::vector<Attendee> list(count);
+    size_t textBytes = 0;
+    for (unsigned i = 0; i < count; i++) {
+        memset(&list[i], 0, sizeof(Attendee));
+        snprintf(list[i].nameAttendee, MAX_NAME_LENGTH, "%s%s%s", syllables[random() % syllableCount],
+            syllables[random() % syllableCount], random() % 2 ? syllables[random() % syllableCount] : "");
+        list[i].nameAttendee[0] = (char)toupper(list[i].nameAttendee[0]);
+        snprintf(list[i].surnameAttendee, MAX_NAME_LENGTH, "%s%s%s", syllables[random() % syllableCount],
+            syllables[random() % syllableCount], syllables[random() % syllableCount]);
+        list[i].surnameAttendee[0] = (char)toupper(list[i].surnameAttendee[0]);
+        textBytes += strlen(list[i].nameAttendee) + strlen(list[i].surnameAttendee);
+    }
+
+    PackedAttendeeList packed;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    if (!packAttendees(list.data(), count, &packed)) {
+        fprintf(stderr, "Packing failed.\n");
+        return 1;
+    }
+    double packSeconds = secondsSince(start);
+    start = std::chrono::steady_clock::now();
+    size_t checksum = 0;
+    Attendee out;
+    for (unsigned i = 0; i < count; i++) {
+        unpackAttendee(&packed, i, &out);
+        checksum += (unsigned char)out.surnameAttendee[1];
+    }
+    double unpackSeconds = secondsSince(start);
+    char text[MAX_NAME_LENGTH];
+    start = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i < count; i++) {
+        HuffmanBitReader reader = { packed.payload, packed.payloadSize, (size_t)packed.offsets[i] * 8 };
+        for (int field = 0; field < 2; field++) {
+            int symbol;
+            while ((symbol = huffmanDecodeSymbol(&packed.codebook, &reader)) > 0) {
+                checksum += (unsigned)symbol;
+            }
+        }
+    }
+    double serialSeconds = secondsSince(start);
+    start = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i < count; i++) {
+        HuffmanBitReader reader = { packed.payload, packed.payloadSize, (size_t)packed.offsets[i] * 8 };
+        for (int field = 0; field < 2; field++) {
+            huffmanDecodeString(&packed.codebook, &reader, text, sizeof(text));
+            checksum += (unsigned char)text[0];
+        }
+    }
+    double tableSeconds = secondsSince(start);
+    size_t packedBytes = sizeof(packed) + ((size_t)count + 1) * sizeof(uint32_t) + packed.payloadSize;
+
+    remove("benchmark_attendee.bin");
+    start = std::chrono::steady_clock::now();
+    bool saved = saveAttendeeFile("benchmark_attendee.bin", list.data(), count);
+    double saveSeconds = secondsSince(start);
+    FILE* file = fopen("benchmark_attendee.bin", "rb");
+    long fileSize = 0;
+    if (saved && file != NULL) {
+        fseek(file, 0, SEEK_END);
+        fileSize = ftell(file);
+    }
+    if (file != NULL) {
+        fclose(file);
+    }
+    Attendee* loaded = NULL;
+    unsigned loadedCount = 0;
+    start = std::chrono::steady_clock::now();
+    bool read = loadAttendeeFile("benchmark_attendee.bin", &loaded, &loadedCount);
+    double loadSeconds = secondsSince(start);
+    free(loaded);
+    remove("benchmark_attendee.bin");
+
+    printf("attendees,name_bytes,bits_per_char,packed_list_bytes_per_attendee,record_bytes_per_attendee,"
+        "file_bytes_per_attendee,pack_mb_s,unpack_mb_s,serial_decode_mb_s,table_decode_mb_s,save_ms,load_ms,checksum\n");
+    printf("%u,%.1f,%.2f,%.1f,%zu,%.1f,%.0f,%.0f,%.0f,%.0f,%.0f,%.0f,%zu\n", count, (double)textBytes / count,
+        packed.payloadSize * 8.0 / (textBytes + 2.0 * count), (double)packedBytes / count, sizeof(Attendee),
+        saved ? (double)fileSize / count : 0.0, textBytes / packSeconds / 1e6, textBytes / unpackSeconds / 1e6,
+        textBytes / serialSeconds / 1e6, textBytes / tableSeconds / 1e6,
+        saveSeconds * 1e3, read && loadedCount == count ? loadSeconds * 1e3 : -1.0, checksum);
+    freePackedAttendees(&packed);
+    return 0;
+}
+
+/**
+ * @brief Huffman tree construction with the Min Heap and with two queues.
+ *
+ * Arguments: `[names]`. Defaults to 10^6 names of syllables. For each
+ * HuffmanBuildMethod it reports the time per name to count the letters and
+ * build the tree, to build the codes of `buildHuffmanTree`, and to compute the
+ * code lengths of a full 256-byte alphabet as codebook training does.
+ */
+int runHuffmanBuild(int argc, char** argv) {
+    unsigned count = argc > 0 ? (unsigned)strtoul(argv[0], NULL, 10) : 1000000;
+    const char* syllables[] = { "al", "ay", "be", "ce", "de", "ek", "fa", "ha", "ka", "me", "ne", "os", "se", "ya",
+        "zi", "tur", "han", "gul", "can" };
+    const unsigned syllableCount = sizeof(syllables) / sizeof(syllables[0]);
+    std::mt19937 random(29);
+    std::vector<std::string> names(count);
+    for (unsigned i = 0; i < count; i++) {
+        names[i] = std::string(syllables[random() % syllableCount]) + syllables[random() % syllableCount] + " " +
+            syllables[random() % syllableCount] + syllables[random() % syllableCount];
+    }
+    unsigned alphabet[MAX_TREE_NODES];
+    for (int i = 0; i < MAX_TREE_NODES; i++) {
+        alphabet[i] = 1 + random() % 100000;
+    }
+    const unsigned alphabetRounds = count / 100 > 0 ? count / 100 : 1;
+
+    printf("method,names,tree_ns_per_name,codes_ns_per_name,alphabet_us_per_build,checksum\n");
+    for (int method = 0; method < HUFFMAN_BUILD_METHOD_COUNT; method++) {
+        setHuffmanBuildMethod((HuffmanBuildMethod)method);
+        size_t checksum = 0;
+        HuffmanTree tree;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (unsigned i = 0; i < count; i++) {
+            unsigned freq[MAX_TREE_NODES] = { 0 };
+            for (const char* c = names[i].c_str(); *c != '\0'; c++) {
+                freq[(unsigned char)*c]++;
+            }
+            checksum += buildHuffmanTreeNodes(&tree, freq)->left->freq;
+        }
+        double treeSeconds = secondsSince(start);
+        AttendeE attendee;
+        start = std::chrono::steady_clock::now();
+        for (unsigned i = 0; i < count; i++) {
+            attendee.huffmanCode[0] = '\0';
+            buildHuffmanTree(&names[i][0], &attendee);
+            checksum += (unsigned char)attendee.huffmanCode[3];
+        }
+        double codesSeconds = secondsSince(start);
+        unsigned char lengths[HUFFMAN_SYMBOLS];
+        start = std::chrono::steady_clock::now();
+        for (unsigned i = 0; i < alphabetRounds; i++) {
+            alphabet[i % MAX_TREE_NODES]++;
+            huffmanCodeLengths(alphabet, lengths);
+            checksum += lengths[i % MAX_TREE_NODES];
+        }
+        double alphabetSeconds = secondsSince(start);
+        printf("%s,%u,%.0f,%.0f,%.2f,%zu\n", huffmanBuildMethodNames[method], count, treeSeconds * 1e9 / count,
+            codesSeconds * 1e9 / count, alphabetSeconds * 1e6 / alphabetRounds, checksum);
+    }
+    setHuffmanBuildMethod(HUFFMAN_BUILD_TWO_QUEUE);
+    return 0;
+}
+
+/**
+ * @brief Benchmark suites known to the harness.
+ */
+BenchmarkSuite benchmarkSuites[] = {
+    { "hash_distribution", "[corpus] [buckets...]", runHashDistribution },
+    { "startup", "[users...]", runStartup },
+    { "registration", "[existing_users] [registrations]", runRegistration },
+    { "bulk_import", "[users...]", runBulkImport },
+    { "login", "[costs...]", runLogin },
+    { "concurrent_login", "[cost] [threads...]", runConcurrentLogin },
+    { "probe_policies", "[keys...]", runProbePolicies },
+    { "login_trace", "[trace] [users] [logins]", runLoginTrace },
+    { "paged_growth", "[users] [batch]", runPagedGrowth },
+    { "bot_logins", "[users] [attempts]", runBotLogins },
+    { "compaction", "[users] [reregistrations]", runCompaction },
+    { "record_encoding", "[users...]", runRecordEncoding },
+    { "phone_keys", "[users]", runPhoneKeys },
+    { "name_prefix", "[users] [queries]", runNamePrefix },
+    { "export", "[users]", runExport },
+    { "table_metrics", "[users] [lookups]", runTableMetrics },
+    { "attendee_codec", "[attendees]", runAttendeeCodec },
+    { "huffman_build", "[names]", runHuffmanBuild },
+};
+
+int main(int argc, char** argv) {
+    size_t suiteCount = sizeof(benchmarkSuites) / sizeof(benchmarkSuites[0]);
+    if (argc >= 2) {
+        for (size_t i = 0; i < suiteCount; i++) {
+            if (strcmp(argv[1], benchmarkSuites[i].name) == 0) {
+                return benchmarkSuites[i].run(argc - 2, argv + 2);
+            }
+        }
+    }
+
+    fprintf(stderr, "Usage: %s <suite> [arguments]\n", argv[0]);
+    for (size_t i = 0; i < suiteCount; i++) {
+        fprintf(stderr, "  %s %s\n", benchmarkSuites[i].name, benchmarkSuites[i].usage);
+    }
+    return 1;
+}